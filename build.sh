@@ -80,49 +80,111 @@ else
     echo "  Clock.cpp already patched, skipping..."
 fi
 
-echo "Patching WSPRMessageTransmitter.h (add LOW_POWER_SINGLE_CLOCK option)..."
-# Add compile-time option to use single clock output for reduced power consumption.
-# When LOW_POWER_SINGLE_CLOCK is defined, only CLK0 is used (no CLK1 with 180-degree phase shift).
+echo "Patching WSPRMessageTransmitter.h (runtime CLK1 selection)..."
+# CLK1 carries an inverted copy of CLK0 for more output power (dual phase).
+# Whether it is used is decided at runtime, per window, via SetClk1Enabled().
+# LOW_POWER_SINGLE_CLOCK, if defined, only changes the initial setting.
 WSPR_TX_H="${PROJECT_DIR}/ext/picoinf/src/WSPR/WSPRMessageTransmitter.h"
 
 # Only apply patch if not already patched (idempotent)
-if ! grep -q 'LOW_POWER_SINGLE_CLOCK' "${WSPR_TX_H}"; then
+if ! grep -q 'clk1Enabled_' "${WSPR_TX_H}"; then
     echo "  Applying WSPRMessageTransmitter.h patch..."
 
-    # Add documentation comment after the includes
-    sed -i '/#include "WSPREncoder.h"/a\
+    if grep -q '^#ifndef LOW_POWER_SINGLE_CLOCK$' "${WSPR_TX_H}"; then
+        # Submodule has the compile-time option built-in, convert it.
+
+        # RadioOff() always shuts CLK1 off, whatever the current setting
+        sed -i '/^#ifndef LOW_POWER_SINGLE_CLOCK$/{N;/output_enable(SI5351_CLK1, 0);/s/^#ifndef LOW_POWER_SINGLE_CLOCK\n//}' "${WSPR_TX_H}"
+        sed -i '/set_clock_pwr(SI5351_CLK1, 0);/{n;/^#endif$/d}' "${WSPR_TX_H}"
+
+        # RadioOn() and SetDrive() check the setting
+        sed -i 's/^#ifndef LOW_POWER_SINGLE_CLOCK$/        if (clk1Enabled_) {/' "${WSPR_TX_H}"
+        sed -i '/output_enable(SI5351_CLK1, 1);/{n;s/^#endif$/        }/}' "${WSPR_TX_H}"
+        sed -i '/drive_strength(SI5351_CLK1, pwr);/{n;s/^#endif$/        }/}' "${WSPR_TX_H}"
+    else
+        # Upstream form, wrap CLK1 setup in RadioOn() and SetDrive()
+        sed -i '/Fan out and invert the first clock signal/i\
+        if (clk1Enabled_) {' "${WSPR_TX_H}"
+        sed -i '/output_enable(SI5351_CLK1, 1);/a\
+        }' "${WSPR_TX_H}"
+        sed -i '/drive_strength(SI5351_CLK1, pwr);/i\
+        if (clk1Enabled_) {' "${WSPR_TX_H}"
+        sed -i '/drive_strength(SI5351_CLK1, pwr);/a\
+        }' "${WSPR_TX_H}"
+    fi
+
+    # Add the setting, initially on unless built for single clock
+    sed -i '/^class WSPRMessageTransmitter/{n;a\
+public:\
+\
+    // takes effect on the next RadioOn()\
+    void SetClk1Enabled(bool tf) { clk1Enabled_ = tf; }\
+    bool GetClk1Enabled() const  { return clk1Enabled_; }\
+\
+private:\
 \
-// LOW_POWER_SINGLE_CLOCK: When defined, uses only CLK0 (single output)\
-// for reduced power consumption at lower solar angles.\
-// When not defined (default), uses CLK0 + CLK1 with 180-degree phase shift\
-// for maximum output power (dual phase output).\
-//\
-// To enable low power mode, add to CMake: -DLOW_POWER_SINGLE_CLOCK=ON\
-// or uncomment the line below:\
-// #define LOW_POWER_SINGLE_CLOCK' "${WSPR_TX_H}"
-
-    # Wrap CLK1 setup in RadioOn() with #ifndef
-    sed -i '/Fan out and invert the first clock signal/i\
-#ifndef LOW_POWER_SINGLE_CLOCK' "${WSPR_TX_H}"
-    sed -i 's|// 180-degree phase shift on second clock|// 180-degree phase shift on second clock (dual phase output for more power)|' "${WSPR_TX_H}"
-    sed -i '/output_enable(SI5351_CLK1, 1);/a\
-#endif' "${WSPR_TX_H}"
-
-    # Wrap CLK1 disable in RadioOff() with #ifndef
-    sed -i '/output_enable(SI5351_CLK1, 0);/i\
-#ifndef LOW_POWER_SINGLE_CLOCK' "${WSPR_TX_H}"
-    sed -i '/set_clock_pwr(SI5351_CLK1, 0);/a\
-#endif' "${WSPR_TX_H}"
-
-    # Wrap CLK1 drive strength in SetDrive() with #ifndef
-    sed -i '/drive_strength(SI5351_CLK1, pwr);/i\
-#ifndef LOW_POWER_SINGLE_CLOCK' "${WSPR_TX_H}"
-    sed -i '/drive_strength(SI5351_CLK1, pwr);/a\
-#endif' "${WSPR_TX_H}"
+#ifdef LOW_POWER_SINGLE_CLOCK\
+    bool clk1Enabled_ = false;\
+#else\
+    bool clk1Enabled_ = true;\
+#endif\
+\
+public:
+}' "${WSPR_TX_H}"
 else
     echo "  WSPRMessageTransmitter.h already patched, skipping..."
 fi
 
+# SetDrive() also shuts CLK1 off when it isn't enabled, so CLK1 can be
+# dropped mid-transmission (brownout guard) rather than on the next RadioOn().
+if ! grep -q 'output_enable(SI5351_CLK1, 0); // clk1 dropped' "${WSPR_TX_H}"; then
+    echo "  Applying WSPRMessageTransmitter.h SetDrive() patch..."
+
+    sed -i '/drive_strength(SI5351_CLK1, pwr);/{h;n;/^ *}$/{g;s/drive_strength(SI5351_CLK1, pwr);/output_enable(SI5351_CLK1, 0); \/\/ clk1 dropped/;s/^/        } else {\n/;s/$/\n        }/}}' "${WSPR_TX_H}"
+else
+    echo "  WSPRMessageTransmitter.h SetDrive() already patched, skipping..."
+fi
+
+# The patches above are sed edits against source this repo doesn't pin
+# down, and sed succeeds whether or not its pattern matched. Check each
+# expected edit landed, rather than build firmware with a partial patch.
+echo "Verifying patches..."
+PATCH_ERRORS=0
+
+# expect_count <file> <fixed string> <expected count> <description>
+expect_count() {
+    local count
+    count=$(grep -cF -- "$2" "$1" || true)
+    if [ "${count}" != "$3" ]; then
+        echo "  ERROR: $(basename "$1"): $4 (expected $3 of '$2', found ${count})"
+        PATCH_ERRORS=$((PATCH_ERRORS + 1))
+    fi
+}
+
+expect_count "${CLOCK_CPP}" 'struct PllConfig;'                                     0 "forward declaration removed"
+expect_count "${CLOCK_CPP}" 'static unordered_map<double, PllConfig> freq__data;'   1 "map declared once, after PllConfig"
+
+expect_count "${WSPR_TX_H}" '#ifndef LOW_POWER_SINGLE_CLOCK'                         0 "compile-time CLK1 option converted"
+expect_count "${WSPR_TX_H}" 'void SetClk1Enabled(bool tf)'                           1 "setter added"
+expect_count "${WSPR_TX_H}" 'bool GetClk1Enabled() const'                            1 "getter added"
+expect_count "${WSPR_TX_H}" 'if (clk1Enabled_) {'                                    2 "RadioOn() and SetDrive() check the setting"
+expect_count "${WSPR_TX_H}" 'output_enable(SI5351_CLK1, 0); // clk1 dropped'         1 "SetDrive() drops CLK1 when not enabled"
+
+# every block opened by the edits was closed
+OPEN_COUNT=$(grep -o '{' "${WSPR_TX_H}" | wc -l)
+CLOSE_COUNT=$(grep -o '}' "${WSPR_TX_H}" | wc -l)
+if [ "${OPEN_COUNT}" != "${CLOSE_COUNT}" ]; then
+    echo "  ERROR: WSPRMessageTransmitter.h: braces unbalanced (${OPEN_COUNT} open, ${CLOSE_COUNT} close)"
+    PATCH_ERRORS=$((PATCH_ERRORS + 1))
+fi
+
+if [ "${PATCH_ERRORS}" != "0" ]; then
+    echo "ERROR: ${PATCH_ERRORS} patch check(s) failed, picoinf source may have changed"
+    exit 1
+fi
+echo "  All patches verified"
+
+echo ""
 echo "Configuring with CMake..."
 cd "${BUILD_DIR}"
 
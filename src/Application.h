@@ -6,6 +6,9 @@ using namespace std;
 #include "ADCInternal.h"
 #include "Blinker.h"
 #include "JSONMsgRouter.h"
+#include "PowerDeepSleep.h"
+#include "PowerPeripheralGating.h"
+#include "PowerWakeupCoalescer.h"
 #include "SubsystemCopilotControl.h"
 #include "SubsystemGps.h"
 #include "SubsystemTx.h"
@@ -96,16 +99,22 @@ public:
             Log("Watchdog enabled");
             LogNL();
 
-            timerWatchdog_.SetName("TIMER_WATCHDOG_FEED");
-            timerWatchdog_.SetCallback([]{
+            // feed on every coalesced wakeup
+            coalescer_.AddTask("WATCHDOG_FEED", 1, []{
                 Watchdog::Feed();
             });
-            timerWatchdog_.TimeoutIntervalMs(2'000, 0);
         }
 
         // set up blinker
         blinker_.SetPin(pinLedGreen_);
 
+        // idle blinks turn on with the watchdog wakeups rather than
+        // waking the core on their own
+        coalescer_.AddTask("LED_IDLE_BLINK", 1, [this]{
+            OnBlinkerIdleTick();
+        }, false);
+        coalescer_.Start();
+
         // Startup blinks indicate progressively higher power demand
         PowerTest();
 
@@ -224,6 +233,11 @@ public:
 
         ssGps_.EnableConfigurationMode();
 
+        // the window simulator sees the same defaults and warmup as flight,
+        // without installing the callbacks which send
+        SetupSchedulerDefaultBehavior();
+        SetupSchedulerWarmup();
+
         // announce the temperature regularly
         static Timer timerTemp("APP_TEMP_TIMER");
         timerTemp.SetCallback([this]{
@@ -304,6 +318,9 @@ public:
             PAL.Delay(1'500);
             Watchdog::Feed();
 
+            // Only clock peripherals while something needs them
+            PowerPeripheralGating::Start();
+
             // Set up copilot control scheduler
             SetupScheduler();
         }
@@ -317,9 +334,13 @@ public:
     void SetupScheduler()
     {
         SetupSchedulerGps();
+        SetupSchedulerDefaultBehavior();
         SetupSchedulerMessageSending();
         SetupSchedulerRadio();
+        SetupSchedulerWarmup();
+        SetupSchedulerVoltage();
         SetupSchedulerClockSpeed();
+        SetupSchedulerDeepSleep();
         SetupSchedulerWsprMinute();
 
         ssCc_.GetScheduler().Start();
@@ -355,12 +376,7 @@ public:
             {
                 ssGps_.DisableVerboseLogging();
             }
-            ssGps_.EnableFlightMode();
-            t_.Event("GpsEnabled");
-
             // Request new fix
-            Log("Requesting FixTime and Fix3DPlus");
-            
             auto FnOnFixTime = [this, &scheduler](const FixTime &fixTime){
                 t_.Event("FixTime");
 
@@ -377,6 +393,9 @@ public:
                 // cancel timer
                 CancelGpsLockOrDieTimer();
 
+                // gps evidently healthy
+                recoveryCount_ = 0;
+
                 // capture fix
                 fix3dPlus_ = fix3dPlus;
 
@@ -387,8 +406,15 @@ public:
                 scheduler.OnGps3DPlusLock(fix3dPlus_);
             };
 
-            ssGps_.RequestNewFixTimeAnd3DPlus(FnOnFixTime, FnOnFix3DPlus);
-            t_.Event("FixRequested");
+            // Power up and configure without holding up the event loop,
+            // the fix is requested once the module is ready to talk
+            ssGps_.EnableFlightModeAsync([this, FnOnFixTime, FnOnFix3DPlus]{
+                t_.Event("GpsEnabled");
+
+                Log("Requesting FixTime and Fix3DPlus");
+                ssGps_.RequestNewFixTimeAnd3DPlus(FnOnFixTime, FnOnFix3DPlus);
+                t_.Event("FixRequested");
+            });
 
             // Setup timer to ensure we don't wait forever
             StartGpsLockOrDieTimer();
@@ -397,8 +423,12 @@ public:
         scheduler.SetCallbackCancelRequestNewGpsLock([this]{
             t_.Event("CancelReqNewGpsLock");
 
-            // consider whether too much coasting
-            MaybeDieIfTooMuchCoasting();
+            // the gps is being recovered, and is shut off once done
+            if (recoveryInProgress_) { return; }
+
+            // consider whether too much coasting, the gps is being
+            // recovered if so, and must be left alone to finish
+            if (MaybeRecoverIfTooMuchCoasting()) { return; }
 
             // indicate idle state
             BlinkerIdle();
@@ -408,22 +438,56 @@ public:
         });
     }
 
+    // The default message each slot sends, if any, with or without a gps
+    // lock. Given to the scheduler for each window in flight, and to the
+    // window simulator as-is.
+    CopilotControlScheduler::DefaultBehaviorList MakeSchedulerDefaultBehaviorList(bool haveGpsLock)
+    {
+        CopilotControlScheduler::DefaultBehaviorList retVal(5);
+
+        if (haveGpsLock)
+        {
+            retVal[0] = { true, true, [this](uint8_t, uint64_t){ SendRegularType1();   } };
+            retVal[1] = { true, true, [this](uint8_t, uint64_t){ SendBasicTelemetry(); } };
+        }
+        else
+        {
+            retVal[0] = { true, false, [this](uint8_t, uint64_t){ SendVendorDefinedGpsData(); } };
+        }
+
+        return retVal;
+    }
+
+    void SetupSchedulerDefaultBehavior()
+    {
+        auto &scheduler = ssCc_.GetScheduler();
+
+        scheduler.SetCallbackGetDefaultBehaviorList([this](bool haveGpsLock){
+            return MakeSchedulerDefaultBehaviorList(haveGpsLock);
+        });
+    }
+
     void SetupSchedulerMessageSending()
     {
         auto &scheduler = ssCc_.GetScheduler();
 
         scheduler.SetCallbackScheduleNow([this, &scheduler](bool haveGpsLock){
-            scheduler.UnSetCallbackSendDefault(1);
-            scheduler.UnSetCallbackSendDefault(2);
-            
-            if (haveGpsLock)
-            {
-                scheduler.SetCallbackSendDefault(1, true, [this](uint8_t, uint64_t){ SendRegularType1();   });
-                scheduler.SetCallbackSendDefault(2, true, [this](uint8_t, uint64_t){ SendBasicTelemetry(); });
-            }
-            else
+            // new window, tx clock output chosen again at its warmup
+            clk1ChosenForWindow_ = false;
+
+            auto defaultBehaviorList = MakeSchedulerDefaultBehaviorList(haveGpsLock);
+            for (uint8_t slot = 1; slot <= defaultBehaviorList.size(); ++slot)
             {
-                scheduler.SetCallbackSendDefault(1, false, [this](uint8_t, uint64_t){ SendVendorDefinedGpsData(); });
+                const auto &db = defaultBehaviorList[slot - 1];
+
+                if (db.set)
+                {
+                    scheduler.SetCallbackSendDefault(slot, db.needsGps, db.fn);
+                }
+                else
+                {
+                    scheduler.UnSetCallbackSendDefault(slot);
+                }
             }
         });
 
@@ -442,6 +506,7 @@ public:
 
         scheduler.SetCallbackStartRadioWarmup([this]{
             ssTx_.Enable();
+            ChooseClk1ForWindow();
             ssTx_.RadioOn();
             ssTx_.SetupTransmitterForFlight();
 
@@ -454,6 +519,57 @@ public:
         });
     }
 
+    // The radio is warmed up again around each slot's javascript, so only
+    // the first warmup of a window decides.
+    void ChooseClk1ForWindow()
+    {
+        if (clk1ChosenForWindow_) { return; }
+        clk1ChosenForWindow_ = true;
+
+        uint16_t mv = 0;
+        PowerPeripheralGating::WhileInUse(PowerPeripheralGating::Use::SAMPLING, [&]{
+            mv = (uint16_t)ADC::GetMilliVoltsVCC();
+        });
+
+        bool posValid = fix3dPlus_.latDegMillionths != 0 || fix3dPlus_.lngDegMillionths != 0;
+
+        ssTx_.ConfigureClk1ForWindow(mv,
+                                     posValid,
+                                     fix3dPlus_.latDegMillionths / 1'000'000.0,
+                                     fix3dPlus_.lngDegMillionths / 1'000'000.0,
+                                     Time::GetNotionalUsAtSystemUs(PAL.Micros()));
+    }
+
+    void SetupSchedulerWarmup()
+    {
+        auto &scheduler = ssCc_.GetScheduler();
+
+        scheduler.SetCallbackGetWarmupDurationUs([this](uint64_t timeAtWarmupStartUs){
+            int16_t tempC = 0;
+
+            PowerPeripheralGating::WhileInUse(PowerPeripheralGating::Use::SAMPLING, [&]{
+                tempC = (int16_t)round(tempSensor_.GetTempC());
+            });
+
+            return ssTx_.GetWarmupTable().GetWarmupDurationUs(tempC, PAL.Micros(), timeAtWarmupStartUs);
+        });
+    }
+
+    void SetupSchedulerVoltage()
+    {
+        auto &scheduler = ssCc_.GetScheduler();
+
+        scheduler.SetCallbackGetMilliVoltsVcc([]{
+            uint16_t mv = 0;
+
+            PowerPeripheralGating::WhileInUse(PowerPeripheralGating::Use::SAMPLING, [&]{
+                mv = (uint16_t)ADC::GetMilliVoltsVCC();
+            });
+
+            return mv;
+        });
+    }
+
     void SetupSchedulerClockSpeed()
     {
         // Ignoring LED blinks, GPS, TX, etc, the following are the
@@ -488,6 +604,20 @@ public:
         });
     }
 
+    void SetupSchedulerDeepSleep()
+    {
+        // Deep sleep drops the baseline from ~4.7 mA (6 MHz run loop) to
+        // the crystal, RTC and regulator quiescent current.
+        //
+        // The scheduler decides when, only gps-off gaps long enough to be
+        // worth the enter/exit cost.
+        auto &scheduler = ssCc_.GetScheduler();
+
+        scheduler.SetCallbackDeepSleepUntil([this](uint64_t timeAtWakeUs){
+            deepSleep_.SleepUntilUs(timeAtWakeUs);
+        });
+    }
+
     void SetupSchedulerWsprMinute()
     {
         auto &scheduler = ssCc_.GetScheduler();
@@ -520,10 +650,15 @@ public:
 
         string   grid56    = fix3dPlus_.maidenheadGrid.substr(4, 2);
         uint32_t altM      = fix3dPlus_.altitudeM < 0 ? 0 : fix3dPlus_.altitudeM;
-        int8_t   tempC     = tempSensor_.GetTempC();
-        double   voltage   = (double)ADC::GetMilliVoltsVCC() / 1'000;  // capture under max load
+        int8_t   tempC     = 0;
+        double   voltage   = 0;
         bool     gpsValid  = true;
 
+        PowerPeripheralGating::WhileInUse(PowerPeripheralGating::Use::SAMPLING, [&]{
+            tempC   = tempSensor_.GetTempC();
+            voltage = (double)ADC::GetMilliVoltsVCC() / 1'000;  // capture under max load
+        });
+
         ssTx_.SendTelemetryBasic(
             cd.id13,
             grid56,
@@ -630,10 +765,87 @@ public:
             LogNL();
             Log("No GPS Lock within ", Time::MakeTimeMMSSmmmFromUs(TWENTY_MINUTES));
 
-            // hard reset GPS
-            Log("Hard Resetting GPS");
-            ssGps_.ModuleHardReset();
+            RecoverInPlaceOrDie();
+        });
+        timerGpsLockOrDie_.TimeoutInMs(TWENTY_MINUTES);
+    }
 
+    void CancelGpsLockOrDieTimer()
+    {
+        timerGpsLockOrDie_.Cancel();
+    }
+
+    // Recover from a misbehaving gps without a reboot, which would repeat
+    // the power test, re-register everything, and lose time sync.
+    //
+    // The gps is hard reset, then the scheduler restarted in place, keeping
+    // its time sync and ability to coast.
+    //
+    // Rebooting remains the last resort, once in-place recovery has been
+    // tried enough times without a 3d fix resulting.
+    void RecoverInPlaceOrDie()
+    {
+        if (recoveryInProgress_) { return; }
+
+        // too low on power to run the gps, recovering it would only turn it
+        // back on. leave it off, the scheduler asks for it again once power
+        // allows, and recovery is tried again if that request coasts too.
+        if (ssCc_.GetScheduler().GpsMayBeRequested() == false)
+        {
+            Log("GPS recovery deferred, too low on power to run the GPS");
+
+            CancelGpsLockOrDieTimer();
+            ssGps_.Disable();
+            BlinkerIdle();
+
+            return;
+        }
+
+        if (recoveryCount_ >= RECOVERY_COUNT_MAX)
+        {
+            Log("In-place recovery tried ", recoveryCount_, " times without a 3D fix");
+
+            HardResetGpsThenDie();
+
+            return;
+        }
+
+        ++recoveryCount_;
+        recoveryInProgress_ = true;
+
+        Log("Recovering in place (", recoveryCount_, " of ", RECOVERY_COUNT_MAX, ")");
+        t_.Event("RecoverInPlace");
+
+        CancelGpsLockOrDieTimer();
+
+        uint64_t timeStart = PAL.Millis();
+
+        Log("Hard Resetting GPS");
+        ssGps_.ModuleHardResetAsync([this, timeStart]{
+            recoveryInProgress_ = false;
+
+            // back to a clean slate, coasting limits start over
+            ssGps_.Disable();
+            BlinkerIdle();
+            coastCount_   = 0;
+            gotFix3dPlus_ = false;
+
+            ssCc_.GetScheduler().RestartInPlace();
+
+            Log("Recovered in place in ", Time::MakeTimeMMSSmmmFromMs(PAL.Millis() - timeStart));
+            t_.Event("Recovered");
+        });
+    }
+
+    void HardResetGpsThenDie()
+    {
+        // nothing else gets to touch the gps from here on
+        ssCc_.GetScheduler().Stop();
+
+        // hard reset GPS, the event loop keeps the watchdog fed while the
+        // module is held off
+        Log("Hard Resetting GPS");
+        ssGps_.ModuleHardResetAsync([this]{
             // reboot via watchdog kill
             Log("Rebooting via Watchdog death");
             while (true)
@@ -641,15 +853,9 @@ public:
                 BlinkerBlinkOncePanic();
             }
         });
-        timerGpsLockOrDie_.TimeoutInMs(TWENTY_MINUTES);
-    }
-
-    void CancelGpsLockOrDieTimer()
-    {
-        timerGpsLockOrDie_.Cancel();
     }
 
-    void MaybeDieIfTooMuchCoasting()
+    bool MaybeRecoverIfTooMuchCoasting()
     {
         // The strategy around GPS locking has two limits:
         // - Any attempt at a lock can take no more than the max timeout
@@ -683,17 +889,10 @@ public:
             LogNL();
             Log("Coast attempt exceeds limit (", coastCount_, " would exceed max of ", COAST_COUNT_MAX, " consecutive)");
 
-            // hard reset GPS
-            Log("Hard Resetting GPS");
-            ssGps_.ModuleHardReset();
-
-            // reboot via watchdog kill
-            Log("Rebooting via Watchdog death");
-            while (true)
-            {
-                BlinkerBlinkOncePanic();
-            }
+            RecoverInPlaceOrDie();
         }
+
+        return coastCount_ > COAST_COUNT_MAX;
     }
 
 
@@ -703,16 +902,50 @@ public:
 
     inline static const uint32_t WSPR_BIT_DURATION_MS = 683;
 
-    // once every 5 seconds
+    // idle blinks are driven by the wakeup coalescer
+    inline static const uint32_t COALESCER_TICK_MS        = 2'000;
+    inline static const uint32_t BLINK_IDLE_EVERY_N_TICKS = 3;
+    inline static const uint32_t BLINK_IDLE_ON_MS         = 75;
+
+    uint32_t blinkIdleTickCount_ = 0;
+    Timer    timerBlinkIdleOff_  = {"TIMER_BLINK_IDLE_OFF"};
+
+    // 75ms once every 6 seconds, turned on by the watchdog wakeup
     void BlinkerIdle()
     {
-        blinker_.SetBlinkOnOffTime(75, 4925);
-        blinker_.EnableAsyncBlink();
+        blinker_.DisableAsyncBlink();
+        blinker_.Off();
+        blinkIdleTickCount_ = 0;
+        coalescer_.SetTaskEnabled("LED_IDLE_BLINK", true);
+    }
+
+    // the on edge shares a tick which is already awake, the off edge is
+    // a one-shot timer rather than a wait, so the led is only lit briefly
+    void OnBlinkerIdleTick()
+    {
+        if (blinkIdleTickCount_ % BLINK_IDLE_EVERY_N_TICKS == 0)
+        {
+            blinker_.On();
+
+            timerBlinkIdleOff_.SetCallback([this]{
+                blinker_.Off();
+            });
+            timerBlinkIdleOff_.TimeoutInMs(BLINK_IDLE_ON_MS);
+        }
+
+        ++blinkIdleTickCount_;
+    }
+
+    void BlinkerIdleStop()
+    {
+        coalescer_.SetTaskEnabled("LED_IDLE_BLINK", false);
+        timerBlinkIdleOff_.Cancel();
     }
 
     // once every 1 seconds
     void BlinkerGpsSearch()
     {
+        BlinkerIdleStop();
         blinker_.SetBlinkOnOffTime(75, 925);
         blinker_.EnableAsyncBlink();
     }
@@ -721,6 +954,7 @@ public:
     // also operated by hand, but also run during radio warmup
     void BlinkerTransmit()
     {
+        BlinkerIdleStop();
         blinker_.SetBlinkOnOffTime(WSPR_BIT_DURATION_MS, WSPR_BIT_DURATION_MS);
         blinker_.EnableAsyncBlink();
     }
@@ -825,6 +1059,8 @@ private:
 
     void SetupShell()
     {
+        PowerPeripheralGating::SetupShell();
+
         Shell::AddCommand("app.test.led.green.on", [this](vector<string> argList){
             pinLedGreen_.DigitalWrite(1);
         }, { .argCount = 0, .help = ""});
@@ -834,23 +1070,14 @@ private:
         }, { .argCount = 0, .help = ""});
 
 
-        static uint32_t count = 0;
-        static bool show = false;
-        UartAddLineStreamCallback(UART::UART_1, [](const string &line){
-            UartTarget target(UART::UART_0);
-            if (show)
-            {
-                Log(line);
-            }
-            ++count;
-        });
-
+        // counting and echo are done by the gps subsystem, which already
+        // sees every line, rather than by another per-line callback
         Shell::AddCommand("app.count", [this](vector<string> argList){
-            Log(count);
+            Log(ssGps_.GetNmeaLineCount());
         }, { .argCount = 0, .help = ""});
 
         Shell::AddCommand("app.show", [this](vector<string> argList){
-            show = !show;
+            ssGps_.SetNmeaEcho(!ssGps_.GetNmeaEcho());
         }, { .argCount = 0, .help = ""});
     }
 
@@ -894,12 +1121,21 @@ private:
     bool gotFix3dPlus_ = false;
     uint8_t coastCount_ = 0;
 
+    bool clk1ChosenForWindow_ = false;
+
+    // consecutive in-place recoveries without a 3d fix before rebooting
+    inline static const uint8_t RECOVERY_COUNT_MAX = 3;
+    uint8_t recoveryCount_      = 0;
+    bool    recoveryInProgress_ = false;
+
     JSONMsgRouter::Iface router_;
 
     Timer timerStartupRole_;
-    Timer timerWatchdog_;
     Timer timerGpsLockOrDie_;
 
+    PowerWakeupCoalescer coalescer_ = { COALESCER_TICK_MS };
+    PowerDeepSleep       deepSleep_;
+
     Blinker blinker_;
 
     using MsgVD = WsprMessageTelemetryExtendedVendorDefined<29>;
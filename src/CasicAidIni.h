@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+using namespace std;
+
+
+// Builds the CASIC AID-INI frame, which hands a GPS module a position and
+// time to start its search from.
+//
+// Kept free of hardware so the layout, time conversion and checksum can be
+// checked on the host (see test/CasicAidIniTest.cpp).
+class CasicAidIni
+{
+public:
+
+    struct Input
+    {
+        bool     posValid  = false;
+        double   latDeg    = 0;
+        double   lngDeg    = 0;
+        double   altM      = 0;
+        float    pAccM     = 0;
+        bool     timeValid = false;
+        uint64_t unixUs    = 0;
+        float    tAccSec   = 0;
+    };
+
+    struct WeekTow
+    {
+        uint16_t week = 0;
+        double   tow  = 0;
+    };
+
+    // unix time -> gps time, which doesn't observe leap seconds
+    static WeekTow GetWeekTow(uint64_t unixUs)
+    {
+        double   gpsSec = (double)unixUs / 1'000'000.0 - GPS_EPOCH_UNIX_SEC + GPS_LEAP_SEC;
+        uint16_t week   = (uint16_t)(gpsSec / SEC_PER_WEEK);
+
+        return {
+            .week = week,
+            .tow  = gpsSec - (double)week * SEC_PER_WEEK,
+        };
+    }
+
+    static vector<uint8_t> MakePayload(const Input &in)
+    {
+        WeekTow wt;
+        if (in.timeValid)
+        {
+            wt = GetWeekTow(in.unixUs);
+        }
+
+        uint8_t flags = FLAG_POS_LLA;
+        if (in.posValid)  { flags |= FLAG_POS_VALID;  }
+        if (in.timeValid) { flags |= FLAG_TIME_VALID; }
+
+        vector<uint8_t> payload;
+        payload.reserve(PAYLOAD_LEN);
+        Put<double>  (payload, in.latDeg);
+        Put<double>  (payload, in.lngDeg);
+        Put<double>  (payload, in.altM);
+        Put<double>  (payload, wt.tow);
+        Put<float>   (payload, 0);              // freq bias
+        Put<float>   (payload, in.pAccM);
+        Put<float>   (payload, in.tAccSec);
+        Put<float>   (payload, 0);              // freq accuracy
+        Put<uint32_t>(payload, 0);              // reserved
+        Put<uint16_t>(payload, wt.week);
+        Put<uint8_t> (payload, 0);              // timer source
+        Put<uint8_t> (payload, flags);
+
+        return payload;
+    }
+
+    static vector<uint8_t> MakeFrame(const Input &in)
+    {
+        return MakeCasicFrame(CLASS_AID, ID_AID_INI, MakePayload(in));
+    }
+
+    // 0xBA 0xCE, len(2), class(1), id(1), payload(len), checksum(4)
+    static vector<uint8_t> MakeCasicFrame(uint8_t cls, uint8_t id, const vector<uint8_t> &payload)
+    {
+        uint16_t len = (uint16_t)payload.size();
+
+        // checksum sums the payload as 32-bit words, payload is always a
+        // multiple of 4 bytes long
+        uint32_t ckSum = ((uint32_t)id << 24) + ((uint32_t)cls << 16) + len;
+        for (size_t i = 0; i + 3 < payload.size(); i += 4)
+        {
+            uint32_t word;
+            memcpy(&word, &payload[i], 4);
+
+            ckSum += word;
+        }
+
+        vector<uint8_t> frame;
+        frame.reserve(6 + len + 4);
+        Put<uint8_t> (frame, 0xBA);
+        Put<uint8_t> (frame, 0xCE);
+        Put<uint16_t>(frame, len);
+        Put<uint8_t> (frame, cls);
+        Put<uint8_t> (frame, id);
+        frame.insert(frame.end(), payload.begin(), payload.end());
+        Put<uint32_t>(frame, ckSum);
+
+        return frame;
+    }
+
+
+public:
+
+    inline static const uint8_t CLASS_AID  = 0x0B;
+    inline static const uint8_t ID_AID_INI = 0x01;
+
+    inline static const uint8_t FLAG_POS_VALID  = 0x01;
+    inline static const uint8_t FLAG_TIME_VALID = 0x02;
+    inline static const uint8_t FLAG_POS_LLA    = 0x20;
+
+    inline static const uint16_t PAYLOAD_LEN = 56;
+
+
+private:
+
+    template <typename T>
+    static void Put(vector<uint8_t> &buf, T val)
+    {
+        size_t offset = buf.size();
+        buf.resize(offset + sizeof(T));
+
+        memcpy(&buf[offset], &val, sizeof(T));  // little endian, as is the module
+    }
+
+    // 1980-01-06T00:00:00Z
+    inline static const double GPS_EPOCH_UNIX_SEC = 315'964'800;
+    inline static const double GPS_LEAP_SEC       = 18;
+    inline static const double SEC_PER_WEEK       = 604'800;
+};
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <string>
 using namespace std;
 
+#include "FilesystemLittleFS.h"
 #include "Flashable.h"
 #include "JSONMsgRouter.h"
 #include "WsprEncodedDynamic.h"
@@ -14,6 +15,14 @@ class Configuration
 private:
     inline static const string DEFAULT_BAND = "20m";
 
+    // built for single clock only changes the default
+#ifdef LOW_POWER_SINGLE_CLOCK
+    inline static const string DEFAULT_CLK1_MODE = "single";
+#else
+    inline static const string DEFAULT_CLK1_MODE = "dual";
+#endif
+    inline static const char *FILE_NAME_CLK1 = "tx.clk1";
+
     struct ConfigurationFlashState
     {
         array<char, 5 + 1> bandStorage;
@@ -37,6 +46,10 @@ private:
 
         flashState_.correction = 0;
         correction = 0;
+
+        clk1Mode          = DEFAULT_CLK1_MODE;
+        clk1AutoMinMv     = 0;
+        clk1AutoMinSunDeg = 20;
     }
 
 public:
@@ -94,16 +107,80 @@ public:
     }
 
 
+    /////////////////////////////////////////////////////////////////
+    // TX CLK1
+    /////////////////////////////////////////////////////////////////
+
+    // Whether the transmitter fans out an inverted copy of its output on
+    // CLK1 for more power:
+    // - dual   : always
+    // - single : never
+    // - auto   : per window, when VCC and the sun are both high enough
+    //
+    // Kept in a file rather than the flash state so the layout of saved
+    // configuration doesn't change. Read on use, like the flash state.
+    static bool Clk1ModeIsValid(const string &mode)
+    {
+        return mode == "auto" || mode == "dual" || mode == "single";
+    }
+
+    bool GetClk1()
+    {
+        // mode,minMv,minSunDeg
+        vector<string> partList = Split(FilesystemLittleFS::Read(FILE_NAME_CLK1), ",");
+
+        bool retVal = partList.size() == 3 && Clk1ModeIsValid(partList[0]);
+        if (retVal)
+        {
+            clk1Mode          = partList[0];
+            clk1AutoMinMv     = (uint16_t)atoi(partList[1].c_str());
+            clk1AutoMinSunDeg = (int8_t)atoi(partList[2].c_str());
+        }
+
+        return retVal;
+    }
+
+    bool PutClk1()
+    {
+        return FilesystemLittleFS::Write(FILE_NAME_CLK1,
+                                         clk1Mode                    + "," +
+                                         to_string(clk1AutoMinMv)    + "," +
+                                         to_string(clk1AutoMinSunDeg));
+    }
+
+
 private:
 
     void SetupShell()
     {
         Shell::AddCommand("app.cfg.del", [this](vector<string> argList){
             flashState_.Delete();
+            FilesystemLittleFS::Remove(FILE_NAME_CLK1);
             Reset();
 
             Log("Configuration Deleted, state reset");
         }, { .argCount = 0, .help = "delete config"});
+
+        Shell::AddCommand("app.cfg.clk1", [this](vector<string> argList){
+            GetClk1();
+
+            if (argList.size() >= 1)
+            {
+                if (Clk1ModeIsValid(argList[0]) == false)
+                {
+                    Log("Invalid mode - auto, dual, or single");
+                    return;
+                }
+
+                clk1Mode = argList[0];
+                if (argList.size() >= 2) { clk1AutoMinMv     = (uint16_t)atoi(argList[1].c_str()); }
+                if (argList.size() >= 3) { clk1AutoMinSunDeg = (int8_t)atoi(argList[2].c_str());   }
+
+                PutClk1();
+            }
+
+            Log("CLK1 mode: ", clk1Mode, " (auto needs ", clk1AutoMinMv, " mV, sun ", clk1AutoMinSunDeg, " deg)");
+        }, { .argCount = -1, .help = "tx clk1 [<auto/dual/single>] [autoMinMv] [autoMinSunDeg]"});
     }
 
     void SetupJSON()
@@ -180,6 +257,36 @@ private:
             out["ok"] = ok;
             out["err"] = err;
         });
+
+        JSONMsgRouter::RegisterHandler("REQ_GET_TX_CLK1", [this](auto &in, auto &out){
+            out["type"] = "REP_GET_TX_CLK1";
+
+            GetClk1();
+
+            out["mode"]          = clk1Mode;
+            out["autoMinMv"]     = clk1AutoMinMv;
+            out["autoMinSunDeg"] = clk1AutoMinSunDeg;
+        });
+
+        JSONMsgRouter::RegisterHandler("REQ_SET_TX_CLK1", [this](auto &in, auto &out){
+            out["type"] = "REP_SET_TX_CLK1";
+
+            string modeIn = (const char *)in["mode"];
+
+            bool ok = Clk1ModeIsValid(modeIn);
+            if (ok)
+            {
+                clk1Mode          = modeIn;
+                clk1AutoMinMv     = (uint16_t)in["autoMinMv"];
+                clk1AutoMinSunDeg = (int8_t)in["autoMinSunDeg"];
+
+                ok = PutClk1();
+            }
+
+            Log("REQ_SET_TX_CLK1: ", modeIn, ", ", clk1AutoMinMv, ", ", clk1AutoMinSunDeg, ", OK: ", ok);
+
+            out["ok"] = ok;
+        });
     }
 
 public:
@@ -188,6 +295,10 @@ public:
     uint16_t channel;
     string   callsign;
     int32_t correction;
+
+    string   clk1Mode;
+    uint16_t clk1AutoMinMv;
+    int8_t   clk1AutoMinSunDeg;
 };
 
 inline void LogNNL(const Configuration &c)
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "JSONMsgRouter.h"
+#include "Log.h"
+#include "Shell.h"
+#include "TimeClass.h"
+#include "Utl.h"
+
+#include <string>
+#include <vector>
+using namespace std;
+
+
+// Accounts for the radio being turned off across idle periods inside a
+// window, and the re-warmup paid to turn it back on in time.
+//
+// The energy saved is an estimate, the radio-on current is not measured
+// but taken from the configured figure.
+class CopilotControlEnergy
+{
+public:
+
+    CopilotControlEnergy()
+    {
+        SetupShell();
+        SetupJSON();
+    }
+
+    void OnWindowStart()
+    {
+        windowGapCount_   = 0;
+        windowRadioOffUs_ = 0;
+        windowRewarmupUs_ = 0;
+    }
+
+    void OnRadioOff(uint64_t timeNowUs)
+    {
+        timeAtRadioOffUs_ = timeNowUs;
+
+        ++windowGapCount_;
+        ++gapCount_;
+    }
+
+    void OnRewarmup(uint64_t timeNowUs, uint64_t durationRewarmupUs)
+    {
+        uint64_t durationOffUs = timeAtRadioOffUs_ ? timeNowUs - timeAtRadioOffUs_ : 0;
+        timeAtRadioOffUs_ = 0;
+
+        windowRadioOffUs_ += durationOffUs;
+        windowRewarmupUs_ += durationRewarmupUs;
+        radioOffUs_       += durationOffUs;
+        rewarmupUs_       += durationRewarmupUs;
+    }
+
+    // the gap ended without a re-warmup (eg window ended early)
+    void OnGapAbandoned(uint64_t timeNowUs)
+    {
+        if (timeAtRadioOffUs_)
+        {
+            OnRewarmup(timeNowUs, 0);
+        }
+    }
+
+    uint16_t GetRadioOnMa()
+    {
+        return radioOnMa_;
+    }
+
+    uint32_t GetWindowGapCount()
+    {
+        return windowGapCount_;
+    }
+
+    uint32_t GetSavedMilliAmpSec(uint64_t durationOffUs)
+    {
+        return (uint32_t)(durationOffUs / 1'000'000 * radioOnMa_);
+    }
+
+    void Report()
+    {
+        Log("Radio Idle Gap Energy");
+        Log("- radio on current : ", radioOnMa_, " mA (estimate)");
+        Log("- last window      : ", windowGapCount_, " gaps, ",
+                                     Time::MakeDurationFromUs(windowRadioOffUs_), " off, ",
+                                     Time::MakeDurationFromUs(windowRewarmupUs_), " re-warmup, ",
+                                     Commas(GetSavedMilliAmpSec(windowRadioOffUs_)), " mAs saved");
+        Log("- total            : ", Commas(gapCount_), " gaps, ",
+                                     Time::MakeDurationFromUs(radioOffUs_), " off, ",
+                                     Time::MakeDurationFromUs(rewarmupUs_), " re-warmup, ",
+                                     Commas(GetSavedMilliAmpSec(radioOffUs_)), " mAs saved");
+    }
+
+
+private:
+
+    void SetupShell()
+    {
+        Shell::AddCommand("app.ss.cc.energy", [this](vector<string> argList){
+            Report();
+        }, { .argCount = 0, .help = "report radio idle gap energy"});
+
+        Shell::AddCommand("app.ss.cc.energy.ma", [this](vector<string> argList){
+            radioOnMa_ = (uint16_t)atoi(argList[0].c_str());
+
+            Report();
+        }, { .argCount = 1, .help = "set radio on current <mA> for estimates (until reboot)"});
+    }
+
+    void SetupJSON()
+    {
+        JSONMsgRouter::RegisterHandler("REQ_GET_RADIO_ENERGY", [this](auto &in, auto &out){
+            out["type"] = "REP_GET_RADIO_ENERGY";
+
+            out["radioOnMa"] = radioOnMa_;
+
+            out["windowGapCount"]   = windowGapCount_;
+            out["windowRadioOffMs"] = windowRadioOffUs_ / 1'000;
+            out["windowRewarmupMs"] = windowRewarmupUs_ / 1'000;
+            out["windowSavedMAs"]   = GetSavedMilliAmpSec(windowRadioOffUs_);
+
+            out["gapCount"]   = gapCount_;
+            out["radioOffMs"] = radioOffUs_ / 1'000;
+            out["rewarmupMs"] = rewarmupUs_ / 1'000;
+            out["savedMAs"]   = GetSavedMilliAmpSec(radioOffUs_);
+        });
+    }
+
+
+private:
+
+    // clockgen running, outputs enabled, no keying
+    uint16_t radioOnMa_ = 25;
+
+    uint64_t timeAtRadioOffUs_ = 0;
+
+    uint32_t windowGapCount_   = 0;
+    uint64_t windowRadioOffUs_ = 0;
+    uint64_t windowRewarmupUs_ = 0;
+
+    uint32_t gapCount_   = 0;
+    uint64_t radioOffUs_ = 0;
+    uint64_t rewarmupUs_ = 0;
+};
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "CopilotControlConfiguration.h"
 #include "CopilotControlMessageDefinition.h"
+#include "CopilotControlScriptScan.h"
 #include "CopilotControlUtl.h"
 #include "JerryScriptIntegration.h"
 #include "JSFn_DelayMs.h"
@@ -17,6 +18,7 @@
 #include "JSProxy_GPS.h"
 #include "JSProxy_WsprMessageTelemetryExtendedUserDefined.h"
 #include "Log.h"
+#include "PowerPeripheralGating.h"
 #include "Shell.h"
 #include "TempSensorInternal.h"
 #include "Utl.h"
@@ -136,6 +138,7 @@ private:
 
         bool     runOk       = false;
         string   runErr      = "[Did not run]";
+        uint64_t runLimitMs  = 0;
         uint64_t runMs       = 0;
         uint64_t runDelayMs  = 0;
         uint32_t runMemAvail = 0;
@@ -154,49 +157,54 @@ private:
     }
 
 public:
-    JavaScriptRunResult RunSlotJavaScript(const string &slotName, Fix3DPlus *gpsFix = nullptr)
+    JavaScriptRunResult RunSlotJavaScript(const string &slotName, Fix3DPlus *gpsFix = nullptr, uint64_t timeLimitMs = SCRIPT_TIME_LIMIT_MS)
     {
         MsgUD  &msg    = CopilotControlMessageDefinition::GetMsgResetAndConfigureBySlotName(slotName);
         string  script = CopilotControlConfiguration::GetJavaScript(slotName);
 
-        return RunJavaScript(script, msg, gpsFix);
+        return RunJavaScript(script, msg, gpsFix, timeLimitMs);
     }
 private:
 
-    JavaScriptRunResult RunJavaScript(const string &script, MsgUD &msg, Fix3DPlus *gpsFix = nullptr)
+    JavaScriptRunResult RunJavaScript(const string &script, MsgUD &msg, Fix3DPlus *gpsFix = nullptr, uint64_t timeLimitMs = SCRIPT_TIME_LIMIT_MS)
     {
         JavaScriptRunResult retVal;
+        retVal.runLimitMs = timeLimitMs;
 
-        Log("Running script");
-        JerryScript::UseVM([&]{
-            // parse to detect errors
-            retVal.parseErr = JerryScript::ParseScript(script);
-            retVal.parseOk  = retVal.parseErr == "";
-            retVal.parseMs  = JerryScript::GetScriptParseDurationMs();
+        Log("Running script (limit ", timeLimitMs, " ms)");
 
-            if (retVal.parseOk)
-            {
-                // reset message values to default
-                msg.Reset();
-
-                // load javascript integrations
-                LoadJavaScriptBindings(msg, gpsFix);
-
-                // set maximum execution time
-                JSFn_DelayMs::SetTotalDurationLimitMs(SCRIPT_TIME_LIMIT_MS);
-                JSFn_DelayMs::StartTimeNow();
-
-                // run it
-                retVal.runErr = JerryScript::ParseAndRunScript(script, SCRIPT_TIME_LIMIT_MS);
-
-                // capture result of run
-                retVal.runOk      = retVal.runErr == "";
-                retVal.runMs      = JerryScript::GetScriptRunDurationMs();
-                retVal.runDelayMs = JSFn_DelayMs::GetTotalDelayTimeMs();
-                retVal.runOutput  = JerryScript::GetScriptOutput();
-
-                retVal.msgStateStr = CopilotControlUtl::GetMsgStateAsString(msg);
-            }
+        // user sensor peripherals are clocked only for the life of the vm
+        PowerPeripheralGating::WhileInUse(PowerPeripheralGating::Use::JS, [&]{
+            JerryScript::UseVM([&]{
+                // parse to detect errors
+                retVal.parseErr = JerryScript::ParseScript(script);
+                retVal.parseOk  = retVal.parseErr == "";
+                retVal.parseMs  = JerryScript::GetScriptParseDurationMs();
+
+                if (retVal.parseOk)
+                {
+                    // reset message values to default
+                    msg.Reset();
+
+                    // load javascript integrations
+                    LoadJavaScriptBindings(msg, gpsFix);
+
+                    // set maximum execution time
+                    JSFn_DelayMs::SetTotalDurationLimitMs(timeLimitMs);
+                    JSFn_DelayMs::StartTimeNow();
+
+                    // run it
+                    retVal.runErr = JerryScript::ParseAndRunScript(script, timeLimitMs);
+
+                    // capture result of run
+                    retVal.runOk      = retVal.runErr == "";
+                    retVal.runMs      = JerryScript::GetScriptRunDurationMs();
+                    retVal.runDelayMs = JSFn_DelayMs::GetTotalDelayTimeMs();
+                    retVal.runOutput  = JerryScript::GetScriptOutput();
+
+                    retVal.msgStateStr = CopilotControlUtl::GetMsgStateAsString(msg);
+                }
+            });
         });
 
         // capture memory utilization stats
@@ -233,37 +241,14 @@ private:
     // JavaScript Utility Functions
     /////////////////////////////////////////////////////////////////
 
-    bool ScriptHasNonCommentedSubString(const string &script, const string &substr)
-    {
-        bool retVal = false;
-
-        vector<string> lineList = Split(script, "\n", false, true);
-
-        string sep = "";
-        for (size_t i = 0; i < lineList.size() && retVal == false; ++i)
-        {
-            string &line = lineList[i];
-
-            // chop off any commented part of the line
-            string lineUncommentedPart = Split(line, "//", false, true)[0];
-
-            // split by the string we're looking for.
-            // if the returned list is greater than 1, the substring exists.
-            vector<string> splitList = Split(lineUncommentedPart, substr, false, true);
-            retVal = splitList.size() > 1;
-        }
-
-        return retVal;
-    }
-
     bool ScriptUsesAPIGPS(const string &script)
     {
-        return ScriptHasNonCommentedSubString(script, "gps.Get");
+        return CopilotControlScriptScan::HasNonCommentedSubString(script, "gps.Get");
     }
 
     bool ScriptUsesAPIMsg(const string &script)
     {
-        return ScriptHasNonCommentedSubString(script, "msg.Set");
+        return CopilotControlScriptScan::HasNonCommentedSubString(script, "msg.Set");
     }
 
 
@@ -0,0 +1,203 @@
+#pragma once
+
+#include "JSONMsgRouter.h"
+#include "Log.h"
+#include "Shell.h"
+#include "Utl.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+// Shares the time scripts may run for across the slots of a window.
+//
+// Each slot is allotted the per-script limit. Time a script doesn't use
+// is carried over to the slots after it in the same window, so a slow
+// script can follow fast ones.
+//
+// The limit is also held back from the slot's deadline, the start of the
+// period whose message needs the result. If there is no longer enough
+// time left before the deadline, the script isn't run at all, and the
+// slot falls back to its default send.
+class CopilotControlJsBudget
+{
+public:
+
+    struct SlotRecord
+    {
+        uint64_t limitMs = 0;
+        uint64_t usedMs  = 0;
+        bool     ran     = false;
+        bool     expired = false;
+    };
+
+
+public:
+
+    CopilotControlJsBudget()
+    {
+        SetupShell();
+        SetupJSON();
+    }
+
+    void OnWindowStart(uint64_t slotLimitMs)
+    {
+        slotLimitMs_ = slotLimitMs;
+        carryMs_     = 0;
+
+        for (auto &rec : recordList_)
+        {
+            rec = SlotRecord{};
+        }
+    }
+
+    // The time a slot's script may run for, or 0 if it can no longer
+    // finish before its deadline.
+    //
+    // A deadline of 0 means there isn't one.
+    uint64_t GetLimitMs(uint8_t slot, uint64_t timeNowUs, uint64_t timeAtDeadlineUs)
+    {
+        uint64_t limitMs = slotLimitMs_ + carryMs_;
+
+        if (timeAtDeadlineUs)
+        {
+            uint64_t durationToDeadlineMs = timeAtDeadlineUs > timeNowUs ? (timeAtDeadlineUs - timeNowUs) / 1'000 : 0;
+            uint64_t durationAvailMs      = durationToDeadlineMs - min(durationToDeadlineMs, DEADLINE_MARGIN_MS);
+
+            limitMs = min(limitMs, durationAvailMs);
+        }
+
+        if (limitMs < LIMIT_MIN_MS)
+        {
+            limitMs = 0;
+        }
+
+        SlotRecord &rec = GetRecord(slot);
+        rec.limitMs = limitMs;
+        rec.expired = limitMs == 0;
+
+        if (rec.expired)
+        {
+            ++expiredCount_;
+        }
+
+        return limitMs;
+    }
+
+    // whatever the slot was allotted and didn't use goes to later slots
+    void OnRun(uint8_t slot, uint64_t usedMs)
+    {
+        uint64_t allotMs = slotLimitMs_ + carryMs_;
+
+        carryMs_ = allotMs - min(allotMs, usedMs);
+
+        SlotRecord &rec = GetRecord(slot);
+        rec.usedMs = usedMs;
+        rec.ran    = true;
+
+        // used is wall time around the whole run, the limit is the vm's
+        // alone, so the time held back for the rest is allowed for too
+        ++runCount_;
+        if (usedMs > rec.limitMs + DEADLINE_MARGIN_MS)
+        {
+            ++overrunCount_;
+        }
+    }
+
+    const SlotRecord &GetSlotRecord(uint8_t slot)
+    {
+        return GetRecord(slot);
+    }
+
+    void Report()
+    {
+        Log("JS Budget");
+        Log("- slot limit : ", slotLimitMs_, " ms");
+        Log("- margin     : ", DEADLINE_MARGIN_MS, " ms before deadline");
+        Log("- carry now  : ", carryMs_, " ms");
+        for (uint8_t slot = 1; slot <= 5; ++slot)
+        {
+            const SlotRecord &rec = GetRecord(slot);
+
+            LogNNL("- slot", slot, "      : ");
+            if (rec.expired)
+            {
+                LogNNL("expired, not run");
+            }
+            else if (rec.ran)
+            {
+                LogNNL(rec.usedMs, " / ", rec.limitMs, " ms");
+            }
+            else
+            {
+                LogNNL("not run");
+            }
+            LogNL();
+        }
+        Log("- total      : ", Commas(runCount_), " run, ", Commas(expiredCount_), " expired, ", Commas(overrunCount_), " overran");
+    }
+
+
+private:
+
+    SlotRecord &GetRecord(uint8_t slot)
+    {
+        return recordList_[min(max(slot, (uint8_t)1), (uint8_t)5) - 1];
+    }
+
+
+private:
+
+    void SetupShell()
+    {
+        Shell::AddCommand("app.ss.cc.jsbudget", [this](vector<string> argList){
+            Report();
+        }, { .argCount = 0, .help = "report js budget for the last window"});
+    }
+
+    void SetupJSON()
+    {
+        JSONMsgRouter::RegisterHandler("REQ_GET_JS_BUDGET", [this](auto &in, auto &out){
+            out["type"] = "REP_GET_JS_BUDGET";
+
+            out["slotLimitMs"] = slotLimitMs_;
+            out["marginMs"]    = DEADLINE_MARGIN_MS;
+            out["carryMs"]     = carryMs_;
+
+            for (uint8_t slot = 1; slot <= 5; ++slot)
+            {
+                const SlotRecord &rec = GetRecord(slot);
+                string prefix = string{"slot"} + to_string(slot);
+
+                out[prefix + "LimitMs"] = rec.limitMs;
+                out[prefix + "UsedMs"]  = rec.usedMs;
+                out[prefix + "Ran"]     = rec.ran;
+                out[prefix + "Expired"] = rec.expired;
+            }
+
+            out["runCount"]     = runCount_;
+            out["expiredCount"] = expiredCount_;
+            out["overrunCount"] = overrunCount_;
+        });
+    }
+
+
+private:
+
+    // covers the vm start, parse, and clock changes around the run itself
+    inline static const uint64_t DEADLINE_MARGIN_MS = 500;
+
+    // less than this isn't worth starting the vm for
+    inline static const uint64_t LIMIT_MIN_MS = 100;
+
+    uint64_t slotLimitMs_ = 0;
+    uint64_t carryMs_     = 0;
+
+    SlotRecord recordList_[5];
+
+    uint32_t runCount_     = 0;
+    uint32_t expiredCount_ = 0;
+    uint32_t overrunCount_ = 0;
+};
\ No newline at end of file
@@ -0,0 +1,371 @@
+#pragma once
+
+#include "CopilotControlRecording.h"
+#include "FilesystemLittleFS.h"
+#include "GPS.h"
+#include "JSONMsgRouter.h"
+#include "Log.h"
+#include "Shell.h"
+#include "TimeClass.h"
+#include "Utl.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+// Records the inputs the scheduler acts on, so a flight can be looked at
+// afterwards.
+//
+// Replaying a recording through the scheduler isn't possible yet. The
+// scheduler doesn't build apart from the JS engine, timers and picoinf.
+//
+// Records are fixed size and kept in a ring in flash, made of segment
+// files. New records collect in RAM and are written out to the current
+// segment when it fills, or when flushed (at the end of each window).
+// Once all segments are used the oldest one is overwritten.
+//
+// Segment file layout, little endian:
+// - uint32_t magic
+// - uint32_t segment sequence number, increasing
+// - Record * count
+//
+// The recording only holds inputs. Scheduler outputs (marks, timers)
+// follow from the inputs, given the same build.
+class CopilotControlRecorder
+{
+public:
+
+    using Type   = CopilotControlRecording::Type;
+    using Record = CopilotControlRecording::Record;
+
+
+public:
+
+    CopilotControlRecorder()
+    {
+        SetupShell();
+        SetupJSON();
+    }
+
+    void Add(Type type, uint8_t arg = 0, uint16_t ms = 0, uint32_t value = 0, uint64_t timeUs = 0)
+    {
+        Load();
+
+        Record rec;
+        rec.timeUs = timeUs ? timeUs : PAL.Micros();
+        rec.type   = type;
+        rec.arg    = arg;
+        rec.ms     = ms;
+        rec.value  = value;
+
+        recordList_.push_back(rec);
+        ++recordCount_;
+
+        if (recordList_.size() >= RECORDS_PER_SEGMENT)
+        {
+            Flush();
+
+            // move on to the next segment
+            recordList_.clear();
+            ++segSeq_;
+        }
+    }
+
+    void AddGps(Type type, const FixTime &fix)
+    {
+        Add(type, 0, fix.millisecond, PackDateTime(fix), fix.timeAtPpsUs);
+    }
+
+    // writes out the current segment, which keeps filling until full
+    void Flush()
+    {
+        if (loaded_ == false || recordList_.empty()) { return; }
+
+        string buf;
+        buf.resize(SEGMENT_HEADER_SIZE + recordList_.size() * sizeof(Record));
+
+        uint32_t magic = MAGIC;
+        memcpy(&buf[0], &magic,   sizeof(magic));
+        memcpy(&buf[4], &segSeq_, sizeof(segSeq_));
+        memcpy(&buf[SEGMENT_HEADER_SIZE], recordList_.data(), recordList_.size() * sizeof(Record));
+
+        FilesystemLittleFS::Write(GetSegmentFileName(segSeq_ % SEGMENT_COUNT), buf);
+
+        ++flushCount_;
+    }
+
+    void Clear()
+    {
+        for (uint32_t i = 0; i < SEGMENT_COUNT; ++i)
+        {
+            FilesystemLittleFS::Remove(GetSegmentFileName(i));
+        }
+
+        loaded_ = true;
+        segSeq_ = 0;
+        recordList_.clear();
+    }
+
+    // every record held, oldest first
+    vector<Record> GetRecordList()
+    {
+        Load();
+
+        vector<Record> retVal;
+
+        for (uint32_t seq : GetSegmentSeqList())
+        {
+            if (seq == segSeq_) { continue; }
+
+            vector<Record> segRecordList;
+            if (ReadSegment(seq % SEGMENT_COUNT, nullptr, segRecordList))
+            {
+                retVal.insert(retVal.end(), segRecordList.begin(), segRecordList.end());
+            }
+        }
+        retVal.insert(retVal.end(), recordList_.begin(), recordList_.end());
+
+        return retVal;
+    }
+
+    static string ToString(const Record &rec)
+    {
+        string retVal = Time::MakeTimeFromUs(rec.timeUs, true) + " " + CopilotControlRecording::GetTypeName(rec.type);
+
+        switch (rec.type)
+        {
+        case Type::START:
+        case Type::RESTART:
+            retVal += " startMin=" + to_string(rec.value);
+            break;
+
+        case Type::GPS_TIME:
+        case Type::GPS_3D_PLUS:
+        {
+            FixTime fix = UnpackDateTime(rec);
+            retVal += " " + GPSReader::MakeDateTimeFromFixTime(fix);
+            break;
+        }
+
+        case Type::JS_RESULT:
+            retVal += " slot" + to_string(rec.arg) + " ok=" + to_string(rec.value) + " " + to_string(rec.ms) + " ms";
+            break;
+
+        case Type::CLOCK:
+            retVal += rec.arg ? " high" : " low";
+            break;
+
+        case Type::VCC:
+            retVal += " " + to_string(rec.value) + " mV";
+            break;
+
+        case Type::WARMUP:
+            retVal += " " + to_string(rec.value) + " ms";
+            break;
+
+        default:
+            break;
+        }
+
+        return retVal;
+    }
+
+    // the gps fix as the scheduler saw it, time fields only
+    static FixTime UnpackDateTime(const Record &rec)
+    {
+        FixTime fix;
+
+        auto dt = CopilotControlRecording::UnpackDateTime(rec.value);
+
+        fix.timeAtPpsUs = rec.timeUs;
+        fix.second      = dt.second;
+        fix.minute      = dt.minute;
+        fix.hour        = dt.hour;
+        fix.day         = dt.day;
+        fix.month       = dt.month;
+        fix.year        = dt.year;
+        fix.millisecond = rec.ms;
+        fix.dateTime    = GPSReader::MakeDateTimeFromFixTime(fix);
+
+        return fix;
+    }
+
+    void Report()
+    {
+        Load();
+
+        Log("Scheduler Recorder");
+        Log("- segments  : ", SEGMENT_COUNT, " x ", RECORDS_PER_SEGMENT, " records (", Commas(SEGMENT_COUNT * RECORDS_PER_SEGMENT * sizeof(Record)), " bytes)");
+        Log("- segment   : ", segSeq_, " (", recordList_.size(), " records)");
+        Log("- recorded  : ", Commas(recordCount_), " since boot");
+        Log("- flushed   : ", Commas(flushCount_), " times since boot");
+    }
+
+
+private:
+
+    static uint32_t PackDateTime(const FixTime &fix)
+    {
+        return CopilotControlRecording::PackDateTime({
+            .year   = (uint16_t)fix.year,
+            .month  = (uint8_t)fix.month,
+            .day    = (uint8_t)fix.day,
+            .hour   = (uint8_t)fix.hour,
+            .minute = (uint8_t)fix.minute,
+            .second = (uint8_t)fix.second,
+        });
+    }
+
+    static string GetSegmentFileName(uint32_t idx)
+    {
+        return string{"cc.rec."} + to_string(idx);
+    }
+
+    static bool ReadSegment(uint32_t idx, uint32_t *seqRet, vector<Record> &recordList)
+    {
+        bool retVal = false;
+
+        string buf = FilesystemLittleFS::Read(GetSegmentFileName(idx));
+
+        if (buf.size() >= SEGMENT_HEADER_SIZE && (buf.size() - SEGMENT_HEADER_SIZE) % sizeof(Record) == 0)
+        {
+            uint32_t magic = 0;
+            uint32_t seq   = 0;
+            memcpy(&magic, &buf[0], sizeof(magic));
+            memcpy(&seq,   &buf[4], sizeof(seq));
+
+            if (magic == MAGIC)
+            {
+                retVal = true;
+
+                if (seqRet) { *seqRet = seq; }
+
+                recordList.resize((buf.size() - SEGMENT_HEADER_SIZE) / sizeof(Record));
+                memcpy(recordList.data(), &buf[SEGMENT_HEADER_SIZE], recordList.size() * sizeof(Record));
+            }
+        }
+
+        return retVal;
+    }
+
+    // sequence numbers of the segments in flash, oldest first
+    static vector<uint32_t> GetSegmentSeqList()
+    {
+        vector<uint32_t> retVal;
+
+        for (uint32_t i = 0; i < SEGMENT_COUNT; ++i)
+        {
+            string buf = FilesystemLittleFS::Read(GetSegmentFileName(i));
+
+            uint32_t magic = 0;
+            uint32_t seq   = 0;
+            if (buf.size() >= SEGMENT_HEADER_SIZE)
+            {
+                memcpy(&magic, &buf[0], sizeof(magic));
+                memcpy(&seq,   &buf[4], sizeof(seq));
+            }
+
+            if (magic == MAGIC)
+            {
+                retVal.push_back(seq);
+            }
+        }
+
+        sort(retVal.begin(), retVal.end());
+
+        return retVal;
+    }
+
+    // carry on after the newest segment in flash, leaving it intact
+    void Load()
+    {
+        if (loaded_) { return; }
+        loaded_ = true;
+
+        vector<uint32_t> seqList = GetSegmentSeqList();
+        segSeq_ = seqList.empty() ? 0 : seqList.back() + 1;
+    }
+
+
+private:
+
+    void SetupShell()
+    {
+        Shell::AddCommand("app.ss.cc.rec", [this](vector<string> argList){
+            Report();
+        }, { .argCount = 0, .help = "report scheduler recorder"});
+
+        Shell::AddCommand("app.ss.cc.rec.show", [this](vector<string> argList){
+            vector<Record> recordList = GetRecordList();
+
+            size_t count = recordList.size();
+            if (argList.size() == 1)
+            {
+                count = min(count, (size_t)atoi(argList[0].c_str()));
+            }
+
+            for (size_t i = recordList.size() - count; i < recordList.size(); ++i)
+            {
+                Log(ToString(recordList[i]));
+            }
+            Log(count, " records shown");
+        }, { .argCount = -1, .help = "show recorded scheduler inputs [<lastN>]"});
+
+        Shell::AddCommand("app.ss.cc.rec.flush", [this](vector<string> argList){
+            Flush();
+            Report();
+        }, { .argCount = 0, .help = "write recorded scheduler inputs to flash"});
+
+        Shell::AddCommand("app.ss.cc.rec.clear", [this](vector<string> argList){
+            Clear();
+            Report();
+        }, { .argCount = 0, .help = "erase recorded scheduler inputs"});
+    }
+
+    void SetupJSON()
+    {
+        // one segment at a time, as hex, for replay off the device, see
+        // CopilotControlRecording for the format
+        JSONMsgRouter::RegisterHandler("REQ_GET_RECORDING", [this](auto &in, auto &out){
+            out["type"] = "REP_GET_RECORDING";
+
+            Flush();
+
+            uint32_t idx = (uint32_t)in["segment"];
+
+            uint32_t       seq = 0;
+            vector<Record> recordList;
+            bool ok = idx < SEGMENT_COUNT && ReadSegment(idx, &seq, recordList);
+
+            string hex = CopilotControlRecording::MakeHex(recordList);
+
+            out["ok"]           = ok;
+            out["segmentCount"] = SEGMENT_COUNT;
+            out["segment"]      = idx;
+            out["seq"]          = seq;
+            out["recordSize"]   = sizeof(Record);
+            out["recordCount"]  = recordList.size();
+            out["records"]      = hex;
+        });
+    }
+
+
+private:
+
+    inline static const uint32_t MAGIC               = 0x43435201;  // "CCR" v1
+    inline static const uint32_t SEGMENT_HEADER_SIZE = 8;
+    inline static const uint32_t SEGMENT_COUNT       = 32;
+    inline static const uint32_t RECORDS_PER_SEGMENT = 128;
+
+    bool     loaded_ = false;
+    uint32_t segSeq_ = 0;
+
+    // records of the current segment, all written out or not
+    vector<Record> recordList_;
+
+    uint32_t recordCount_ = 0;
+    uint32_t flushCount_  = 0;
+};
\ No newline at end of file
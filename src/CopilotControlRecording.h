@@ -0,0 +1,190 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+using namespace std;
+
+
+// The format of the scheduler's input recording, as kept in flash and as
+// sent off the device by REQ_GET_RECORDING.
+//
+// Records are 16 bytes, little endian, sent as hex. Each segment is sent
+// with its sequence number, segments put in sequence order make the
+// recording, oldest first.
+//
+// Kept free of hardware so recordings can be read on the host.
+class CopilotControlRecording
+{
+public:
+
+    enum class Type : uint8_t
+    {
+        NONE,
+        START,          // value = start minute
+        STOP,
+        GPS_TIME,       // timeUs = time at pps, value = packed date/time, ms
+        GPS_3D_PLUS,    // timeUs = time at pps, value = packed date/time, ms
+        JS_RESULT,      // arg = slot, ms = duration, value = ok
+        CLOCK,          // arg = 1 high speed, 0 low speed
+        VCC,            // value = mV
+        WARMUP,         // value = duration ms
+        RESTART,        // value = start minute, restarted in place while running
+    };
+
+    static const char *GetTypeName(Type type)
+    {
+        const char *retVal = "";
+
+        switch (type)
+        {
+        case Type::NONE:        retVal = "NONE";        break;
+        case Type::START:       retVal = "START";       break;
+        case Type::STOP:        retVal = "STOP";        break;
+        case Type::GPS_TIME:    retVal = "GPS_TIME";    break;
+        case Type::GPS_3D_PLUS: retVal = "GPS_3D_PLUS"; break;
+        case Type::JS_RESULT:   retVal = "JS_RESULT";   break;
+        case Type::CLOCK:       retVal = "CLOCK";       break;
+        case Type::VCC:         retVal = "VCC";         break;
+        case Type::WARMUP:      retVal = "WARMUP";      break;
+        case Type::RESTART:     retVal = "RESTART";     break;
+        }
+
+        return retVal;
+    }
+
+    struct Record
+    {
+        uint64_t timeUs = 0;
+        Type     type   = Type::NONE;
+        uint8_t  arg    = 0;
+        uint16_t ms     = 0;
+        uint32_t value  = 0;
+    };
+    static_assert(sizeof(Record) == 16);
+
+    // year is 0 when the gps has no date
+    struct DateTime
+    {
+        uint16_t year   = 0;
+        uint8_t  month  = 0;
+        uint8_t  day    = 0;
+        uint8_t  hour   = 0;
+        uint8_t  minute = 0;
+        uint8_t  second = 0;
+    };
+
+
+public:
+
+    // year is kept since 2000, plus one, so 0 can mean no date
+    static uint32_t PackDateTime(const DateTime &dt)
+    {
+        uint32_t yearOff = dt.year >= 2000 ? min(dt.year - 2000 + 1, 63) : 0;
+
+        return ((uint32_t)(dt.second & 0x3F) <<  0) |
+               ((uint32_t)(dt.minute & 0x3F) <<  6) |
+               ((uint32_t)(dt.hour   & 0x1F) << 12) |
+               ((uint32_t)(dt.day    & 0x1F) << 17) |
+               ((uint32_t)(dt.month  & 0x0F) << 22) |
+               ((uint32_t)(yearOff   & 0x3F) << 26);
+    }
+
+    static DateTime UnpackDateTime(uint32_t v)
+    {
+        DateTime dt;
+
+        dt.second       = (v >>  0) & 0x3F;
+        dt.minute       = (v >>  6) & 0x3F;
+        dt.hour         = (v >> 12) & 0x1F;
+        dt.day          = (v >> 17) & 0x1F;
+        dt.month        = (v >> 22) & 0x0F;
+        uint8_t yearOff = (v >> 26) & 0x3F;
+        dt.year         = yearOff ? 2000 + yearOff - 1 : 0;
+
+        return dt;
+    }
+
+    static string MakeHex(const vector<Record> &recordList)
+    {
+        const char *HEX_DIGIT = "0123456789abcdef";
+
+        const uint8_t *p   = (const uint8_t *)recordList.data();
+        size_t         len = recordList.size() * sizeof(Record);
+
+        string retVal;
+        retVal.reserve(len * 2);
+        for (size_t i = 0; i < len; ++i)
+        {
+            retVal += HEX_DIGIT[p[i] >> 4];
+            retVal += HEX_DIGIT[p[i] & 0x0F];
+        }
+
+        return retVal;
+    }
+
+    // false, and nothing added, unless the hex is whole records
+    static bool ParseHex(const string &hex, vector<Record> &recordList)
+    {
+        bool retVal = false;
+
+        if (hex.size() % (sizeof(Record) * 2) == 0)
+        {
+            vector<uint8_t> buf(hex.size() / 2);
+
+            retVal = true;
+            for (size_t i = 0; i < buf.size() && retVal; ++i)
+            {
+                int hi = HexDigitValue(hex[i * 2]);
+                int lo = HexDigitValue(hex[i * 2 + 1]);
+
+                if (hi < 0 || lo < 0) { retVal = false; }
+                else                  { buf[i] = (uint8_t)(hi << 4 | lo); }
+            }
+
+            if (retVal)
+            {
+                size_t countWas = recordList.size();
+
+                recordList.resize(countWas + buf.size() / sizeof(Record));
+                memcpy(recordList.data() + countWas, buf.data(), buf.size());
+            }
+        }
+
+        return retVal;
+    }
+
+    // The recording from segments as sent, each a sequence number and its
+    // records as hex, in any order. Segments which don't parse are left out.
+    static vector<Record> MakeRecordList(vector<pair<uint32_t, string>> segmentList)
+    {
+        sort(segmentList.begin(), segmentList.end(), [](const auto &a, const auto &b){
+            return a.first < b.first;
+        });
+
+        vector<Record> retVal;
+        for (const auto &[seq, hex] : segmentList)
+        {
+            ParseHex(hex, retVal);
+        }
+
+        return retVal;
+    }
+
+
+private:
+
+    static int HexDigitValue(char c)
+    {
+        int retVal = -1;
+
+        if      (c >= '0' && c <= '9') { retVal = c - '0';      }
+        else if (c >= 'a' && c <= 'f') { retVal = c - 'a' + 10; }
+        else if (c >= 'A' && c <= 'F') { retVal = c - 'A' + 10; }
+
+        return retVal;
+    }
+};
\ No newline at end of file
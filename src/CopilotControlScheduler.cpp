@@ -552,7 +552,7 @@ void TestGpsEventsApply3dIgnorePostLockoutTime(TimerSequence &ts)
                                                                 // no need to wait, scheduled immediately
     test.AddExpectedWindowLockoutStartEvent();
     test.DoLockOnTimeReqNoLockoutOn("2025-01-01 12:10:00.500")  // ignored
-            .StartAtUs([]{ return scheduler->timerScheduleLockOutStart_.GetTimeoutAtUs(); });
+            .StartAtUs([]{ return scheduler->GetTimeAtWindowPlanActionUs(CopilotControlWindowPlan::Action::SCHEDULE_LOCK_OUT_START); });
     test.AddExpectedWindowLockoutEndEvent();
     test.AddExpectedEvent("APPLY_CACHE_OLD_3D_PLUS");   // next window
     test.DelayMs(1'400);
@@ -567,7 +567,7 @@ void TestGpsEventsApply3dIgnorePostLockout3d(TimerSequence &ts)
                                                                 // no need to wait, scheduled immediately
     test.AddExpectedWindowLockoutStartEvent();
     test.DoLock3DPlusReqNoLockoutOn("2025-01-01 12:10:00.500")  // ignored
-            .StartAtUs([]{ return scheduler->timerScheduleLockOutStart_.GetTimeoutAtUs(); });
+            .StartAtUs([]{ return scheduler->GetTimeAtWindowPlanActionUs(CopilotControlWindowPlan::Action::SCHEDULE_LOCK_OUT_START); });
     test.AddExpectedWindowLockoutEndEvent();
     test.AddExpectedEvent("APPLY_CACHE_OLD_3D_PLUS");   // next window
     test.DelayMs(1'400);
@@ -587,7 +587,7 @@ void TestGpsEventsApplyTimeCacheTime(TimerSequence &ts)
     test.DelayMs(300);                                          // +300ms = 00.700 (within target)
     test.AddExpectedWindowLockoutStartEvent();
     test.DoLockOnTimeReqOnLockoutOn("2025-01-01 12:16:00.500")
-        .StartAtUs([]{ return scheduler->timerTxDisableGpsEnable_.GetTimeoutAtUs(); });
+        .StartAtUs([]{ return scheduler->GetTimeAtWindowPlanActionUs(CopilotControlWindowPlan::Action::TX_DISABLE_GPS_ENABLE); });
     test.AddExpectedWindowLockoutEndEvent();
     test.AddExpectedEvent("APPLY_CACHE_NEW_TIME");   // next window
     test.DelayMs(1'100);
@@ -602,9 +602,9 @@ void TestGpsEventsApplyTimeCacheTimeTime(TimerSequence &ts)
     test.DelayMs(300);                                          // +300ms = 00.700 (within target)
     test.AddExpectedWindowLockoutStartEvent();
     test.DoLockOnTimeReqOnLockoutOn("2025-01-01 12:16:00.500")
-        .StartAtUs([]{ return scheduler->timerTxDisableGpsEnable_.GetTimeoutAtUs(); });
+        .StartAtUs([]{ return scheduler->GetTimeAtWindowPlanActionUs(CopilotControlWindowPlan::Action::TX_DISABLE_GPS_ENABLE); });
     test.DoLockOnTimeReqOnLockoutOn("2025-01-01 12:16:00.600")
-        .StartAtUs([]{ return scheduler->timerTxDisableGpsEnable_.GetTimeoutAtUs(); });
+        .StartAtUs([]{ return scheduler->GetTimeAtWindowPlanActionUs(CopilotControlWindowPlan::Action::TX_DISABLE_GPS_ENABLE); });
     test.AddExpectedWindowLockoutEndEvent();
     test.AddExpectedEvent("APPLY_CACHE_NEW_TIME");   // next window
     test.DelayMs(1'100);
@@ -619,7 +619,7 @@ void TestGpsEventsApplyTimeCache3d(TimerSequence &ts)
     test.DelayMs(300);                                          // +300ms = 00.700 (within target)
     test.AddExpectedWindowLockoutStartEvent();
     test.DoLock3DPlusReqOnLockoutOn("2025-01-01 12:16:00.500")
-        .StartAtUs([]{ return scheduler->timerTxDisableGpsEnable_.GetTimeoutAtUs(); });
+        .StartAtUs([]{ return scheduler->GetTimeAtWindowPlanActionUs(CopilotControlWindowPlan::Action::TX_DISABLE_GPS_ENABLE); });
     test.AddExpectedWindowLockoutEndEvent();
     test.AddExpectedEvent("APPLY_CACHE_NEW_3D_PLUS");   // next window
     test.DelayMs(1'100);
@@ -634,9 +634,9 @@ void TestGpsEventsApplyTimeCache3d3d(TimerSequence &ts)
     test.DelayMs(300);                                          // +300ms = 00.700 (within target)
     test.AddExpectedWindowLockoutStartEvent();
     test.DoLock3DPlusReqOnLockoutOn("2025-01-01 12:16:00.500")
-        .StartAtUs([]{ return scheduler->timerTxDisableGpsEnable_.GetTimeoutAtUs(); });
+        .StartAtUs([]{ return scheduler->GetTimeAtWindowPlanActionUs(CopilotControlWindowPlan::Action::TX_DISABLE_GPS_ENABLE); });
     test.DoLock3DPlusReqNoLockoutOn("2025-01-01 12:16:00.600")
-        .StartAtUs([]{ return scheduler->timerTxDisableGpsEnable_.GetTimeoutAtUs(); });
+        .StartAtUs([]{ return scheduler->GetTimeAtWindowPlanActionUs(CopilotControlWindowPlan::Action::TX_DISABLE_GPS_ENABLE); });
     test.AddExpectedWindowLockoutEndEvent();
     test.AddExpectedEvent("APPLY_CACHE_NEW_3D_PLUS");   // next window
     test.DelayMs(1'100);
@@ -651,9 +651,9 @@ void TestGpsEventsApplyTimeCacheTime3d(TimerSequence &ts)
     test.DelayMs(300);                                          // +300ms = 00.700 (within target)
     test.AddExpectedWindowLockoutStartEvent();
     test.DoLockOnTimeReqOnLockoutOn("2025-01-01 12:16:00.500")
-        .StartAtUs([]{ return scheduler->timerTxDisableGpsEnable_.GetTimeoutAtUs(); });
+        .StartAtUs([]{ return scheduler->GetTimeAtWindowPlanActionUs(CopilotControlWindowPlan::Action::TX_DISABLE_GPS_ENABLE); });
     test.DoLock3DPlusReqOnLockoutOn("2025-01-01 12:16:00.600")
-        .StartAtUs([]{ return scheduler->timerTxDisableGpsEnable_.GetTimeoutAtUs(); });
+        .StartAtUs([]{ return scheduler->GetTimeAtWindowPlanActionUs(CopilotControlWindowPlan::Action::TX_DISABLE_GPS_ENABLE); });
     test.AddExpectedWindowLockoutEndEvent();
     test.AddExpectedEvent("APPLY_CACHE_NEW_3D_PLUS");   // next window
     test.DelayMs(1'100);
@@ -668,9 +668,9 @@ void TestGpsEventsApplyTimeCache3dTime(TimerSequence &ts)
     test.DelayMs(300);                                          // +300ms = 00.700 (within target)
     test.AddExpectedWindowLockoutStartEvent();
     test.DoLock3DPlusReqOnLockoutOn("2025-01-01 12:16:00.500")
-        .StartAtUs([]{ return scheduler->timerTxDisableGpsEnable_.GetTimeoutAtUs(); });
+        .StartAtUs([]{ return scheduler->GetTimeAtWindowPlanActionUs(CopilotControlWindowPlan::Action::TX_DISABLE_GPS_ENABLE); });
     test.DoLockOnTimeReqNoLockoutOn("2025-01-01 12:16:00.600")
-        .StartAtUs([]{ return scheduler->timerTxDisableGpsEnable_.GetTimeoutAtUs(); });
+        .StartAtUs([]{ return scheduler->GetTimeAtWindowPlanActionUs(CopilotControlWindowPlan::Action::TX_DISABLE_GPS_ENABLE); });
     test.AddExpectedWindowLockoutEndEvent();
     test.AddExpectedEvent("APPLY_CACHE_NEW_3D_PLUS");   // next window
     test.DelayMs(1'100);
@@ -686,7 +686,7 @@ void TestGpsEventsApply3dCacheTime(TimerSequence &ts)
                                                                 // no need to wait, scheduled immediately
     test.AddExpectedWindowLockoutStartEvent();
     test.DoLockOnTimeReqOnLockoutOn("2025-01-01 12:16:00.500")
-        .StartAtUs([]{ return scheduler->timerTxDisableGpsEnable_.GetTimeoutAtUs(); });
+        .StartAtUs([]{ return scheduler->GetTimeAtWindowPlanActionUs(CopilotControlWindowPlan::Action::TX_DISABLE_GPS_ENABLE); });
     test.AddExpectedWindowLockoutEndEvent();
     test.AddExpectedEvent("APPLY_CACHE_NEW_TIME");   // next window
     test.DelayMs(1'000);
@@ -701,9 +701,9 @@ void TestGpsEventsApply3dCacheTimeTime(TimerSequence &ts)
                                                                 // no need to wait, scheduled immediately
     test.AddExpectedWindowLockoutStartEvent();
     test.DoLockOnTimeReqOnLockoutOn("2025-01-01 12:16:00.500")
-        .StartAtUs([]{ return scheduler->timerTxDisableGpsEnable_.GetTimeoutAtUs(); });
+        .StartAtUs([]{ return scheduler->GetTimeAtWindowPlanActionUs(CopilotControlWindowPlan::Action::TX_DISABLE_GPS_ENABLE); });
     test.DoLockOnTimeReqOnLockoutOn("2025-01-01 12:16:00.600")
-        .StartAtUs([]{ return scheduler->timerTxDisableGpsEnable_.GetTimeoutAtUs(); });
+        .StartAtUs([]{ return scheduler->GetTimeAtWindowPlanActionUs(CopilotControlWindowPlan::Action::TX_DISABLE_GPS_ENABLE); });
     test.AddExpectedWindowLockoutEndEvent();
     test.AddExpectedEvent("APPLY_CACHE_NEW_TIME");   // next window
     test.DelayMs(1'000);
@@ -718,7 +718,7 @@ void TestGpsEventsApply3dCache3d(TimerSequence &ts)
                                                                 // no need to wait, scheduled immediately
     test.AddExpectedWindowLockoutStartEvent();
     test.DoLock3DPlusReqOnLockoutOn("2025-01-01 12:16:00.500")
-        .StartAtUs([]{ return scheduler->timerTxDisableGpsEnable_.GetTimeoutAtUs(); });
+        .StartAtUs([]{ return scheduler->GetTimeAtWindowPlanActionUs(CopilotControlWindowPlan::Action::TX_DISABLE_GPS_ENABLE); });
     test.AddExpectedWindowLockoutEndEvent();
     test.AddExpectedEvent("APPLY_CACHE_NEW_3D_PLUS");   // next window
     test.DelayMs(1'000);
@@ -733,9 +733,9 @@ void TestGpsEventsApply3dCache3d3d(TimerSequence &ts)
                                                                 // no need to wait, scheduled immediately
     test.AddExpectedWindowLockoutStartEvent();
     test.DoLock3DPlusReqOnLockoutOn("2025-01-01 12:16:00.500")
-        .StartAtUs([]{ return scheduler->timerTxDisableGpsEnable_.GetTimeoutAtUs(); });
+        .StartAtUs([]{ return scheduler->GetTimeAtWindowPlanActionUs(CopilotControlWindowPlan::Action::TX_DISABLE_GPS_ENABLE); });
     test.DoLock3DPlusReqNoLockoutOn("2025-01-01 12:16:00.600")
-        .StartAtUs([]{ return scheduler->timerTxDisableGpsEnable_.GetTimeoutAtUs(); });
+        .StartAtUs([]{ return scheduler->GetTimeAtWindowPlanActionUs(CopilotControlWindowPlan::Action::TX_DISABLE_GPS_ENABLE); });
     test.AddExpectedWindowLockoutEndEvent();
     test.AddExpectedEvent("APPLY_CACHE_NEW_3D_PLUS");   // next window
     test.DelayMs(1'000);
@@ -750,9 +750,9 @@ void TestGpsEventsApply3dCacheTime3d(TimerSequence &ts)
                                                                 // no need to wait, scheduled immediately
     test.AddExpectedWindowLockoutStartEvent();
     test.DoLockOnTimeReqOnLockoutOn("2025-01-01 12:16:00.500")
-        .StartAtUs([]{ return scheduler->timerTxDisableGpsEnable_.GetTimeoutAtUs(); });
+        .StartAtUs([]{ return scheduler->GetTimeAtWindowPlanActionUs(CopilotControlWindowPlan::Action::TX_DISABLE_GPS_ENABLE); });
     test.DoLock3DPlusReqOnLockoutOn("2025-01-01 12:16:00.600")
-        .StartAtUs([]{ return scheduler->timerTxDisableGpsEnable_.GetTimeoutAtUs(); });
+        .StartAtUs([]{ return scheduler->GetTimeAtWindowPlanActionUs(CopilotControlWindowPlan::Action::TX_DISABLE_GPS_ENABLE); });
     test.AddExpectedWindowLockoutEndEvent();
     test.AddExpectedEvent("APPLY_CACHE_NEW_3D_PLUS");   // next window
     test.DelayMs(1'000);
@@ -767,9 +767,9 @@ void TestGpsEventsApply3dCache3dTime(TimerSequence &ts)
                                                                 // no need to wait, scheduled immediately
     test.AddExpectedWindowLockoutStartEvent();
     test.DoLock3DPlusReqOnLockoutOn("2025-01-01 12:16:00.500")
-        .StartAtUs([]{ return scheduler->timerTxDisableGpsEnable_.GetTimeoutAtUs(); });
+        .StartAtUs([]{ return scheduler->GetTimeAtWindowPlanActionUs(CopilotControlWindowPlan::Action::TX_DISABLE_GPS_ENABLE); });
     test.DoLockOnTimeReqNoLockoutOn("2025-01-01 12:16:00.600")
-        .StartAtUs([]{ return scheduler->timerTxDisableGpsEnable_.GetTimeoutAtUs(); });
+        .StartAtUs([]{ return scheduler->GetTimeAtWindowPlanActionUs(CopilotControlWindowPlan::Action::TX_DISABLE_GPS_ENABLE); });
     test.AddExpectedWindowLockoutEndEvent();
     test.AddExpectedEvent("APPLY_CACHE_NEW_3D_PLUS");   // next window
     test.DelayMs(1'000);
@@ -827,6 +827,44 @@ void TestGpsEventsCoastForever3d(TimerSequence &ts)
 }
 
 
+void TestGpsEventsCoastVccSkipGps(TimerSequence &ts)
+{
+    GpsEventsTestBuilder test(ts, __func__);
+    test.DoStart();
+    test.DoLockOnTimeReqOnLockoutNo("2025-01-01 12:10:00.400"); // +200ms = 00.600
+
+    // too low on power for the gps from the first window on
+    ts.Add([]{ scheduler->vccPolicy_.SetLevel(CopilotControlVoltagePolicy::Level::SKIP_GPS); });
+
+    // the time lock's request is canceled as usual
+    test.AddExpectedEventList({
+        "COAST_TRIGGERED",
+        "CANCEL_REQ_NEW_GPS_LOCK",
+    });
+    test.AddExpectedWindowLockoutStartEvent();
+    test.AddExpectedEvent("GPS_REQ_SKIPPED_VCC_POLICY");
+    test.AddExpectedWindowLockoutEndEvent();
+    test.AddExpectedEvent("APPLY_CACHE_OLD_TIME");   // next window
+    test.DelayMs(1'100);
+
+    // windows after that were never asked for gps, and so have no request
+    // to cancel, which keeps them from counting as coasting
+    for (int i = 0; i < 3; ++i)
+    {
+        test.FastForward();
+        test.AddExpectedEventList({
+            "COAST_TRIGGERED",
+            "COAST_NO_GPS_REQ_TO_CANCEL",
+            "GPS_REQ_SKIPPED_VCC_POLICY",
+            "APPLY_CACHE_OLD_TIME",
+        });
+    }
+
+    ts.Add([]{ scheduler->vccPolicy_.SetLevel(CopilotControlVoltagePolicy::Level::NORMAL); });
+
+    test.Finish();
+}
+
 
 void CopilotControlScheduler::TestGpsEventInterface(vector<string> testNameList)
 {
@@ -973,6 +1011,7 @@ void CopilotControlScheduler::TestGpsEventInterface(vector<string> testNameList)
 
         TestGpsEventsCoastForeverTime(ts);
         TestGpsEventsCoastForever3d(ts);
+        TestGpsEventsCoastVccSkipGps(ts);
     }
 
 
@@ -1786,6 +1825,58 @@ void TestOverrideBasicTelemetryNoGpsButBadJs()
 }
 
 
+// slots 3 and 5 transmit, slot 4 in between doesn't.
+// expect the radio to be turned off after slot 3 and warmed up again
+// before slot 5.
+void TestRadioIdleGapNoGps()
+{
+    static Timer tTestOuter;
+    tTestOuter.SetCallback([]{
+        static Timer tTestInner;
+
+        scheduler->SetTesting(true);
+        int id = IncrAndGetTestId();
+        scheduler->CreateMarkList(id);
+
+        bool haveGpsLock = false;
+        SetSlot("slot1", msgDefBlank, jsUsesNeither);
+        SetSlot("slot2", msgDefBlank, jsUsesNeither);
+        SetSlot("slot3", msgDefSet,   jsUsesMsg);
+        SetSlot("slot4", msgDefBlank, jsUsesNeither);
+        SetSlot("slot5", msgDefSet,   jsUsesMsg);
+        scheduler->PrepareWindowSlotBehavior(haveGpsLock);
+        scheduler->PrepareWindowSchedule(0, 0);
+
+        tTestInner.SetCallback([id]{
+            string title = JustFunctionName(source_location::current().function_name());
+
+            scheduler->SetTesting(false);
+
+            vector<string> expectedList = {
+                "JS_EXEC",               "SEND_NO_MSG_NONE",        // slot 1
+                "JS_EXEC",               "SEND_NO_MSG_NONE",        // slot 2
+                "JS_EXEC",               "SEND_CUSTOM_MESSAGE",     // slot 3
+                "RADIO_IDLE_GAP_START",
+                "TX_REWARMUP",
+                                         "SEND_CUSTOM_MESSAGE",     // slot 5
+                "TX_DISABLE_GPS_ENABLE",
+            };
+
+            bool testOk = AssertSchedule(title, scheduler->GetMarkList(), expectedList);
+            scheduler->DestroyMarkList(id);
+
+            LogNL();
+            string result = string{"=== Test "} + (testOk ? "" : "NOT ") + "ok " + title + " ===";
+            testResultList.push_back(result);
+            Log(result);
+            LogNL();
+        });
+        tTestInner.TimeoutInMs(INNER_DELAY_MS);
+    });
+    tTestOuter.TimeoutInMs(NextTestDuration());
+}
+
+
 void CopilotControlScheduler::TestPrepareWindowSchedule()
 {
     scheduler = this;
@@ -1804,12 +1895,8 @@ void CopilotControlScheduler::TestPrepareWindowSchedule()
     UnSetCallbackSendDefault(3);
     UnSetCallbackSendDefault(4);
     UnSetCallbackSendDefault(5);
-    SetCallbackSendDefault(1, true, [this](uint8_t slot, uint64_t quitAfterMs){
-        Mark("SEND_REGULAR_TYPE1");
-    });
-    SetCallbackSendDefault(2, true, [this](uint8_t slot, uint64_t quitAfterMs){
-        Mark("SEND_BASIC_TELEMETRY");
-    });
+    SetCallbackSendDefaultStub(1, true, "SEND_REGULAR_TYPE1");
+    SetCallbackSendDefaultStub(2, true, "SEND_BASIC_TELEMETRY");
 
 
     // with good javascript
@@ -1819,6 +1906,7 @@ void CopilotControlScheduler::TestPrepareWindowSchedule()
     TestAllCustomMessagesNeedGpsWithNoGps();
     TestSomeCustomMessagesNeedGpsSomeDontWithGps();
     TestSomeCustomMessagesNeedGpsSomeDontNoGps();
+    TestRadioIdleGapNoGps();
 
 
     // with bad javascript
@@ -2215,3 +2303,161 @@ void CopilotControlScheduler::TestCalculateTimeAtWindowStartUs(bool fullSweep)
 
 
 
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestBenchmarkWindowPath
+///////////////////////////////////////////////////////////////////////////////
+
+
+
+
+
+// the most fields a user-defined message holds, one bit each
+static string MakeMsgDef29Fields()
+{
+    string retVal;
+
+    for (int i = 0; i < 29; ++i)
+    {
+        string name = string{"Field"} + (char)('A' + i % 26) + (i >= 26 ? "X" : "");
+
+        retVal += "{ \"name\": \"" + name + "\", \"unit\": \"Count\", \"lowValue\": 0, \"highValue\": 1, \"stepSize\": 1 },\n";
+    }
+
+    return retVal;
+}
+
+
+// Times the window path calls which need picoinf (flash, JSON, encoding),
+// so don't build on the host. The rest of the window path is benchmarked on
+// the host, see test/CopilotControlWindowPathBench.cpp.
+//
+// Runs at the 48MHz the window runs at. Budgets are a ceiling per call, a
+// result over budget fails the run. Results are logged once all timing is
+// done, only CalculateSlotBehavior logs while timed, as it does in the
+// window.
+//
+// Run with the scheduler stopped, the slot files are swapped out.
+void CopilotControlScheduler::TestBenchmarkWindowPath()
+{
+    if (running_)
+    {
+        Log("Scheduler running, benchmark in configuration mode");
+        return;
+    }
+
+    BackupFiles();
+    GoHighSpeed();
+
+    bool ok = true;
+
+    auto Bench = [&](const char *name, uint32_t iterations, uint64_t budgetNsPerOp, function<void()> fn){
+        uint64_t timeStartUs = PAL.Micros();
+        for (uint32_t i = 0; i < iterations; ++i)
+        {
+            fn();
+        }
+        uint64_t durationUs = PAL.Micros() - timeStartUs;
+
+        uint64_t nsPerOp = durationUs * 1'000 / iterations;
+        bool withinBudget = nsPerOp <= budgetNsPerOp;
+
+        ok &= withinBudget;
+
+        return [=]{
+            Log(StrUtl::PadRight(name, ' ', 38), " : ", Commas(nsPerOp), " ns/op",
+                " (budget ", Commas(budgetNsPerOp), ", ", Commas(iterations), " ops)",
+                withinBudget ? "" : " OVER BUDGET");
+        };
+    };
+
+    vector<function<void()>> reportList;
+
+
+    // slot behavior for every combination of msg def, script api use, and gps lock.
+    // includes the flash reads and its own logging, as in the window.
+    for (const string *msgDef : { &msgDefBlank, &msgDefSet })
+    {
+        for (const string *js : { &jsUsesNeither, &jsUsesGps, &jsUsesMsg, &jsUsesBoth })
+        {
+            SetSlot("slot1", *msgDef, *js);
+
+            for (bool haveGpsLock : { false, true })
+            {
+                reportList.push_back(Bench("CalculateSlotBehavior", 4, 50'000'000, [&]{
+                    CalculateSlotBehavior("slot1", haveGpsLock, defaultBehaviorList_[0]);
+                }));
+            }
+        }
+    }
+
+    // message definition, as configured ahead of the js running
+    SetSlot("slot1", MakeMsgDef29Fields(), jsUsesBoth);
+    reportList.push_back(Bench("ConfigureMsgFromMsgDef (29 fields)", 10, 40'000'000, [&]{
+        CopilotControlMessageDefinition::GetMsgResetAndConfigureBySlotName("slot1");
+    }));
+
+    MsgUD &msg = CopilotControlMessageDefinition::GetMsgLastConfigured();
+    reportList.push_back(Bench("GetMsgStateAsString (29 fields)", 10, 20'000'000, [&]{
+        CopilotControlUtl::GetMsgStateAsString(msg);
+    }));
+
+    // encoding, each message type sent
+    reportList.push_back(Bench("Encode TelemetryBasic", 100, 500'000, [&]{
+        WsprMessageTelemetryBasic msgTb;
+        msgTb.SetGrid56("FN20XR");
+        msgTb.SetAltitudeMeters(12'000);
+        msgTb.SetTemperatureCelsius(-40);
+        msgTb.SetVoltageVolts(3.3);
+        msgTb.SetSpeedKnots(42);
+        msgTb.SetGpsIsValid(true);
+        msgTb.SetId13("06");
+        msgTb.Encode();
+    }));
+
+    reportList.push_back(Bench("Encode ExtendedUserDefined (29 fields)", 100, 2'000'000, [&]{
+        msg.SetId13("06");
+        msg.SetHdrSlot(1);
+        msg.Encode();
+    }));
+
+    reportList.push_back(Bench("Encode ExtendedVendorDefined", 100, 2'000'000, [&]{
+        static WsprMessageTelemetryExtendedVendorDefined<29> msgVd;
+        msgVd.ResetEverything();
+        msgVd.DefineField("DurGpsOnSeconds", 0, 1800, 10);
+        msgVd.DefineField("SatsGPCount",     0,   32,  1);
+        msgVd.Set("DurGpsOnSeconds", 300);
+        msgVd.Set("SatsGPCount",     9);
+        msgVd.SetId13("06");
+        msgVd.SetHdrSlot(0);
+        msgVd.Encode();
+    }));
+
+    GoLowSpeed();
+    RestoreFiles();
+
+
+    // report
+    LogNL();
+    Log("=== Window Path Benchmark ===");
+    for (auto &fnReport : reportList)
+    {
+        fnReport();
+    }
+    Log("=== Benchmark ", ok ? "" : "NOT ", "within budget ===");
+    LogNL();
+}
\ No newline at end of file
@@ -1,10 +1,18 @@
 #pragma once
 
+#include "CopilotControlEnergy.h"
 #include "CopilotControlJavaScript.h"
+#include "CopilotControlJsBudget.h"
 #include "CopilotControlMessageDefinition.h"
+#include "CopilotControlRecorder.h"
+#include "CopilotControlTrace.h"
 #include "CopilotControlUtl.h"
+#include "CopilotControlVoltagePolicy.h"
+#include "CopilotControlWindowPlan.h"
 #include "Evm.h"
 #include "GPS.h"
+#include "JSON.h"
+#include "JSONMsgRouter.h"
 #include "Log.h"
 #include "Shell.h"
 #include "TimeClass.h"
@@ -22,6 +30,8 @@ class CopilotControlScheduler
 {
 private:
 
+    using WindowPlan = CopilotControlWindowPlan;
+
     struct SlotBehavior
     {
         bool   runJs   = true;
@@ -30,6 +40,7 @@ private:
         bool                                               hasDefault     = false;
         bool                                               canSendDefault = false;
         function<void(uint8_t slot, uint64_t quitAfterMs)> fnSendDefault  = [](uint8_t, uint64_t){};
+        bool                                               defaultIsStub  = false;
     };
 
     struct SlotState
@@ -47,6 +58,7 @@ public:
     CopilotControlScheduler()
     {
         SetupShell();
+        SetupJSON();
         ResetTimers();
         t_.SetMaxEvents(50);
     }
@@ -68,6 +80,7 @@ private:
         Mark("REQ_NEW_GPS_LOCK");
 
         reqGpsActive_ = true;
+        TraceCounter("gpsReq", 1);
 
         if (IsTesting() == false)
         {
@@ -75,11 +88,27 @@ private:
         }
     }
 
+    // Too low on power to run the gps, the next window coasts on the time
+    // already held.
+    void RequestNewGpsLockIfVccPolicyAllows()
+    {
+        if (vccPolicy_.GpsMayBeRequested())
+        {
+            RequestNewGpsLock();
+        }
+        else
+        {
+            Mark("GPS_REQ_SKIPPED_VCC_POLICY");
+            vccPolicy_.OnGpsSkip();
+        }
+    }
+
     void CancelRequestNewGpsLock()
     {
         Mark("CANCEL_REQ_NEW_GPS_LOCK");
 
         reqGpsActive_ = false;
+        TraceCounter("gpsReq", 0);
 
         if (IsTesting() == false)
         {
@@ -132,7 +161,7 @@ public:
     // Callback Setting - Message Sending
     /////////////////////////////////////////////////////////////////
 
-private:
+public:
 
     struct DefaultBehavior
     {
@@ -140,24 +169,38 @@ private:
 
         bool                                               needsGps = false;
         function<void(uint8_t slot, uint64_t quitAfterMs)> fn       = [](uint8_t, uint64_t){};
+        bool                                               isStub   = false;
     };
 
-    vector<DefaultBehavior> defaultBehaviorList_ = { {}, {}, {}, {}, {} };
+    // index 0-4 for slot 1-5
+    using DefaultBehaviorList = vector<DefaultBehavior>;
+
+private:
+
+    DefaultBehaviorList defaultBehaviorList_ = { {}, {}, {}, {}, {} };
+
+    function<DefaultBehaviorList(bool haveGpsLock)> fnCbGetDefaultBehaviorList_ = [](bool){ return DefaultBehaviorList(5); };
 
     function<void(uint8_t slot, MsgUD &msg, uint64_t quitAfterMs)> fnCbSendUserDefined_ = [](uint8_t, MsgUD &, uint64_t){};
 
-    void SendDefault(uint8_t slot, uint64_t quitAfterMs)
+    // Sends the default the slot behavior was calculated with.
+    //
+    // A test stub is called while testing too, it only marks which default
+    // it stands in for.
+    void SendDefault(const SlotBehavior &slotBehavior, uint8_t slot, uint64_t quitAfterMs)
     {
+        if (slotBehavior.defaultIsStub)
+        {
+            slotBehavior.fnSendDefault(slot, quitAfterMs);
+
+            return;
+        }
+
         Mark("SEND_DEFAULT_MESSAGE");
 
         if (IsTesting() == false)
         {
-            if (slot >= 1 && slot <= defaultBehaviorList_.size())
-            {
-                DefaultBehavior &db = defaultBehaviorList_[slot - 1];
-
-                db.fn(slot, quitAfterMs);
-            }
+            slotBehavior.fnSendDefault(slot, quitAfterMs);
         }
     }
 
@@ -181,6 +224,16 @@ public:
         }
     }
 
+    // For tests, a default which only marks, so a test sees which default
+    // each slot sent.
+    void SetCallbackSendDefaultStub(uint8_t slot, bool needsGps, const char *mark)
+    {
+        if (slot >= 1 && slot <= defaultBehaviorList_.size())
+        {
+            defaultBehaviorList_[slot - 1] = { true, needsGps, [this, mark](uint8_t, uint64_t){ Mark(mark); }, true };
+        }
+    }
+
     void UnSetCallbackSendDefault(uint8_t slot)
     {
         if (slot >= 1 && slot <= defaultBehaviorList_.size())
@@ -194,6 +247,14 @@ public:
         fnCbSendUserDefined_ = fn;
     }
 
+    // The defaults a window would be given, by gps lock, without setting
+    // them. The window simulator uses these rather than the schedule-now
+    // callback, which sets the live ones.
+    void SetCallbackGetDefaultBehaviorList(function<DefaultBehaviorList(bool haveGpsLock)> fn)
+    {
+        fnCbGetDefaultBehaviorList_ = fn;
+    }
+
 
     /////////////////////////////////////////////////////////////////
     // Callback Setting - Radio
@@ -220,6 +281,7 @@ private:
     void StartRadioWarmup()
     {
         Mark("ENABLE_RADIO");
+        TraceCounter("radio", 1);
 
         if (IsTesting() == false)
         {
@@ -230,6 +292,7 @@ private:
     void StopRadio()
     {
         Mark("DISABLE_RADIO");
+        TraceCounter("radio", 0);
 
         if (IsTesting() == false)
         {
@@ -255,6 +318,79 @@ public:
     }
 
 
+    /////////////////////////////////////////////////////////////////
+    // Callback Setting - Warmup
+    /////////////////////////////////////////////////////////////////
+
+private:
+
+    inline static const uint64_t DURATION_DEFAULT_WARMUP_US = 30 * 1'000 * 1'000;
+
+    function<uint64_t(uint64_t timeAtWarmupStartUs)> fnCbGetWarmupDurationUs_ = [](uint64_t){ return DURATION_DEFAULT_WARMUP_US; };
+
+    // The warmup for a window planned now may start minutes from now. The
+    // duration is asked for as of the latest the warmup can start, when
+    // only the javascript is left before the window. The warmup is planned
+    // to start no later than that, so any allowance made for the radio
+    // still being warm is never more than it will be.
+    uint64_t GetWarmupDurationUs(uint64_t timeAtWindowStartUs)
+    {
+        if (IsTesting() == false)
+        {
+            uint64_t durationJsUs              = GetDurationJsUs();
+            uint64_t timeAtWarmupStartLatestUs = timeAtWindowStartUs - min(durationJsUs, timeAtWindowStartUs);
+
+            uint64_t durationUs = fnCbGetWarmupDurationUs_(timeAtWarmupStartLatestUs);
+            RecordInput(CopilotControlRecorder::Type::WARMUP, 0, 0, (uint32_t)(durationUs / 1'000));
+
+            return durationUs;
+        }
+        else
+        {
+            return DURATION_DEFAULT_WARMUP_US;
+        }
+    }
+
+public:
+
+    void SetCallbackGetWarmupDurationUs(function<uint64_t(uint64_t timeAtWarmupStartUs)> fn)
+    {
+        fnCbGetWarmupDurationUs_ = fn;
+    }
+
+
+    /////////////////////////////////////////////////////////////////
+    // Callback Setting - Voltage
+    /////////////////////////////////////////////////////////////////
+
+private:
+
+    function<uint16_t()> fnCbGetMilliVoltsVcc_ = []{ return (uint16_t)0; };
+
+    // 0 when unknown
+    uint16_t GetMilliVoltsVcc()
+    {
+        if (IsTesting() == false)
+        {
+            uint16_t mv = fnCbGetMilliVoltsVcc_();
+            RecordInput(CopilotControlRecorder::Type::VCC, 0, 0, mv);
+
+            return mv;
+        }
+        else
+        {
+            return 0;
+        }
+    }
+
+public:
+
+    void SetCallbackGetMilliVoltsVcc(function<uint16_t()> fn)
+    {
+        fnCbGetMilliVoltsVcc_ = fn;
+    }
+
+
     /////////////////////////////////////////////////////////////////
     // Callback Setting - Speed Settings
     /////////////////////////////////////////////////////////////////
@@ -266,16 +402,22 @@ private:
 
     void GoHighSpeed()
     {
+        TraceCounter("clockHigh", 1);
+
         if (IsTesting() == false)
         {
+            RecordInput(CopilotControlRecorder::Type::CLOCK, 1);
             fnCbGoHighSpeed_();
         }
     }
 
     void GoLowSpeed()
     {
+        TraceCounter("clockHigh", 0);
+
         if (IsTesting() == false)
         {
+            RecordInput(CopilotControlRecorder::Type::CLOCK, 0);
             fnCbGoLowSpeed_();
         }
     }
@@ -294,6 +436,30 @@ public:
     }
 
 
+    /////////////////////////////////////////////////////////////////
+    // Callback Setting - Deep Sleep
+    /////////////////////////////////////////////////////////////////
+
+private:
+
+    function<void(uint64_t timeAtWakeUs)> fnCbDeepSleepUntil_ = [](uint64_t){};
+
+    void DeepSleepUntil(uint64_t timeAtWakeUs)
+    {
+        if (IsTesting() == false)
+        {
+            fnCbDeepSleepUntil_(timeAtWakeUs);
+        }
+    }
+
+public:
+
+    void SetCallbackDeepSleepUntil(function<void(uint64_t timeAtWakeUs)> fn)
+    {
+        fnCbDeepSleepUntil_ = fn;
+    }
+
+
     /////////////////////////////////////////////////////////////////
     // Timing
     /////////////////////////////////////////////////////////////////
@@ -414,6 +580,8 @@ public:
         Stop();
         running_ = true;
 
+        RecordInput(CopilotControlRecorder::Type::START, 0, 0, startMin_);
+
         RequestNewGpsLock();
 
         LogNL();
@@ -425,9 +593,23 @@ public:
 
         Mark("STOP");
 
+        RecordInput(CopilotControlRecorder::Type::STOP);
+        recorder_.Flush();
+
+        StopRunning();
+
+        LogNL();
+    }
+
+private:
+
+    // Everything stopping does, without marking or recording it, for
+    // restarting in place, which records itself as the one event.
+    void StopRunning()
+    {
         // no longer in running state
         running_ = false;
-        
+
         // end gps request
         reqGpsActive_ = false;
 
@@ -440,10 +622,59 @@ public:
 
         // cancel schedule actions
         ResetTimers();
+    }
+
+public:
+
+    // Recover without a reboot.
+    //
+    // If a window is already committed to, it carries on, and a new gps lock
+    // is requested after it as usual.
+    //
+    // Otherwise the schedule is torn down and a new gps lock requested. The
+    // last gps data is kept, so time sync survives and a window can still
+    // coast on it if the new lock doesn't come in time.
+    void RestartInPlace()
+    {
+        if (running_ == false) { return; }
+
+        if (inLockout_ || WindowPlanActionIsPending(WindowPlan::Action::SCHEDULE_LOCK_OUT_START))
+        {
+            Mark("RESTART_IN_PLACE_WINDOW_CONTINUES");
+            LogNL();
+
+            return;
+        }
+
+        Mark("RESTART_IN_PLACE");
+
+        ScheduleData scheduleDataActive = scheduleDataActive_;
+
+        StopRunning();
+        running_ = true;
+
+        RecordInput(CopilotControlRecorder::Type::RESTART, 0, 0, startMin_);
+
+        scheduleDataActive_ = scheduleDataActive;
+
+        RequestNewGpsLockIfVccPolicyAllows();
+
+        // re-arm coasting from the kept data, with an empty cache this
+        // picks the most recent of the old fixes
+        if (scheduleDataActive_.timeAtGpsFix3DPlusSetUs || scheduleDataActive_.timeAtGpsFixTimeSetUs)
+        {
+            ScheduleApplyCache();
+        }
 
         LogNL();
     }
 
+    // Whether the voltage policy, as of the last window, lets the gps run.
+    bool GpsMayBeRequested()
+    {
+        return vccPolicy_.GpsMayBeRequested();
+    }
+
 
     /////////////////////////////////////////////////////////////////
     // GPS Events
@@ -474,6 +705,8 @@ public:
     {
         if (running_ == false) { return; }
 
+        RecordInputGps(CopilotControlRecorder::Type::GPS_3D_PLUS, gpsFix3DPlus);
+
         uint64_t timeNowUs = gpsFix3DPlus.timeAtPpsUs;
 
         if (reqGpsActive_ == true && inLockout_ == false)
@@ -490,6 +723,9 @@ public:
             ScheduleApplyTimeAndUpdateSchedule(scheduleDataActive_.gpsFix3DPlus,
                                                scheduleDataActive_.timeAtGpsFix3DPlusSetUs,
                                                true);
+
+            // gps is off and the window is set, likely a long quiet gap now
+            ConsiderDeepSleep();
         }
         else if (reqGpsActive_ == true && inLockout_ == true)
         {
@@ -524,6 +760,8 @@ public:
     {
         if (running_ == false) { return; }
 
+        RecordInputGps(CopilotControlRecorder::Type::GPS_TIME, gpsFixTime);
+
         uint64_t timeNowUs = gpsFixTime.timeAtPpsUs;
 
         if (reqGpsActive_ == true && inLockout_ == false)
@@ -567,6 +805,30 @@ public:
     }
 
 
+    /////////////////////////////////////////////////////////////////
+    // Input Recording
+    /////////////////////////////////////////////////////////////////
+
+    // Only inputs seen while running for real are kept, not those from
+    // tests or the window simulator.
+
+private:
+
+    void RecordInput(CopilotControlRecorder::Type type, uint8_t arg = 0, uint16_t ms = 0, uint32_t value = 0)
+    {
+        if (running_ == false || IsTesting()) { return; }
+
+        recorder_.Add(type, arg, ms, value);
+    }
+
+    void RecordInputGps(CopilotControlRecorder::Type type, const FixTime &fix)
+    {
+        if (running_ == false || IsTesting()) { return; }
+
+        recorder_.AddGps(type, fix);
+    }
+
+
     /////////////////////////////////////////////////////////////////
     // Schedule Lockout Events
     /////////////////////////////////////////////////////////////////
@@ -581,6 +843,8 @@ private:
 
         inLockout_ = true;
 
+        EvaluateVoltagePolicy();
+
         // run at 6MHz?
 
         LogNL();
@@ -599,11 +863,26 @@ private:
 
         inLockout_ = false;
 
+        // a gap can't outlast the window
+        AbandonRadioIdleGap();
+        energy_.OnGapAbandoned(PAL.Micros());
+        if (energy_.GetWindowGapCount())
+        {
+            energy_.Report();
+        }
+
         // run at 48MHz?
 
+        // quiet moment to write out the window's inputs
+        recorder_.Flush();
+
         // apply cached data
         ScheduleApplyCache();
 
+        // if the gps already got its lock during the window, there is
+        // nothing to do until the next window
+        ConsiderDeepSleep();
+
         LogNL();
     }
 
@@ -705,8 +984,21 @@ private:
             timerCoast_.SetCallback([this]{
                 Mark("COAST_TRIGGERED");
 
-                // cancel gps request
-                CancelRequestNewGpsLock();
+                // cancel gps request, unless the voltage policy skipped it,
+                // in which case the gps was never on, and coasting was the
+                // plan rather than a failure to lock
+                if (reqGpsActive_)
+                {
+                    CancelRequestNewGpsLock();
+
+                    // the cancel can lead the application to stop the scheduler
+                    // (gps recovery before reboot), nothing more to schedule then
+                    if (running_ == false) { return; }
+                }
+                else
+                {
+                    Mark("COAST_NO_GPS_REQ_TO_CANCEL");
+                }
 
                 // schedule now
                 ScheduleUpdateSchedule(false);
@@ -714,8 +1006,7 @@ private:
                 LogNL();
             });
 
-            const uint64_t DURATION_SEVEN_SECS_US = 7 * 1'000 * 1'000;
-            uint64_t COAST_LEAD_DURATION_US = DURATION_SEVEN_SECS_US;
+            uint64_t COAST_LEAD_DURATION_US = DURATION_COAST_LEAD_US;
             if (IsTesting())
             {
                 COAST_LEAD_DURATION_US = 400 * 1'000;
@@ -739,6 +1030,9 @@ private:
 
     void ScheduleUpdateSchedule(bool haveGpsLock)
     {
+        // a callback made on the way here may have stopped the scheduler
+        if (running_ == false) { return; }
+
         Mark("UPDATE_SCHEDULE");
 
         // get current time and time of next window
@@ -749,14 +1043,38 @@ private:
         Log("Time now : ", Time::GetNotionalTimeAtSystemUs(timeNowUs));
         PrintTimeAtDetails("Window At", timeNowUs, timeAtNextWindowStartUs);
 
+        // Join the window in progress if some of its periods can still be
+        // met, rather than waiting up to ten minutes for the next one.
+        //
+        // This only comes up when scheduling outside the rhythm of windows,
+        // like the first lock after boot. Otherwise scheduling happens at
+        // the end of a window, when no period of it is left.
+        uint64_t timeAtWindowStartUs = timeAtNextWindowStartUs;
+        uint8_t  periodFirst         = 1;
+        if (windowJoinEnabled_)
+        {
+            uint64_t durationLeadUs = GetWarmupDurationUs(timeAtNextWindowStartUs) + GetDurationJsUs();
+            uint8_t  periodJoin     = WindowPlan::CalculatePeriodFirstJoinable(timeNowUs, timeAtNextWindowStartUs, durationLeadUs);
+
+            if (periodJoin)
+            {
+                Mark("WINDOW_JOIN");
+                Log("Joining window in progress at period ", (int)periodJoin);
+
+                // may be before boot, only used to place the periods
+                timeAtWindowStartUs = timeAtNextWindowStartUs - DURATION_WINDOW_US;
+                periodFirst         = periodJoin;
+            }
+        }
+
         // fire event indicating that schedule about to be calculated
         CallbackScheduleNow(haveGpsLock);
 
         // prepare
-        ScheduleWindow(timeNowUs, timeAtNextWindowStartUs, haveGpsLock);
+        ScheduleWindow(timeNowUs, timeAtWindowStartUs, haveGpsLock, periodFirst);
     }
 
-    void ScheduleWindow(uint64_t timeNowUs, uint64_t timeAtWindowStartUs, bool haveGpsLock)
+    void ScheduleWindow(uint64_t timeNowUs, uint64_t timeAtWindowStartUs, bool haveGpsLock, uint8_t periodFirst = 1)
     {
         // configure slot behavior knowing we have a gps lock
         // 100ms
@@ -764,9 +1082,14 @@ private:
 
         // schedule actions based on when the next 10-min window is
         // 6ms
-        PrepareWindowSchedule(timeNowUs, timeAtWindowStartUs);
+        PrepareWindowSchedule(timeNowUs, timeAtWindowStartUs, periodFirst);
     }
 
+    inline static const uint64_t DURATION_WINDOW_US     = 10 * 60 * 1'000 * 1'000;
+    inline static const uint64_t DURATION_COAST_LEAD_US =  7 *      1'000 * 1'000;
+
+    bool windowJoinEnabled_ = true;
+
 
 
     // eyeballing the speed of scheduling at 6MHz, it's bad. like really bad.
@@ -801,32 +1124,53 @@ private:
 
     uint64_t CalculateTimeAtWindowStartUs(uint8_t windowStartMin, uint8_t gpsMin, uint8_t gpsSec, uint32_t gpsUs, uint64_t timeNowUs)
     {
-        // calculate how far into the future the start minute is from gps time
-        // by modelling a min/sec/ms clock and subtracting gps time from the window time.
-        // the window is nominally at <m>:01.000.
-        int8_t  minDiff = (int8_t)(windowStartMin - (gpsMin % 10));
-        int8_t  secDiff = (int8_t)(1              - gpsSec);
-        int32_t usDiff  = (int32_t)               - gpsUs;
+        return WindowPlan::CalculateTimeAtWindowStartUs(windowStartMin, gpsMin, gpsSec, gpsUs, timeNowUs);
+    }
 
-        // then, since you know how far into the future the window start is from the
-        // gps time, you add that duration onto the gps time and arrive at the window
-        // start time.
-        int64_t totalDiffUs = 0;
-        totalDiffUs += minDiff *      60 * 1'000 * 1'000;
-        totalDiffUs +=           secDiff * 1'000 * 1'000;
-        totalDiffUs +=                     usDiff;
 
-        // the exception is when the duration is negative, in which case you just add
-        // 10 minutes.
-        if (totalDiffUs < 0)
-        {
-            totalDiffUs += 10 * 60 * 1'000 * 1'000;
-        }
+    /////////////////////////////////////////////////////////////////
+    // Deep Sleep
+    /////////////////////////////////////////////////////////////////
+
+    // Once the gps is off and the window is scheduled, nothing happens
+    // until the next scheduled timer fires, typically TX_WARMUP minutes
+    // later.
+    //
+    // Deep sleep has a cost to enter and exit (clock restart, peripheral
+    // wake) and only has whole-second resolution, so only go when the gap
+    // is long enough to be worth it, and always wake early enough that the
+    // next event isn't late.
+    //
+    // The decision is made from a timer so that whatever called this gets to
+    // finish (logging, callbacks, etc) before the core stops.
+    void ConsiderDeepSleep()
+    {
+        if (IsTesting()) { return; }
 
-        // calculate window start time by offset from gps time now
-        uint64_t timeAtWindowStartUs = timeNowUs + totalDiffUs;
+        timerDeepSleep_.SetCallback([this]{
+            if (running_ == false || reqGpsActive_ || inLockout_) { return; }
 
-        return timeAtWindowStartUs;
+            const uint64_t DURATION_DEEP_SLEEP_WAKE_EARLY_US = 2 * 1'000 * 1'000;
+            const uint64_t DURATION_DEEP_SLEEP_MIN_US        = 10 * 1'000 * 1'000;
+
+            uint64_t timeNowUs         = PAL.Micros();
+            uint64_t timeAtNextEventUs = GetTimeAtNextPendingTimerUs();
+
+            if (timeAtNextEventUs == 0) { return; }
+
+            uint64_t timeAtWakeUs = timeAtNextEventUs - min(timeAtNextEventUs, DURATION_DEEP_SLEEP_WAKE_EARLY_US);
+
+            if (timeAtWakeUs > timeNowUs && timeAtWakeUs - timeNowUs >= DURATION_DEEP_SLEEP_MIN_US)
+            {
+                Mark("DEEP_SLEEP_START");
+                PrintTimeAtDetails("Wake At  ", timeNowUs, timeAtWakeUs);
+                PrintTimeAtDetails("Next At  ", timeNowUs, timeAtNextEventUs);
+                DeepSleepUntil(timeAtWakeUs);
+                Mark("DEEP_SLEEP_END");
+                LogNL();
+            }
+        });
+        timerDeepSleep_.TimeoutInMs(0);
     }
 
 
@@ -883,7 +1227,12 @@ public: // for test running
     void DoPeriodBehavior(SlotState *slotStateThis, uint64_t quitAfterMs, SlotState *slotStateNext = nullptr, const char *slotNameNext = ""){
         if (slotStateThis)
         {
-            if (slotStateThis->slotBehavior.msgSend != "none")
+            if (slotStateThis->slotBehavior.msgSend != "none" && vccPolicy_.SlotMayTransmit(slotStateThis->slot) == false)
+            {
+                Mark("SEND_NO_MSG_VCC_POLICY");
+                vccPolicy_.OnSlotShed();
+            }
+            else if (slotStateThis->slotBehavior.msgSend != "none")
             {
                 bool sendDefault = false;
 
@@ -911,7 +1260,7 @@ public: // for test running
                     {
                         if (slotStateThis->slotBehavior.canSendDefault)
                         {
-                            slotStateThis->slotBehavior.fnSendDefault(slotStateThis->slot, quitAfterMs);
+                            SendDefault(slotStateThis->slotBehavior, slotStateThis->slot, quitAfterMs);
                         }
                         else
                         {
@@ -941,10 +1290,42 @@ public: // for test running
             // nothing to do
         }
 
-        if (slotStateNext && slotNameNext && slotStateNext->slotBehavior.runJs)
+        if (slotStateNext && slotNameNext && slotStateNext->slotBehavior.runJs &&
+            vccPolicy_.GetLevel() < CopilotControlVoltagePolicy::Level::SKIP_WINDOW)
         {
-            Mark("JS_EXEC");
-            slotStateNext->jsRanOk = RunSlotJavaScript(slotNameNext);
+            uint64_t timeLimitMs = GetSlotJavaScriptLimitMs(slotStateNext->slot);
+
+            if (timeLimitMs)
+            {
+                Mark("JS_EXEC");
+
+                uint64_t timeStartUs = PAL.Micros();
+                slotStateNext->jsRanOk = RunSlotJavaScript(slotNameNext, timeLimitMs);
+                uint64_t durationUs = PAL.Micros() - timeStartUs;
+                uint64_t durationMs = durationUs / 1'000;
+
+                static const char *JS_SPAN_NAME_LIST[] = {
+                    "JS_SLOT0",
+                    "JS_SLOT1",
+                    "JS_SLOT2",
+                    "JS_SLOT3",
+                    "JS_SLOT4",
+                    "JS_SLOT5",
+                };
+                TraceSpan(timeStartUs, durationUs, JS_SPAN_NAME_LIST[min(slotStateNext->slot, (uint8_t)5)]);
+
+                jsBudget_.OnRun(slotStateNext->slot, durationMs);
+                RecordInput(CopilotControlRecorder::Type::JS_RESULT,
+                            slotStateNext->slot,
+                            (uint16_t)min(durationMs, (uint64_t)UINT16_MAX),
+                            slotStateNext->jsRanOk);
+            }
+            else
+            {
+                // sends the default, if any, as for a failed script
+                Mark("JS_NO_EXEC_BUDGET_EXPIRED");
+                slotStateNext->jsRanOk = false;
+            }
         }
         else
         {
@@ -1053,6 +1434,7 @@ public: // for test running
             .hasDefault     = defaultBehavior.set,
             .canSendDefault = canSendDefault,
             .fnSendDefault  = defaultBehavior.fn,
+            .defaultIsStub  = defaultBehavior.isStub,
         };
 
         return retVal;
@@ -1104,269 +1486,328 @@ public: // for test running
 
 
 
-    void PrepareWindowSchedule(uint64_t timeNowUs, uint64_t timeAtWindowStartUs)
+    // duration required for initial JS
+    uint64_t GetDurationJsUs()
+    {
+        const uint64_t DURATION_ONE_SECOND_US       = 1 * 1'000 * 1'000;
+        const uint64_t DURATION_JS_NOMINAL_US       = js_.GetScriptTimeLimitMs() * 1'000;
+        const uint64_t DURATION_JS_NOMINAL_FUDGE_US = DURATION_ONE_SECOND_US;
+
+        return DURATION_JS_NOMINAL_US + DURATION_JS_NOMINAL_FUDGE_US;
+    }
+
+    void PrepareWindowSchedule(uint64_t timeNowUs, uint64_t timeAtWindowStartUs, uint8_t periodFirst = 1)
     {
         Mark("PREPARE_WINDOW_SCHEDULE_START");
-        Log("PrepareWindowSchedule for ", TimeAt(timeAtWindowStartUs));
+        if (periodFirst <= 1)
+        {
+            Log("PrepareWindowSchedule for ", TimeAt(timeAtWindowStartUs));
+        }
+        else
+        {
+            Log("PrepareWindowSchedule joining at period ", (int)periodFirst);
+        }
 
-        // named durations
-        const uint64_t DURATION_ONE_SECOND_US     =      1 * 1'000 * 1'000;
-        const uint64_t DURATION_THIRTY_SECONDS_US =     30 * 1'000 * 1'000;
-        const uint64_t DURATION_TWO_MINUTES_US    = 2 * 60 * 1'000 * 1'000;
+        WindowPlan::Input in = {
+            .timeNowUs            = timeNowUs,
+            .timeAtWindowStartUs  = timeAtWindowStartUs,
+            .durationWantWarmupUs = GetWarmupDurationUs(max(timeAtWindowStartUs, timeNowUs)),
+            .durationJsUs         = GetDurationJsUs(),
+            .periodFirst          = periodFirst,
+            .testing              = IsTesting(),
+        };
+        for (uint8_t period = 1; period <= 5; ++period)
+        {
+            in.periodWillTransmit[period] = PeriodWillTransmit(period);
+        }
 
-        uint64_t DURATION_AVAIL_PRE_WINDOW_US = timeAtWindowStartUs - timeNowUs;
+        WindowPlan::Plan plan = WindowPlan::Calculate(in);
 
-        if (IsTesting())
+        // report
+        if (WindowPlan::GetTimeAtActionUs(plan, WindowPlan::Action::TX_WARMUP) == 0)
         {
-            DURATION_AVAIL_PRE_WINDOW_US = 0;
+            Log("Did NOT schedule TX_WARMUP, no transmissions scheduled");
         }
+        for (const auto &entry : plan.entryList)
+        {
+            Log("Scheduled ", TimeAt(entry.timeAtUs), " for ", WindowPlan::GetActionName(entry.action, entry.slot));
 
+            if (entry.action == WindowPlan::Action::TX_WARMUP)
+            {
+                Log("    ", Time::MakeDurationFromUs(plan.durationWantWarmupUs), " early wanted");
+                Log("    ", Time::MakeDurationFromUs(plan.durationAvailPreWindowUs), " early was possible");
+                Log("    ", Time::MakeDurationFromUs(plan.durationUseWarmupUs), " early used");
+            }
+            else if (entry.action == WindowPlan::Action::SCHEDULE_LOCK_OUT_START)
+            {
+                Log("    ", Time::MakeDurationFromUs(plan.durationWantPreWindowUs), " early wanted");
+                Log("    ", Time::MakeDurationFromUs(plan.durationAvailPreWindowUs), " early was possible");
+                Log("    ", Time::MakeDurationFromUs(plan.durationUsePreWindowUs), " early used");
+            }
+        }
 
-        // warmup start time
-        //
-        // schedule to start outside the protection of the window lockout.
-        // we don't need to protect against this getting interrupted or
-        // restarted way outside the window.
-        //
-        // the lockout period will protect more sensitive activities.
-        //
-        // No need to schedule if no transmissions will occur.
-        const uint64_t DURATION_WANT_WARMUP_US = DURATION_THIRTY_SECONDS_US;
-        const uint64_t DURATION_USE_WARMUP_US  = min(DURATION_WANT_WARMUP_US, DURATION_AVAIL_PRE_WINDOW_US);
-        const uint64_t TIME_AT_WARMUP_US       = timeAtWindowStartUs - DURATION_USE_WARMUP_US;
-        bool DO_WARMUP = false;
-        if (PeriodWillTransmit(1)) { DO_WARMUP = true; }
-        if (PeriodWillTransmit(2)) { DO_WARMUP = true; }
-        if (PeriodWillTransmit(3)) { DO_WARMUP = true; }
-        if (PeriodWillTransmit(4)) { DO_WARMUP = true; }
-        if (PeriodWillTransmit(5)) { DO_WARMUP = true; }
-
-
-        // duration required for initial JS
-        const uint64_t DURATION_JS_NOMINAL_US       = js_.GetScriptTimeLimitMs() * 1'000;
-        const uint64_t DURATION_JS_NOMINAL_FUDGE_US = DURATION_ONE_SECOND_US;
-        const uint64_t DURATION_JS_US               = DURATION_JS_NOMINAL_US + DURATION_JS_NOMINAL_FUDGE_US;
+        // voltage is evaluated at warmup, or at lockout start without one
+        vccEvaluated_ = false;
 
-        // duration lockout start
-        //
-        // This relates to protecting all window activities, starting first with
-        // running the initial js.
-        //
-        // Running the initial js needs to complete before the start of the window, so
-        // allocate time for that.
-        const uint64_t DURATION_WANT_PRE_WINDOW_US = DURATION_JS_US;
-        const uint64_t DURATION_USE_PRE_WINDOW_US  = min(DURATION_WANT_PRE_WINDOW_US, DURATION_AVAIL_PRE_WINDOW_US);
+        AbandonRadioIdleGap();
+        energy_.OnWindowStart();
+        jsBudget_.OnWindowStart(js_.GetScriptTimeLimitMs());
 
-        // Schedule Schedule Lock Out Start
-        const uint64_t TIME_AT_SCHEDULE_LOCK_OUT_START_US = timeAtWindowStartUs - DURATION_USE_PRE_WINDOW_US;
+        SetWindowPlan(plan);
 
-        // js start time
-        // (run immediately after lockout starts)
-        const uint64_t TIME_AT_JS_RUN_US = TIME_AT_SCHEDULE_LOCK_OUT_START_US;
+        Mark("PREPARE_WINDOW_SCHEDULE_END");
 
+        if (IsTesting() == false)
+        {
+            PrintStatus();
+        }
 
-        // Period start times
-        // There is no advantage to skipping scheduling period 5 when no TX will occur.
-        //
-        // The question arises because there's no JS to run, so if no TX, why even
-        // schedule it. It holds up window end event.
-        //
-        // Holding up the window end doesn't stop us getting a GPS lock.
-        // Holding up the window end also doesn't stop us warming up.
-        //
-        // Warmup Reasoning:
-        // - If there's tx in period 5, you have to wait, and warmup waits too.
-        // - If there's no tx, you wait until the period ends, but that's way before
-        //   the warmup period, so no savings.
-        uint64_t TIME_AT_PERIOD0_START_US = TIME_AT_JS_RUN_US;
-        uint64_t TIME_AT_PERIOD1_START_US = timeAtWindowStartUs;
-        uint64_t TIME_AT_PERIOD2_START_US = TIME_AT_PERIOD1_START_US + DURATION_TWO_MINUTES_US;
-        uint64_t TIME_AT_PERIOD3_START_US = TIME_AT_PERIOD2_START_US + DURATION_TWO_MINUTES_US;
-        uint64_t TIME_AT_PERIOD4_START_US = TIME_AT_PERIOD3_START_US + DURATION_TWO_MINUTES_US;
-        uint64_t TIME_AT_PERIOD5_START_US = TIME_AT_PERIOD4_START_US + DURATION_TWO_MINUTES_US;
-
-        if (IsTesting())
-        {
-            // Cause events all to fire in order quickly but with a unique
-            // time so that gps can be enabled after a specific period.
-            const uint64_t DURATION_GAP_US = 1;
-
-            // PERIOD 0, 1 are not required to override, they end up at window start
-            TIME_AT_PERIOD2_START_US = TIME_AT_PERIOD1_START_US + DURATION_GAP_US;
-            TIME_AT_PERIOD3_START_US = TIME_AT_PERIOD2_START_US + DURATION_GAP_US;
-            TIME_AT_PERIOD4_START_US = TIME_AT_PERIOD3_START_US + DURATION_GAP_US;
-            TIME_AT_PERIOD5_START_US = TIME_AT_PERIOD4_START_US + DURATION_GAP_US;
-        }
-
-        // Schedule GPS Req (and tx disable).
-        //
-        // GPS Req should happen after:
-        // - Final transmission period (GPS can't run at same time as TX).
-        //
-        // This is safe because:
-        // - GPS operation does not interfere with running js.
-        // - GPS new locks won't affect this window's data.
-        //
-        // Schedule event for the same start moment as the final
-        // transmission period itself, knowing that this event,
-        // which is scheduled second, will execute directly
-        // after, which is as early as possible, and what we want.
-        uint64_t TIME_AT_GPS_REQ_US = timeAtWindowStartUs;
-        bool TIME_AT_GPS_REQ_RESCHEDULED = false;
-        if (PeriodWillTransmit(1)) { TIME_AT_GPS_REQ_US = TIME_AT_PERIOD1_START_US; TIME_AT_GPS_REQ_RESCHEDULED = true; }
-        if (PeriodWillTransmit(2)) { TIME_AT_GPS_REQ_US = TIME_AT_PERIOD2_START_US; TIME_AT_GPS_REQ_RESCHEDULED = true; }
-        if (PeriodWillTransmit(3)) { TIME_AT_GPS_REQ_US = TIME_AT_PERIOD3_START_US; TIME_AT_GPS_REQ_RESCHEDULED = true; }
-        if (PeriodWillTransmit(4)) { TIME_AT_GPS_REQ_US = TIME_AT_PERIOD4_START_US; TIME_AT_GPS_REQ_RESCHEDULED = true; }
-        if (PeriodWillTransmit(5)) { TIME_AT_GPS_REQ_US = TIME_AT_PERIOD5_START_US; TIME_AT_GPS_REQ_RESCHEDULED = true; }
-
-        // Schedule Lock Out End.
-        //
-        // This event should come after the final period of work.
-        //
-        // It is no harm to end the lock out period after the 5th period
-        // even if no work gets done.
-        const uint64_t TIME_AT_SCHEDULE_LOCK_OUT_END_US = TIME_AT_PERIOD5_START_US;
+        t_.Reset();
+    }
 
 
+    /////////////////////////////////////////////////////////////////
+    // Window Plan Dispatch
+    /////////////////////////////////////////////////////////////////
 
+    // One timer steps through the plan, firing for each entry in turn.
+    //
+    // An action can replace the plan (eg the end of one window scheduling
+    // the next), so the generation is checked before carrying on with the
+    // old one.
+    void SetWindowPlan(const WindowPlan::Plan &plan)
+    {
+        windowPlan_ = plan;
+        windowPlanIdx_ = 0;
+        ++windowPlanGeneration_;
 
+        timerWindowPlan_.SetCallback([this]{
+            OnWindowPlanTimeout();
+        });
 
-        // Setup warmup.
-        if (DO_WARMUP)
-        {
-            timerTxWarmup_.SetCallback([this]{
-                Mark("TX_WARMUP");
-                StartRadioWarmup();
-                LogNL();
-            });
-            timerTxWarmup_.TimeoutAtUs(TIME_AT_WARMUP_US);
-            Log("Scheduled ", TimeAt(TIME_AT_WARMUP_US), " for TX_WARMUP");
-            Log("    ", Time::MakeDurationFromUs(DURATION_WANT_WARMUP_US), " early wanted");
-            Log("    ", Time::MakeDurationFromUs(DURATION_AVAIL_PRE_WINDOW_US), " early was possible");
-            Log("    ", Time::MakeDurationFromUs(DURATION_USE_WARMUP_US), " early used");
+        ArmWindowPlanTimer();
+    }
+
+    void ArmWindowPlanTimer()
+    {
+        if (windowPlanIdx_ < windowPlan_.entryList.size())
+        {
+            timerWindowPlan_.TimeoutAtUs(windowPlan_.entryList[windowPlanIdx_].timeAtUs);
         }
         else
         {
-            Log("Did NOT schedule TX_WARMUP, no transmissions scheduled");
+            timerWindowPlan_.Cancel();
         }
+    }
 
+    void OnWindowPlanTimeout()
+    {
+        if (windowPlanIdx_ >= windowPlan_.entryList.size()) { return; }
 
+        uint32_t generation = windowPlanGeneration_;
+        WindowPlan::Entry entry = windowPlan_.entryList[windowPlanIdx_];
+        ++windowPlanIdx_;
 
-        // Setup Schedule Lock Out Start.
-        timerScheduleLockOutStart_.SetCallback([this]{
+        DoWindowPlanAction(entry);
+
+        if (generation == windowPlanGeneration_)
+        {
+            ArmWindowPlanTimer();
+        }
+    }
+
+    void DoWindowPlanAction(const WindowPlan::Entry &entry)
+    {
+        switch (entry.action)
+        {
+        case WindowPlan::Action::TX_WARMUP:
+            Mark("TX_WARMUP");
+            if (EvaluateVoltagePolicy())
+            {
+                StartRadioWarmup();
+            }
+            LogNL();
+            break;
+
+        case WindowPlan::Action::SCHEDULE_LOCK_OUT_START:
             OnScheduleLockoutStart();
-        });
-        timerScheduleLockOutStart_.TimeoutAtUs(TIME_AT_SCHEDULE_LOCK_OUT_START_US);
-        Log("Scheduled ", TimeAt(TIME_AT_SCHEDULE_LOCK_OUT_START_US), " for SCHEDULE_LOCK_OUT_START");
-        Log("    ", Time::MakeDurationFromUs(DURATION_WANT_PRE_WINDOW_US), " early wanted");
-        Log("    ", Time::MakeDurationFromUs(DURATION_AVAIL_PRE_WINDOW_US), " early was possible");
-        Log("    ", Time::MakeDurationFromUs(DURATION_USE_PRE_WINDOW_US), " early used");
+            break;
 
+        case WindowPlan::Action::PERIOD_START:
+            DoPeriod(entry.slot);
+            break;
 
+        case WindowPlan::Action::RADIO_IDLE_GAP_START:
+            StartRadioIdleGap();
+            break;
 
-        // Setup GPS Req for start of window, initially.
-        //
-        // This lets the GPS Req beat Period1 to be executed in the event
-        // that no periods are transmitters (which hold up GPS Req).
-        //
-        // This is adjusted later.
-        // (this could all be done right now, but trying to keep this code
-        //  in the same order as execution)
-        timerTxDisableGpsEnable_.TimeoutAtUs(timeAtWindowStartUs);
-        Log("Scheduled ", TimeAt(timeAtWindowStartUs), " for TX_DISABLE_GPS_ENABLE (initial)");
+        case WindowPlan::Action::TX_REWARMUP:
+            EndRadioIdleGap(entry);
+            break;
 
+        case WindowPlan::Action::TX_DISABLE_GPS_ENABLE:
+            Mark("TX_DISABLE_GPS_ENABLE");
 
+            // disable transmitter
+            StopRadio();
 
-        // Setup Periods.
-        timerPeriod0_.SetCallback([this]{
-            Mark("PERIOD0_START");
-            DoPeriodBehavior(nullptr, 0, &slotState1_, "slot1");
-            Mark("PERIOD0_END");
-        });
-        timerPeriod0_.TimeoutAtUs(TIME_AT_PERIOD0_START_US);
-        Log("Scheduled ", TimeAt(TIME_AT_PERIOD0_START_US), " for PERIOD0_START");
+            // enable gps
+            RequestNewGpsLockIfVccPolicyAllows();
+            break;
 
-        timerPeriod1_.SetCallback([this]{
-            Mark("PERIOD1_START");
-            DoPeriodBehavior(&slotState1_, 0, &slotState2_, "slot2");
-            Mark("PERIOD1_END");
-        });
-        timerPeriod1_.TimeoutAtUs(TIME_AT_PERIOD1_START_US);
-        Log("Scheduled ", TimeAt(TIME_AT_PERIOD1_START_US), " for PERIOD1_START");
+        case WindowPlan::Action::SCHEDULE_LOCK_OUT_END:
+            OnScheduleLockoutEnd();
+            break;
+        }
+    }
 
-        timerPeriod2_.SetCallback([this]{
-            Mark("PERIOD2_START");
-            DoPeriodBehavior(&slotState2_, 0, &slotState3_, "slot3");
-            Mark("PERIOD2_END");
-        });
-        timerPeriod2_.TimeoutAtUs(TIME_AT_PERIOD2_START_US);
-        Log("Scheduled ", TimeAt(TIME_AT_PERIOD2_START_US), " for PERIOD2_START");
+    void DoPeriod(uint8_t period)
+    {
+        static const char *SLOT_NAME_LIST[] = {
+            "slot1",
+            "slot1",
+            "slot2",
+            "slot3",
+            "slot4",
+            "slot5",
+        };
 
-        timerPeriod3_.SetCallback([this]{
-            Mark("PERIOD3_START");
-            DoPeriodBehavior(&slotState3_, 0, &slotState4_, "slot4");
-            Mark("PERIOD3_END");
-        });
-        timerPeriod3_.TimeoutAtUs(TIME_AT_PERIOD3_START_US);
-        Log("Scheduled ", TimeAt(TIME_AT_PERIOD3_START_US), " for PERIOD3_START");
+        static const char *PERIOD_END_NAME_LIST[] = {
+            "PERIOD0_END",
+            "PERIOD1_END",
+            "PERIOD2_END",
+            "PERIOD3_END",
+            "PERIOD4_END",
+            "PERIOD5_END",
+        };
 
-        timerPeriod4_.SetCallback([this]{
-            Mark("PERIOD4_START");
-            DoPeriodBehavior(&slotState4_, 0, &slotState5_, "slot5");
-            Mark("PERIOD4_END");
-        });
-        timerPeriod4_.TimeoutAtUs(TIME_AT_PERIOD4_START_US);
-        Log("Scheduled ", TimeAt(TIME_AT_PERIOD4_START_US), " for PERIOD4_START");
+        Mark(WindowPlan::GetActionName(WindowPlan::Action::PERIOD_START, period));
 
-        timerPeriod5_.SetCallback([this]{
-            Mark("PERIOD5_START");
+        switch (period)
+        {
+        case 0:
+        {
+            // runs js for the first period, not period 1 when joining later
+            uint8_t periodFirst = min(max(windowPlan_.periodFirst, (uint8_t)1), (uint8_t)5);
+            DoPeriodBehavior(nullptr, 0, &GetSlotState(periodFirst), SLOT_NAME_LIST[periodFirst]);
+            break;
+        }
+        case 1: DoPeriodBehavior(&slotState1_, 0, &slotState2_, "slot2"); break;
+        case 2: DoPeriodBehavior(&slotState2_, 0, &slotState3_, "slot3"); break;
+        case 3: DoPeriodBehavior(&slotState3_, 0, &slotState4_, "slot4"); break;
+        case 4: DoPeriodBehavior(&slotState4_, 0, &slotState5_, "slot5"); break;
+        case 5:
+        {
             // tell sender to quit early
-            const uint64_t ONE_MINUTE_MS = 1 * 60 * 1'000;
-            DoPeriodBehavior(&slotState5_, ONE_MINUTE_MS);
-            Mark("PERIOD5_END");
-        });
-        timerPeriod5_.TimeoutAtUs(TIME_AT_PERIOD5_START_US);
-        Log("Scheduled ", TimeAt(TIME_AT_PERIOD5_START_US), " for PERIOD5_START");
+            DoPeriodBehavior(&slotState5_, WindowPlan::DURATION_TX_PERIOD5_US / 1'000);
+            break;
+        }
+        }
 
+        Mark(PERIOD_END_NAME_LIST[min(period, (uint8_t)5)]);
+    }
 
+    // zero if not in the current plan
+    uint64_t GetTimeAtWindowPlanActionUs(WindowPlan::Action action, uint8_t slot = 0)
+    {
+        return WindowPlan::GetTimeAtActionUs(windowPlan_, action, slot);
+    }
 
-        // Setup GPS Req (and tx disable).
-        timerTxDisableGpsEnable_.SetCallback([this]{
-            Mark("TX_DISABLE_GPS_ENABLE");
+    bool WindowPlanActionIsPending(WindowPlan::Action action)
+    {
+        bool retVal = false;
 
-            // disable transmitter
-            StopRadio();
+        for (size_t i = windowPlanIdx_; i < windowPlan_.entryList.size(); ++i)
+        {
+            if (windowPlan_.entryList[i].action == action)
+            {
+                retVal = true;
 
-            // enable gps
-            RequestNewGpsLock();
-        });
-        if (TIME_AT_GPS_REQ_RESCHEDULED)
+                break;
+            }
+        }
+
+        return retVal;
+    }
+
+
+    /////////////////////////////////////////////////////////////////
+    // Voltage Policy
+    /////////////////////////////////////////////////////////////////
+
+    // Sampled once per window, before the radio is warmed up, so VCC is
+    // seen without the transmitter's load, but after the gps is off.
+    //
+    // Returns whether any transmission may go ahead this window.
+    bool EvaluateVoltagePolicy()
+    {
+        if (vccEvaluated_ == false)
         {
-            timerTxDisableGpsEnable_.TimeoutAtUs(TIME_AT_GPS_REQ_US);
-            Log("Scheduled ", TimeAt(TIME_AT_GPS_REQ_US), " for TX_DISABLE_GPS_ENABLE (reschedule)");
+            vccEvaluated_ = true;
+
+            auto level = vccPolicy_.Evaluate(GetMilliVoltsVcc());
+            if (level >= CopilotControlVoltagePolicy::Level::SKIP_WINDOW)
+            {
+                Mark("WINDOW_SKIPPED_VCC_POLICY");
+                vccPolicy_.OnWindowSkip();
+            }
         }
 
+        return vccPolicy_.GetLevel() < CopilotControlVoltagePolicy::Level::SKIP_WINDOW;
+    }
 
 
-        // Setup Schedule Lock Out End.
-        timerScheduleLockOutEnd_.SetCallback([this]{
-            OnScheduleLockoutEnd();
-        });
-        timerScheduleLockOutEnd_.TimeoutAtUs(TIME_AT_SCHEDULE_LOCK_OUT_END_US);
-        Log("Scheduled ", TimeAt(TIME_AT_SCHEDULE_LOCK_OUT_END_US), " for SCHEDULE_LOCK_OUT_END");
+    /////////////////////////////////////////////////////////////////
+    // Radio Idle Gaps
+    /////////////////////////////////////////////////////////////////
 
+    // Happens at the end of a period, after its transmission and the js
+    // for the next slot.
+    void StartRadioIdleGap()
+    {
+        if (vccPolicy_.GetLevel() >= CopilotControlVoltagePolicy::Level::SKIP_WINDOW) { return; }
 
+        Mark("RADIO_IDLE_GAP_START");
+        StopRadio();
+        energy_.OnRadioOff(PAL.Micros());
 
+        idleGapActive_ = true;
+    }
 
+    // The window moved on with the gap still open, close its span in the
+    // trace without warming the radio back up.
+    void AbandonRadioIdleGap()
+    {
+        if (idleGapActive_ == false) { return; }
+        idleGapActive_ = false;
 
-        Mark("PREPARE_WINDOW_SCHEDULE_END");
+        TraceMark(PAL.Micros(), "RADIO_IDLE_GAP_END");
+    }
 
-        if (IsTesting() == false)
+    void EndRadioIdleGap(const WindowPlan::Entry &entry)
+    {
+        if (idleGapActive_ == false) { return; }
+        idleGapActive_ = false;
+
+        Mark("TX_REWARMUP");
+
+        // the gap has no mark of its own for its end, close its span here
+        TraceMark(PAL.Micros(), "RADIO_IDLE_GAP_END");
+
+        // a shed slot leaves the radio off until the next gap or window
+        if (vccPolicy_.SlotMayTransmit(entry.slot))
         {
-            PrintStatus();
-        }
+            uint64_t timeAtPeriodStartUs = GetTimeAtWindowPlanActionUs(WindowPlan::Action::PERIOD_START, entry.slot);
 
-        t_.Reset();
+            energy_.OnRewarmup(PAL.Micros(), timeAtPeriodStartUs - entry.timeAtUs);
+            StartRadioWarmup();
+        }
+        else
+        {
+            Mark("TX_REWARMUP_SKIPPED_VCC_POLICY");
+            energy_.OnRewarmup(PAL.Micros(), 0);
+        }
+        LogNL();
     }
 
 
@@ -1374,7 +1815,20 @@ public: // for test running
     // JavaScript Execution
     /////////////////////////////////////////////////////////////////
 
-    bool RunSlotJavaScript(const string &slotName)
+    // The slot's result is due at the start of its period. Testing fires
+    // periods back to back, so there is no deadline to hold to.
+    uint64_t GetSlotJavaScriptLimitMs(uint8_t slot)
+    {
+        uint64_t timeAtDeadlineUs = 0;
+        if (IsTesting() == false)
+        {
+            timeAtDeadlineUs = GetTimeAtWindowPlanActionUs(WindowPlan::Action::PERIOD_START, slot);
+        }
+
+        return jsBudget_.GetLimitMs(slot, PAL.Micros(), timeAtDeadlineUs);
+    }
+
+    bool RunSlotJavaScript(const string &slotName, uint64_t timeLimitMs)
     {
         bool retVal = true;
 
@@ -1392,7 +1846,7 @@ public: // for test running
         // invoke js
         if (IsTestingJsDisabled() == false)
         {
-            auto jsResult = js_.RunSlotJavaScript(slotName, &scheduleDataActive_.gpsFix3DPlus);
+            auto jsResult = js_.RunSlotJavaScript(slotName, &scheduleDataActive_.gpsFix3DPlus, timeLimitMs);
             retVal = jsResult.runOk;
         }
         else
@@ -1412,6 +1866,229 @@ public: // for test running
     }
 
 
+    /////////////////////////////////////////////////////////////////
+    // Window Simulation
+    /////////////////////////////////////////////////////////////////
+
+    // Works out what a window would do with the current configuration,
+    // without running it or waiting on real time.
+    //
+    // Slot behavior is calculated as it would be for the window, kept apart
+    // from the live slots. The window plan is then stepped through on a
+    // virtual clock, with estimates standing in for the work which takes
+    // real time (transmissions, js). Work in a period holds up what comes
+    // after it, as it would in flight.
+    //
+    // Times are relative to the window start. The voltage policy is assumed
+    // not to hold anything back.
+    struct SimCurrent
+    {
+        uint16_t radioOnMa = 25;
+        uint16_t txMa      = 40;
+        uint16_t jsMa      = 20;
+        uint16_t gpsMa     = 30;
+    };
+
+    struct SimResult
+    {
+        // "ms:EVENT ms:EVENT ..."
+        string timeline;
+
+        // "slot:msgSend:js|nojs ..."
+        string slotBehavior;
+
+        // "slot:ms ..."
+        string jsEstimateMs;
+
+        uint64_t warmupMs    = 0;
+        uint64_t txMs        = 0;
+        uint64_t radioIdleMs = 0;
+        uint64_t radioOffMs  = 0;
+        uint64_t jsMs        = 0;
+        uint64_t gpsMs       = 0;
+
+        uint32_t radioIdleMAs = 0;
+        uint32_t txMAs        = 0;
+        uint32_t jsMAs        = 0;
+        uint32_t gpsMAs       = 0;
+    };
+
+    // Defaults are given, rather than taken from the live ones, which
+    // belong to the window in progress (or to a test).
+    SimResult SimulateWindow(bool                haveGpsLock,
+                             uint64_t            durationLeadUs,
+                             const SimCurrent   &current,
+                             DefaultBehaviorList defaultBehaviorList)
+    {
+        SimResult retVal;
+
+        defaultBehaviorList.resize(5);
+
+        SlotBehavior slotBehaviorList[6];
+        uint64_t     jsEstimateMsList[6] = {};
+        for (uint8_t slot = 1; slot <= 5; ++slot)
+        {
+            string       slotName = string{"slot"} + to_string(slot);
+            SlotBehavior &sb      = slotBehaviorList[slot];
+
+            sb = CalculateSlotBehavior(slotName, haveGpsLock, defaultBehaviorList[slot - 1]);
+
+            // last measured if there is one, otherwise the full limit
+            if (sb.runJs)
+            {
+                const CopilotControlJsBudget::SlotRecord &rec = jsBudget_.GetSlotRecord(slot);
+
+                jsEstimateMsList[slot] = rec.ran ? rec.usedMs : js_.GetScriptTimeLimitMs();
+            }
+
+            string sep = slot == 1 ? "" : " ";
+            retVal.slotBehavior += sep + to_string(slot) + ":" + sb.msgSend + ":" + (sb.runJs ? "js" : "nojs");
+            retVal.jsEstimateMs += sep + to_string(slot) + ":" + to_string(jsEstimateMsList[slot]);
+        }
+
+        // plan, with the window starting the lead after now
+        WindowPlan::Input in = {
+            .timeNowUs            = 0,
+            .timeAtWindowStartUs  = durationLeadUs,
+            .durationWantWarmupUs = GetWarmupDurationUs(PAL.Micros() + durationLeadUs),
+            .durationJsUs         = GetDurationJsUs(),
+        };
+        for (uint8_t period = 1; period <= 5; ++period)
+        {
+            in.periodWillTransmit[period] = slotBehaviorList[period].msgSend != "none";
+        }
+
+        WindowPlan::Plan plan = WindowPlan::Calculate(in);
+
+        // virtual clock
+        uint64_t timeCursorUs = 0;
+
+        auto AddEvent = [&](const string &name){
+            int64_t msRel = ((int64_t)timeCursorUs - (int64_t)durationLeadUs) / 1'000;
+
+            retVal.timeline += (retVal.timeline.empty() ? "" : " ") + to_string(msRel) + ":" + name;
+        };
+
+        bool     radioOn             = false;
+        uint64_t timeAtRadioOnUs     = 0;
+        uint64_t timeAtWarmupUs      = 0;
+        uint64_t timeAtGapStartUs    = 0;
+        uint64_t timeAtGpsOnUs       = 0;
+        uint64_t durationRadioOnUs   = 0;
+        uint64_t durationRadioOffUs  = 0;
+        uint64_t durationWarmupUs    = 0;
+        uint64_t durationTxUs        = 0;
+        uint64_t durationJsUs        = 0;
+
+        auto RadioSet = [&](bool on){
+            if (on && radioOn == false)
+            {
+                timeAtRadioOnUs = timeCursorUs;
+            }
+            else if (on == false && radioOn)
+            {
+                durationRadioOnUs += timeCursorUs - timeAtRadioOnUs;
+            }
+
+            radioOn = on;
+        };
+
+        for (const auto &entry : plan.entryList)
+        {
+            timeCursorUs = max(timeCursorUs, entry.timeAtUs);
+
+            AddEvent(WindowPlan::GetActionName(entry.action, entry.slot));
+
+            switch (entry.action)
+            {
+            case WindowPlan::Action::TX_WARMUP:
+                RadioSet(true);
+                timeAtWarmupUs = timeCursorUs;
+                break;
+
+            case WindowPlan::Action::PERIOD_START:
+            {
+                uint8_t period = entry.slot;
+
+                if (period >= 1 && in.periodWillTransmit[period])
+                {
+                    if (timeAtWarmupUs)
+                    {
+                        durationWarmupUs += timeCursorUs - timeAtWarmupUs;
+                        timeAtWarmupUs = 0;
+                    }
+
+                    uint64_t durationUs = period == 5 ? WindowPlan::DURATION_TX_PERIOD5_US : WindowPlan::DURATION_TX_US;
+
+                    AddEvent("TX_SLOT" + to_string(period) + "_START");
+                    timeCursorUs += durationUs;
+                    durationTxUs += durationUs;
+                    AddEvent("TX_SLOT" + to_string(period) + "_END");
+                }
+
+                // js for the next slot runs with the radio off
+                uint8_t slotNext = period == 0 ? plan.periodFirst : period + 1;
+                if (slotNext <= 5 && slotBehaviorList[slotNext].runJs)
+                {
+                    bool radioOnBefore = radioOn;
+                    RadioSet(false);
+
+                    uint64_t durationUs = jsEstimateMsList[slotNext] * 1'000;
+
+                    AddEvent("JS_SLOT" + to_string(slotNext) + "_START");
+                    timeCursorUs += durationUs;
+                    durationJsUs += durationUs;
+                    AddEvent("JS_SLOT" + to_string(slotNext) + "_END");
+
+                    RadioSet(radioOnBefore);
+                }
+                break;
+            }
+
+            case WindowPlan::Action::RADIO_IDLE_GAP_START:
+                RadioSet(false);
+                timeAtGapStartUs = timeCursorUs;
+                break;
+
+            case WindowPlan::Action::TX_REWARMUP:
+                AddEvent("RADIO_IDLE_GAP_END");
+                durationRadioOffUs += timeCursorUs - timeAtGapStartUs;
+                RadioSet(true);
+                timeAtWarmupUs = timeCursorUs;
+                break;
+
+            case WindowPlan::Action::TX_DISABLE_GPS_ENABLE:
+                RadioSet(false);
+                timeAtGpsOnUs = timeCursorUs;
+                break;
+
+            default:
+                break;
+            }
+        }
+
+        // the gps has until the next window coasts without it
+        uint64_t timeAtGpsDeadlineUs = durationLeadUs + DURATION_WINDOW_US - DURATION_COAST_LEAD_US;
+        timeCursorUs = max(timeCursorUs, timeAtGpsDeadlineUs);
+        AddEvent("GPS_COAST_DEADLINE");
+
+        // durations and energy by phase
+        retVal.warmupMs    = durationWarmupUs / 1'000;
+        retVal.txMs        = durationTxUs / 1'000;
+        retVal.radioIdleMs = (durationRadioOnUs - min(durationRadioOnUs, durationTxUs)) / 1'000;
+        retVal.radioOffMs  = durationRadioOffUs / 1'000;
+        retVal.jsMs        = durationJsUs / 1'000;
+        retVal.gpsMs       = (timeAtGpsDeadlineUs - min(timeAtGpsDeadlineUs, timeAtGpsOnUs)) / 1'000;
+
+        retVal.radioIdleMAs = (uint32_t)(retVal.radioIdleMs * current.radioOnMa / 1'000);
+        retVal.txMAs        = (uint32_t)(retVal.txMs        * current.txMa      / 1'000);
+        retVal.jsMAs        = (uint32_t)(retVal.jsMs        * current.jsMa      / 1'000);
+        retVal.gpsMAs       = (uint32_t)(retVal.gpsMs       * current.gpsMa     / 1'000);
+
+        return retVal;
+    }
+
+
     /////////////////////////////////////////////////////////////////
     // Testing
     /////////////////////////////////////////////////////////////////
@@ -1420,6 +2097,7 @@ public: // for test running
     void TestPrepareWindowSchedule();
     void TestConfigureWindowSlotBehavior();
     void TestCalculateTimeAtWindowStartUs(bool fullSweep = false);
+    void TestBenchmarkWindowPath();
 
 
 
@@ -1431,26 +2109,39 @@ public: // for test running
     {
         timerCoast_.Cancel();
         timerCoast_.SetVisibleInTimeline(false);
-        timerScheduleLockOutStart_.Cancel();
-        timerScheduleLockOutStart_.SetVisibleInTimeline(false);
-        timerPeriod0_.Cancel();
-        timerPeriod0_.SetVisibleInTimeline(false);
-        timerTxWarmup_.Cancel();
-        timerTxWarmup_.SetVisibleInTimeline(false);
-        timerPeriod1_.Cancel();
-        timerPeriod1_.SetVisibleInTimeline(false);
-        timerPeriod2_.Cancel();
-        timerPeriod2_.SetVisibleInTimeline(false);
-        timerPeriod3_.Cancel();
-        timerPeriod3_.SetVisibleInTimeline(false);
-        timerPeriod4_.Cancel();
-        timerPeriod4_.SetVisibleInTimeline(false);
-        timerPeriod5_.Cancel();
-        timerPeriod5_.SetVisibleInTimeline(false);
-        timerTxDisableGpsEnable_.Cancel();
-        timerTxDisableGpsEnable_.SetVisibleInTimeline(false);
-        timerScheduleLockOutEnd_.Cancel();
-        timerScheduleLockOutEnd_.SetVisibleInTimeline(false);
+        timerWindowPlan_.Cancel();
+        timerWindowPlan_.SetVisibleInTimeline(false);
+        timerDeepSleep_.Cancel();
+        timerDeepSleep_.SetVisibleInTimeline(false);
+
+        // nothing remains pending, but the plan stays readable
+        windowPlanIdx_ = windowPlan_.entryList.size();
+        ++windowPlanGeneration_;
+        AbandonRadioIdleGap();
+    }
+
+    // zero if nothing pending
+    uint64_t GetTimeAtNextPendingTimerUs()
+    {
+        vector<Timer *> timerList = {
+            &timerCoast_,
+            &timerWindowPlan_,
+        };
+
+        uint64_t retVal = 0;
+
+        for (Timer *timer : timerList)
+        {
+            if (timer->IsPending())
+            {
+                if (retVal == 0 || timer->GetTimeoutAtUs() < retVal)
+                {
+                    retVal = timer->GetTimeoutAtUs();
+                }
+            }
+        }
+
+        return retVal;
     }
 
     // a positive shift means move the current time forward, which will
@@ -1471,69 +2162,29 @@ public: // for test running
         // change notional time
         Time::SetNotionalUs(notionalTimeNowUs, timeNowUs);
 
-        // get list of timers in mostly-correct order, such that if they were
-        // stable sorted by timeout they'd be in timeout order (which takes
-        // into consideration the purposeful matching of expiry times that
-        // some timers do).
-        vector<Timer *> timerList = {
-            &timerCoast_,
-            &timerTxWarmup_,
-            &timerScheduleLockOutStart_,
-            &timerPeriod0_,
-            &timerPeriod1_,
-            &timerPeriod2_,
-            &timerPeriod3_,
-            &timerPeriod4_,
-            &timerPeriod5_,
-            &timerTxDisableGpsEnable_,
-            &timerScheduleLockOutEnd_,
-        };
-
-        // take a copy of the original order for reporting
-        vector<Timer *> timerListOriginalOrder = timerList;
-
-        // create helper to extract the timeouts into a list
-        auto GetTimeoutAtUsList = [](const vector<Timer *> &timerList){
-            vector<uint64_t> timeoutAtUsList;
-
-            for (const Timer *timer : timerList)
-            {
-                timeoutAtUsList.push_back(timer->GetTimeoutAtUs());
-            }
-
-            return timeoutAtUsList;
-        };
-
-        // get a list of the original timeouts
-        vector<uint64_t> timeoutAtUsListOrig = GetTimeoutAtUsList(timerListOriginalOrder);
-
-        // sort while retaining order of equal items
-        stable_sort(timerList.begin(), timerList.end(), [](auto t1, auto t2){
-            return t1->GetTimeoutAtUs() < t2->GetTimeoutAtUs();
-        });
+        // shift the coast timer
+        uint64_t timeAtCoastWasUs = timerCoast_.GetTimeoutAtUs();
+        if (timerCoast_.IsPending())
+        {
+            timerCoast_.TimeoutAtUs(ShiftTimeAtUs(timeAtCoastWasUs, durationUs));
+        }
+        uint64_t timeAtCoastNowUs = timerCoast_.GetTimeoutAtUs();
 
-        // iterate sorted-by-expiry timer list, if pending, change timer by offset.
-        // by iterating in sorted order, we ensure that timers that had the same expiry
-        // end up on the same expiry again, in the same first-setter-wins order.
-        // if time is moving forward, expiry should happen sooner, so deduct from expiry.
-        for (Timer *timer : timerList)
+        // shift the pending part of the plan.
+        // every entry moves by the same amount, so the plan stays in order,
+        // and entries which shared a time still do.
+        vector<uint64_t> timeAtWasUsList;
+        for (auto &entry : windowPlan_.entryList)
         {
-            if (timer->IsPending())
-            {
-                if (durationUs > 0)
-                {
-                    // ensure that the timer doesn't wrap around when subtracted
-                    timer->TimeoutAtUs(timer->GetTimeoutAtUs() - min((uint64_t)durationUs, timer->GetTimeoutAtUs()));
-                }
-                else
-                {
-                    timer->TimeoutAtUs(timer->GetTimeoutAtUs() - durationUs);
-                }
-            }
+            timeAtWasUsList.push_back(entry.timeAtUs);
         }
+        for (size_t i = windowPlanIdx_; i < windowPlan_.entryList.size(); ++i)
+        {
+            auto &entry = windowPlan_.entryList[i];
 
-        // get a list of the modified timeouts
-        vector<uint64_t> timeoutAtUsListNew = GetTimeoutAtUsList(timerListOriginalOrder);
+            entry.timeAtUs = ShiftTimeAtUs(entry.timeAtUs, durationUs);
+        }
+        ArmWindowPlanTimer();
 
         // report on change to timers
         auto Report = [](string name, uint8_t nameWidthTotal, uint64_t timeAtWasUs, uint64_t timeAtNowUs, uint64_t timeNowUs){
@@ -1554,14 +2205,34 @@ public: // for test running
 
         LogNL();
         Log("Shift Time Report");
-        uint8_t nameWidthTotal = strlen(timerScheduleLockOutStart_.GetName());
-        for (size_t i = 0; i < timerListOriginalOrder.size(); ++i)
+        uint8_t nameWidthTotal = strlen("SCHEDULE_LOCK_OUT_START");
+        Report(timerCoast_.GetName(), nameWidthTotal, timeAtCoastWasUs, timeAtCoastNowUs, timeNowUs);
+        for (size_t i = 0; i < windowPlan_.entryList.size(); ++i)
         {
-            Timer *timer = timerListOriginalOrder[i];
-            Report(timer->GetName(), nameWidthTotal, timeoutAtUsListOrig[i], timeoutAtUsListNew[i], timeNowUs);
+            const auto &entry = windowPlan_.entryList[i];
+
+            Report(WindowPlan::GetActionName(entry.action, entry.slot), nameWidthTotal, timeAtWasUsList[i], entry.timeAtUs, timeNowUs);
         }
     }
 
+    // if time is moving forward, expiry should happen sooner, so deduct from expiry.
+    static uint64_t ShiftTimeAtUs(uint64_t timeAtUs, int64_t durationUs)
+    {
+        uint64_t retVal = timeAtUs;
+
+        if (durationUs > 0)
+        {
+            // ensure that the time doesn't wrap around when subtracted
+            retVal = timeAtUs - min((uint64_t)durationUs, timeAtUs);
+        }
+        else
+        {
+            retVal = timeAtUs - durationUs;
+        }
+
+        return retVal;
+    }
+
     void PrintTimeAtDetails(string title, uint64_t timeNowUs, uint64_t timeAtUs)
     {
         LogNNL(StrUtl::PadRight(title, ' ', title.size()));
@@ -1600,31 +2271,21 @@ public: // for test running
             
             PrintTimeAtDetails("Window At        ", timeNowUs, timeAtUpcomingOrCurrentWindowStartUs);
 
-            bool windowScheduled = inLockout_ || timerScheduleLockOutStart_.IsPending();
+            bool windowScheduled = inLockout_ || WindowPlanActionIsPending(WindowPlan::Action::SCHEDULE_LOCK_OUT_START);
             Log("Window Scheduled : ", windowScheduled ? "Yes" : "No");
             if (windowScheduled)
             {
-                uint8_t titleWidth = 2 + strlen(timerScheduleLockOutStart_.GetName());
+                uint8_t titleWidth = 2 + strlen("SCHEDULE_LOCK_OUT_START");
                 Log("In Window        : ", inLockout_ ? "Yes" : "No");
 
-                vector<Timer *> timerList = {
-                    &timerTxWarmup_,
-                    &timerScheduleLockOutStart_,
-                    &timerPeriod0_,
-                    &timerPeriod1_,
-                    &timerPeriod2_,
-                    &timerPeriod3_,
-                    &timerPeriod4_,
-                    &timerPeriod5_,
-                    &timerTxDisableGpsEnable_,
-                    &timerScheduleLockOutEnd_,
-                };
-
-                for (Timer *timer : timerList)
+                for (size_t i = 0; i < windowPlan_.entryList.size(); ++i)
                 {
-                    string status = timer->IsPending() ? "pend" : "done";
+                    const auto &entry = windowPlan_.entryList[i];
 
-                    PrintTimeAtDetails(StrUtl::PadRight(string{"  "} + timer->GetName(), ' ', titleWidth) + " (" + status + ")", timeNowUs, timer->GetTimeoutAtUs());
+                    string name   = WindowPlan::GetActionName(entry.action, entry.slot);
+                    string status = i >= windowPlanIdx_ ? "pend" : "done";
+
+                    PrintTimeAtDetails(StrUtl::PadRight(string{"  "} + name, ' ', titleWidth) + " (" + status + ")", timeNowUs, entry.timeAtUs);
                 }
             }
         }
@@ -1744,6 +2405,7 @@ public: // for test running
     void Mark(const char *str)
     {
         uint64_t timeUs = t_.Event(str);
+        TraceMark(timeUs, str);
 
         Log("[", TimeAt(timeUs), "] ", str);
 
@@ -1753,6 +2415,31 @@ public: // for test running
         }
     }
 
+    // test runs are kept out of the trace, it holds what really ran
+    void TraceMark(uint64_t timeUs, const char *name)
+    {
+        if (IsTesting() == false)
+        {
+            trace_.Mark(timeUs, name);
+        }
+    }
+
+    void TraceSpan(uint64_t timeStartUs, uint64_t durationUs, const char *name)
+    {
+        if (IsTesting() == false)
+        {
+            trace_.Span(timeStartUs, durationUs, name);
+        }
+    }
+
+    void TraceCounter(const char *name, uint32_t value)
+    {
+        if (IsTesting() == false)
+        {
+            trace_.Counter(PAL.Micros(), name, value);
+        }
+    }
+
     string TimeAt(uint64_t timeUs)
     {
         return Time::GetNotionalTimeAtSystemUs(timeUs);
@@ -1871,6 +2558,12 @@ public: // for test running
             TestConfigureWindowSlotBehavior();
         }, { .argCount = 0, .help = "run test suite for slot behavior"});
 
+        Shell::AddCommand("join", [this](vector<string> argList){
+            windowJoinEnabled_ = (bool)atoi(argList[0].c_str());
+
+            Log("Window join ", windowJoinEnabled_ ? "enabled" : "disabled");
+        }, { .argCount = 1, .help = "join window in progress on late lock <0|1>"});
+
         Shell::AddCommand("calc", [this](vector<string> argList){
             bool fullSweep = false;
             if (argList.size() == 1)
@@ -1880,6 +2573,10 @@ public: // for test running
             TestCalculateTimeAtWindowStartUs(fullSweep);
         }, { .argCount = -1, .help = "run test suite for window start time [fullSweep=0]"});
 
+        Shell::AddCommand("bench", [this](vector<string> argList){
+            TestBenchmarkWindowPath();
+        }, { .argCount = 0, .help = "benchmark window path calls needing picoinf"});
+
         Shell::AddCommand("lock", [this](vector<string> argList){
             string type = argList[0];
 
@@ -1964,10 +2661,90 @@ public: // for test running
         Shell::AddCommand("runjs", [this](vector<string> argList){
             int slotNum = atoi(argList[0].c_str());
 
-            RunSlotJavaScript("slot" + to_string(slotNum));
+            RunSlotJavaScript("slot" + to_string(slotNum), js_.GetScriptTimeLimitMs());
         }, { .argCount = 1, .help = "run js via RunSlotJavaScript() for slot <num>"});
     }
 
+    void SetupJSON()
+    {
+        JSONMsgRouter::RegisterHandler("REQ_SIMULATE_WINDOW", [this](auto &in, auto &out){
+            Log("REQ_SIMULATE_WINDOW");
+
+            out["type"] = "REP_SIMULATE_WINDOW";
+
+            // slot behavior is shared with the running schedule
+            if (running_)
+            {
+                out["ok"]  = false;
+                out["err"] = "Scheduler running, simulate in configuration mode";
+
+                return;
+            }
+
+            auto HasKey = [&](const char *key){
+                vector<const char *> keyList = { key };
+                return JSON::HasKeyList(in, keyList);
+            };
+
+            // how long before the window it gets scheduled, defaults to
+            // the start of the prior window's final period
+            uint64_t leadMs = 2 * 60 * 1'000;
+            if (HasKey("leadMs"))
+            {
+                leadMs = (uint64_t)in["leadMs"];
+            }
+
+            // estimates, none of these are measured
+            SimCurrent current;
+            current.radioOnMa = energy_.GetRadioOnMa();
+            if (HasKey("txMa"))  { current.txMa  = (uint16_t)in["txMa"];  }
+            if (HasKey("jsMa"))  { current.jsMa  = (uint16_t)in["jsMa"];  }
+            if (HasKey("gpsMa")) { current.gpsMa = (uint16_t)in["gpsMa"]; }
+
+            // the timeline also as a chrome trace, times from the simulation start
+            bool wantTrace = HasKey("trace") && (bool)in["trace"];
+
+            out["ok"]        = true;
+            out["leadMs"]    = leadMs;
+            out["radioOnMa"] = current.radioOnMa;
+            out["txMa"]      = current.txMa;
+            out["jsMa"]      = current.jsMa;
+            out["gpsMa"]     = current.gpsMa;
+
+            for (bool haveGpsLock : { true, false })
+            {
+                // slot behavior, defaults as the application would set them for the window
+                SimResult sr = SimulateWindow(haveGpsLock, leadMs * 1'000, current, fnCbGetDefaultBehaviorList_(haveGpsLock));
+
+                string prefix = haveGpsLock ? "lock" : "noLock";
+
+                out[prefix + "Timeline"]     = sr.timeline;
+                if (wantTrace)
+                {
+                    out[prefix + "Trace"] = CopilotControlTrace::MakeChromeTraceFromTimeline(sr.timeline, (int64_t)leadMs);
+                }
+                out[prefix + "SlotBehavior"] = sr.slotBehavior;
+                out[prefix + "JsEstimateMs"] = sr.jsEstimateMs;
+
+                out[prefix + "WarmupMs"]    = sr.warmupMs;
+                out[prefix + "TxMs"]        = sr.txMs;
+                out[prefix + "RadioIdleMs"] = sr.radioIdleMs;
+                out[prefix + "RadioOffMs"]  = sr.radioOffMs;
+                out[prefix + "JsMs"]        = sr.jsMs;
+                out[prefix + "GpsMs"]       = sr.gpsMs;
+
+                out[prefix + "RadioIdleMAs"] = sr.radioIdleMAs;
+                out[prefix + "TxMAs"]        = sr.txMAs;
+                out[prefix + "JsMAs"]        = sr.jsMAs;
+                out[prefix + "GpsMAs"]       = sr.gpsMAs;
+                out[prefix + "TotalMAs"]     = sr.radioIdleMAs + sr.txMAs + sr.jsMAs + sr.gpsMAs;
+            }
+
+            LogNL();
+        });
+    }
+
+
 
 // private:
 
@@ -1979,16 +2756,24 @@ public: // for test running
     SlotState slotState4_ = { 4 };
     SlotState slotState5_ = { 5 };
 
-    Timer timerTxWarmup_             = {"TIMER_TX_WARMUP"};
-    Timer timerScheduleLockOutStart_ = {"TIMER_SCHEDULE_LOCK_OUT_START"};
-    Timer timerPeriod0_              = {"TIMER_PERIOD0_START"};
-    Timer timerPeriod1_              = {"TIMER_PERIOD1_START"};
-    Timer timerPeriod2_              = {"TIMER_PERIOD2_START"};
-    Timer timerPeriod3_              = {"TIMER_PERIOD3_START"};
-    Timer timerPeriod4_              = {"TIMER_PERIOD4_START"};
-    Timer timerPeriod5_              = {"TIMER_PERIOD5_START"};
-    Timer timerTxDisableGpsEnable_   = {"TIMER_TX_DISABLE_GPS_ENABLE"};
-    Timer timerScheduleLockOutEnd_   = {"TIMER_SCHEDULE_LOCK_OUT_END"};
+    WindowPlan::Plan windowPlan_;
+    size_t           windowPlanIdx_        = 0;
+    uint32_t         windowPlanGeneration_ = 0;
+    Timer            timerWindowPlan_      = {"TIMER_WINDOW_PLAN"};
+
+    Timer timerDeepSleep_ = {"TIMER_DEEP_SLEEP"};
+
+    CopilotControlVoltagePolicy vccPolicy_;
+    bool                        vccEvaluated_ = false;
+
+    bool                 idleGapActive_ = false;
+    CopilotControlEnergy energy_;
+
+    CopilotControlJsBudget jsBudget_;
+
+    CopilotControlRecorder recorder_;
+
+    CopilotControlTrace trace_;
 
     Timeline t_;
 
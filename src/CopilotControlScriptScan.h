@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string_view>
+using namespace std;
+
+
+// Finds what a slot script makes use of, by looking for text outside of
+// line comments.
+//
+// Done for each slot as every window is prepared, so the script is looked
+// through in place rather than split up into copies.
+//
+// Kept free of hardware so it can be run on the host.
+class CopilotControlScriptScan
+{
+public:
+
+    static bool HasNonCommentedSubString(string_view script, string_view substr)
+    {
+        bool retVal = false;
+
+        size_t pos = 0;
+        while (pos <= script.size() && retVal == false)
+        {
+            size_t posEnd = script.find('\n', pos);
+            if (posEnd == string_view::npos) { posEnd = script.size(); }
+
+            string_view line = script.substr(pos, posEnd - pos);
+
+            // chop off any commented part of the line
+            line = line.substr(0, line.find("//"));
+
+            retVal = line.find(substr) != string_view::npos;
+
+            pos = posEnd + 1;
+        }
+
+        return retVal;
+    }
+};
\ No newline at end of file
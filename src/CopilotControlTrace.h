@@ -0,0 +1,201 @@
+#pragma once
+
+#include "CopilotControlTraceFormat.h"
+#include "JSONMsgRouter.h"
+#include "Log.h"
+#include "Shell.h"
+#include "Utl.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+// Keeps the scheduler's recent marks, spans, and state changes, and
+// exports them in Chrome Trace Event Format (see CopilotControlTraceFormat)
+// for viewing in Perfetto or chrome://tracing.
+//
+// Events are kept in a fixed ring in RAM, so only the last few windows
+// are held. Names are not copied, they must be string literals.
+class CopilotControlTrace
+{
+public:
+
+    enum class Kind : uint8_t
+    {
+        MARK,
+        SPAN,       // value = duration us
+        COUNTER,    // value = counter value
+    };
+
+    struct Event
+    {
+        uint64_t    timeUs = 0;
+        const char *name   = "";
+        uint32_t    value  = 0;
+        Kind        kind   = Kind::MARK;
+    };
+
+
+public:
+
+    CopilotControlTrace()
+    {
+        eventList_.resize(EVENT_COUNT_MAX);
+
+        SetupShell();
+        SetupJSON();
+    }
+
+    void Mark(uint64_t timeUs, const char *name)
+    {
+        Add({ timeUs, name, 0, Kind::MARK });
+    }
+
+    void Span(uint64_t timeStartUs, uint64_t durationUs, const char *name)
+    {
+        Add({ timeStartUs, name, (uint32_t)min(durationUs, (uint64_t)UINT32_MAX), Kind::SPAN });
+    }
+
+    void Counter(uint64_t timeUs, const char *name, uint32_t value)
+    {
+        Add({ timeUs, name, value, Kind::COUNTER });
+    }
+
+    void Clear()
+    {
+        seqNext_ = 0;
+    }
+
+    // events are numbered from 0 since boot (or clear), the ring holds
+    // those from GetSeqFirst() up to but not including GetSeqNext()
+    uint32_t GetSeqFirst()
+    {
+        return seqNext_ - min(seqNext_, (uint32_t)EVENT_COUNT_MAX);
+    }
+
+    uint32_t GetSeqNext()
+    {
+        return seqNext_;
+    }
+
+    // A complete trace document of the held events from seqFirst on, at
+    // most countMax of them.
+    string MakeChromeTrace(uint32_t seqFirst, uint32_t countMax, uint32_t *seqNextOut = nullptr)
+    {
+        seqFirst = max(seqFirst, GetSeqFirst());
+
+        uint32_t seqLast = min(seqNext_, seqFirst + countMax);
+
+        vector<string> eventJsonList;
+        for (uint32_t seq = seqFirst; seq < seqLast; ++seq)
+        {
+            eventJsonList.push_back(MakeChromeTraceEvent(eventList_[seq % EVENT_COUNT_MAX]));
+        }
+
+        if (seqNextOut)
+        {
+            *seqNextOut = max(seqFirst, seqLast);
+        }
+
+        return CopilotControlTraceFormat::MakeDocument(eventJsonList);
+    }
+
+    // Converts a "ms:EVENT ms:EVENT ..." timeline, as the window simulator
+    // makes, into a trace document.
+    static string MakeChromeTraceFromTimeline(const string &timeline, int64_t timeOffsetMs)
+    {
+        return CopilotControlTraceFormat::MakeDocumentFromTimeline(timeline, timeOffsetMs);
+    }
+
+    void Report()
+    {
+        Log("Trace");
+        Log("- held    : ", GetSeqNext() - GetSeqFirst(), " / ", EVENT_COUNT_MAX, " events");
+        Log("- seq     : ", GetSeqFirst(), " to ", GetSeqNext());
+        Log("- dropped : ", Commas(GetSeqFirst()), " events overwritten");
+    }
+
+
+private:
+
+    void Add(const Event &event)
+    {
+        eventList_[seqNext_ % EVENT_COUNT_MAX] = event;
+
+        ++seqNext_;
+    }
+
+    static string MakeChromeTraceEvent(const Event &event)
+    {
+        string retVal;
+
+        switch (event.kind)
+        {
+        case Kind::MARK:
+            retVal = CopilotControlTraceFormat::MakeMark(event.timeUs, event.name);
+            break;
+
+        case Kind::SPAN:
+            retVal = CopilotControlTraceFormat::MakeSpan(event.timeUs, event.value, event.name);
+            break;
+
+        case Kind::COUNTER:
+            retVal = CopilotControlTraceFormat::MakeCounter(event.timeUs, event.name, event.value);
+            break;
+        }
+
+        return retVal;
+    }
+
+
+private:
+
+    void SetupShell()
+    {
+        Shell::AddCommand("app.ss.cc.trace", [this](vector<string> argList){
+            Report();
+        }, { .argCount = 0, .help = "report scheduler trace"});
+
+        Shell::AddCommand("app.ss.cc.trace.dump", [this](vector<string> argList){
+            // one event per line, to copy into a .json file
+            for (const auto &line : Split(MakeChromeTrace(GetSeqFirst(), EVENT_COUNT_MAX), "\n"))
+            {
+                Log(line);
+            }
+        }, { .argCount = 0, .help = "print scheduler trace as chrome trace json"});
+
+        Shell::AddCommand("app.ss.cc.trace.clear", [this](vector<string> argList){
+            Clear();
+            Report();
+        }, { .argCount = 0, .help = "clear scheduler trace"});
+    }
+
+    void SetupJSON()
+    {
+        // a page at a time, keep asking from seqNext until seqNext stops
+        // moving, then merge the traceEvents of each page
+        JSONMsgRouter::RegisterHandler("REQ_GET_TRACE", [this](auto &in, auto &out){
+            out["type"] = "REP_GET_TRACE";
+
+            uint32_t seqNext = 0;
+            string trace = MakeChromeTrace((uint32_t)in["seq"], PAGE_EVENT_COUNT, &seqNext);
+
+            out["seqFirst"] = GetSeqFirst();
+            out["seqNext"]  = seqNext;
+            out["seqEnd"]   = GetSeqNext();
+            out["trace"]    = trace;
+        });
+    }
+
+
+private:
+
+    // a window is roughly 80 events
+    inline static const uint32_t EVENT_COUNT_MAX  = 256;
+    inline static const uint32_t PAGE_EVENT_COUNT = 32;
+
+    vector<Event> eventList_;
+    uint32_t      seqNext_ = 0;
+};
\ No newline at end of file
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+// Formats scheduler events in Chrome Trace Event Format, for viewing in
+// Perfetto or chrome://tracing. Kept free of hardware so it is checked on
+// the host, CopilotControlTrace holds the events on the device.
+//
+// - a mark ending in _START or _END becomes the begin or end of an async
+//   span named without the suffix (eg PERIOD1, PREPARE_WINDOW_SCHEDULE)
+// - any other mark becomes an instant event
+// - a span becomes a complete event (eg JS_SLOT2)
+// - a counter becomes a counter track (eg radio, clockHigh, gpsReq)
+class CopilotControlTraceFormat
+{
+public:
+
+    // Wraps formatted events into a complete trace document.
+    static string MakeDocument(const vector<string> &eventJsonList)
+    {
+        string retVal;
+
+        retVal += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        retVal += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"CopilotControl\"}}";
+        for (const auto &eventJson : eventJsonList)
+        {
+            retVal += ",\n";
+            retVal += eventJson;
+        }
+        retVal += "\n]}";
+
+        return retVal;
+    }
+
+    static string MakeMark(uint64_t timeUs, const string &name)
+    {
+        string retVal;
+
+        if (EndsWith(name, SUFFIX_START))
+        {
+            string spanName = name.substr(0, name.size() - strlen(SUFFIX_START));
+
+            retVal = MakeEventStart(spanName, "b", timeUs) + ",\"cat\":\"cc\",\"id\":\"" + spanName + "\"}";
+        }
+        else if (EndsWith(name, SUFFIX_END))
+        {
+            string spanName = name.substr(0, name.size() - strlen(SUFFIX_END));
+
+            retVal = MakeEventStart(spanName, "e", timeUs) + ",\"cat\":\"cc\",\"id\":\"" + spanName + "\"}";
+        }
+        else
+        {
+            retVal = MakeEventStart(name, "i", timeUs) + ",\"tid\":1,\"s\":\"p\"}";
+        }
+
+        return retVal;
+    }
+
+    static string MakeSpan(uint64_t timeStartUs, uint32_t durationUs, const string &name)
+    {
+        return MakeEventStart(name, "X", timeStartUs) + ",\"tid\":1,\"dur\":" + to_string(durationUs) + "}";
+    }
+
+    static string MakeCounter(uint64_t timeUs, const string &name, uint32_t value)
+    {
+        return MakeEventStart(name, "C", timeUs) + ",\"args\":{\"value\":" + to_string(value) + "}}";
+    }
+
+    // Converts a "ms:EVENT ms:EVENT ..." timeline, as the window simulator
+    // makes, into a trace document. Negative times are shifted later by
+    // timeOffsetMs, the viewers don't take them.
+    static string MakeDocumentFromTimeline(const string &timeline, int64_t timeOffsetMs)
+    {
+        vector<string> eventJsonList;
+
+        size_t posTokenStart = 0;
+        while (posTokenStart < timeline.size())
+        {
+            size_t posTokenEnd = timeline.find(' ', posTokenStart);
+            if (posTokenEnd == string::npos) { posTokenEnd = timeline.size(); }
+
+            string token = timeline.substr(posTokenStart, posTokenEnd - posTokenStart);
+            posTokenStart = posTokenEnd + 1;
+
+            auto pos = token.find(':');
+            if (pos == string::npos) { continue; }
+
+            int64_t ms   = atoll(token.substr(0, pos).c_str()) + timeOffsetMs;
+            string  name = token.substr(pos + 1);
+
+            eventJsonList.push_back(MakeMark((uint64_t)max(ms, (int64_t)0) * 1'000, name));
+        }
+
+        return MakeDocument(eventJsonList);
+    }
+
+
+private:
+
+    // left open for the caller to add fields and close
+    static string MakeEventStart(const string &name, const char *ph, uint64_t timeUs)
+    {
+        return string{"{\"name\":\""} + name + "\",\"ph\":\"" + ph + "\",\"ts\":" + to_string(timeUs) + ",\"pid\":1";
+    }
+
+    static bool EndsWith(const string &str, const char *suffix)
+    {
+        size_t len = strlen(suffix);
+
+        return str.size() > len && str.compare(str.size() - len, len, suffix) == 0;
+    }
+
+
+private:
+
+    inline static const char *SUFFIX_START = "_START";
+    inline static const char *SUFFIX_END   = "_END";
+};
\ No newline at end of file
@@ -0,0 +1,317 @@
+#pragma once
+
+#include "FilesystemLittleFS.h"
+#include "JSONMsgRouter.h"
+#include "Log.h"
+#include "Shell.h"
+#include "Utl.h"
+
+#include <string>
+#include <vector>
+using namespace std;
+
+
+// Decides how much of a window to give up when VCC is low, rather than
+// transmitting into a brownout and losing the hours it takes to recover.
+//
+// VCC is sampled once per window, just before the radio warms up, and
+// graded against three descending thresholds:
+// - below shed     : low-priority slots don't transmit
+// - below skip     : no slot transmits, but the gps still syncs time after
+// - below skip gps : as above, and the gps isn't requested either, so the
+//                    next window coasts on the time already held
+//
+// Recovering to a less restrictive level needs VCC to come back the
+// hysteresis above the threshold which was crossed, so a level sitting
+// on a threshold doesn't flap between windows.
+//
+// A threshold of 0 is disabled. All are disabled by default.
+//
+// Configuration is kept in a file, separate from the main configuration.
+class CopilotControlVoltagePolicy
+{
+public:
+
+    enum class Level : uint8_t
+    {
+        NORMAL,
+        SHED,
+        SKIP_WINDOW,
+        SKIP_GPS,
+    };
+
+    static const char *GetLevelName(Level level)
+    {
+        const char *retVal = "";
+
+        switch (level)
+        {
+        case Level::NORMAL:      retVal = "normal";      break;
+        case Level::SHED:        retVal = "shed";        break;
+        case Level::SKIP_WINDOW: retVal = "skip window"; break;
+        case Level::SKIP_GPS:    retVal = "skip gps";    break;
+        }
+
+        return retVal;
+    }
+
+    struct Config
+    {
+        uint16_t thresholdShedMv       = 0;
+        uint16_t thresholdSkipWindowMv = 0;
+        uint16_t thresholdSkipGpsMv    = 0;
+        uint16_t hysteresisMv          = 100;
+
+        // slot numbers, eg "45"
+        string lowPrioritySlotList = "45";
+    };
+
+
+public:
+
+    CopilotControlVoltagePolicy()
+    {
+        SetupShell();
+        SetupJSON();
+    }
+
+    Config &GetConfig()
+    {
+        Load();
+
+        return cfg_;
+    }
+
+    void SetConfig(const Config &cfg)
+    {
+        Load();
+
+        cfg_ = cfg;
+
+        Save();
+    }
+
+    // a reading of 0 means unknown, and leaves the level alone
+    Level Evaluate(uint16_t mv)
+    {
+        Load();
+
+        Level levelPrev = level_;
+
+        if (mv != 0)
+        {
+            Level levelNew = CalculateLevel(mv);
+
+            // worse takes effect immediately, better only once clear of the
+            // threshold which led to the current level
+            if (levelNew > level_)
+            {
+                level_ = levelNew;
+            }
+            else if (levelNew < level_ && mv >= GetThresholdMv(level_) + cfg_.hysteresisMv)
+            {
+                level_ = levelNew;
+            }
+
+            mvLast_ = mv;
+            mvMin_  = mvMin_ ? min(mvMin_, mv) : mv;
+        }
+
+        ++evalCount_;
+
+        Log("VCC ", mv, " mV, policy level ", GetLevelName(level_), level_ != levelPrev ? " (changed)" : "");
+
+        return level_;
+    }
+
+    Level GetLevel()
+    {
+        return level_;
+    }
+
+    // for testing, where VCC reads as unknown and so leaves the level alone
+    void SetLevel(Level level)
+    {
+        level_ = level;
+    }
+
+    bool SlotIsLowPriority(uint8_t slot)
+    {
+        Load();
+
+        return cfg_.lowPrioritySlotList.find((char)('0' + slot)) != string::npos;
+    }
+
+    // how a slot's transmission fares at the current level
+    bool SlotMayTransmit(uint8_t slot)
+    {
+        bool retVal = true;
+
+        if      (level_ >= Level::SKIP_WINDOW)                      { retVal = false; }
+        else if (level_ == Level::SHED && SlotIsLowPriority(slot)) { retVal = false; }
+
+        return retVal;
+    }
+
+    bool GpsMayBeRequested()
+    {
+        return level_ < Level::SKIP_GPS;
+    }
+
+    void OnSlotShed()    { ++slotShedCount_;    }
+    void OnWindowSkip()  { ++windowSkipCount_;  }
+    void OnGpsSkip()     { ++gpsSkipCount_;     }
+
+    void Report()
+    {
+        Load();
+
+        Log("VCC Policy");
+        Log("- shed below    : ", cfg_.thresholdShedMv,       " mV (slots ", cfg_.lowPrioritySlotList, ")");
+        Log("- skip below    : ", cfg_.thresholdSkipWindowMv, " mV");
+        Log("- skip gps below: ", cfg_.thresholdSkipGpsMv,    " mV");
+        Log("- hysteresis    : ", cfg_.hysteresisMv,          " mV");
+        Log("- level         : ", GetLevelName(level_));
+        Log("- vcc last      : ", mvLast_, " mV, min ", mvMin_, " mV");
+        Log("- evaluations   : ", Commas(evalCount_));
+        Log("- slots shed    : ", Commas(slotShedCount_));
+        Log("- windows skip  : ", Commas(windowSkipCount_));
+        Log("- gps skip      : ", Commas(gpsSkipCount_));
+    }
+
+
+private:
+
+    Level CalculateLevel(uint16_t mv)
+    {
+        Level retVal = Level::NORMAL;
+
+        if      (mv < cfg_.thresholdSkipGpsMv)    { retVal = Level::SKIP_GPS;    }
+        else if (mv < cfg_.thresholdSkipWindowMv) { retVal = Level::SKIP_WINDOW; }
+        else if (mv < cfg_.thresholdShedMv)       { retVal = Level::SHED;        }
+
+        return retVal;
+    }
+
+    uint16_t GetThresholdMv(Level level)
+    {
+        uint16_t retVal = 0;
+
+        switch (level)
+        {
+        case Level::NORMAL:      retVal = 0;                          break;
+        case Level::SHED:        retVal = cfg_.thresholdShedMv;       break;
+        case Level::SKIP_WINDOW: retVal = cfg_.thresholdSkipWindowMv; break;
+        case Level::SKIP_GPS:    retVal = cfg_.thresholdSkipGpsMv;    break;
+        }
+
+        return retVal;
+    }
+
+    // shed,skip,skipGps,hysteresis,lowPrioritySlotList
+    void Load()
+    {
+        if (loaded_) { return; }
+        loaded_ = true;
+
+        // slot list may be empty, and so absent
+        vector<string> partList = Split(FilesystemLittleFS::Read(FILE_NAME), ",");
+        if (partList.size() >= 4)
+        {
+            cfg_ = {
+                .thresholdShedMv       = (uint16_t)atoi(partList[0].c_str()),
+                .thresholdSkipWindowMv = (uint16_t)atoi(partList[1].c_str()),
+                .thresholdSkipGpsMv    = (uint16_t)atoi(partList[2].c_str()),
+                .hysteresisMv          = (uint16_t)atoi(partList[3].c_str()),
+                .lowPrioritySlotList   = partList.size() >= 5 ? partList[4] : "",
+            };
+        }
+    }
+
+    void Save()
+    {
+        FilesystemLittleFS::Write(FILE_NAME,
+                                  to_string(cfg_.thresholdShedMv)       + "," +
+                                  to_string(cfg_.thresholdSkipWindowMv) + "," +
+                                  to_string(cfg_.thresholdSkipGpsMv)    + "," +
+                                  to_string(cfg_.hysteresisMv)          + "," +
+                                  cfg_.lowPrioritySlotList);
+    }
+
+
+private:
+
+    void SetupShell()
+    {
+        Shell::AddCommand("app.ss.cc.vcc", [this](vector<string> argList){
+            Report();
+        }, { .argCount = 0, .help = "report vcc policy"});
+
+        Shell::AddCommand("app.ss.cc.vcc.set", [this](vector<string> argList){
+            SetConfig({
+                .thresholdShedMv       = (uint16_t)atoi(argList[0].c_str()),
+                .thresholdSkipWindowMv = (uint16_t)atoi(argList[1].c_str()),
+                .thresholdSkipGpsMv    = (uint16_t)atoi(argList[2].c_str()),
+                .hysteresisMv          = (uint16_t)atoi(argList[3].c_str()),
+                .lowPrioritySlotList   = argList[4],
+            });
+
+            Report();
+        }, { .argCount = 5, .help = "set vcc policy <shedMv> <skipMv> <skipGpsMv> <hysteresisMv> <lowPrioritySlots eg 45>"});
+
+        Shell::AddCommand("app.ss.cc.vcc.eval", [this](vector<string> argList){
+            Evaluate((uint16_t)atoi(argList[0].c_str()));
+        }, { .argCount = 1, .help = "evaluate vcc policy for <mv>"});
+    }
+
+    void SetupJSON()
+    {
+        JSONMsgRouter::RegisterHandler("REQ_GET_VCC_POLICY", [this](auto &in, auto &out){
+            out["type"] = "REP_GET_VCC_POLICY";
+
+            const Config &cfg = GetConfig();
+            out["shedMv"]              = cfg.thresholdShedMv;
+            out["skipWindowMv"]        = cfg.thresholdSkipWindowMv;
+            out["skipGpsMv"]           = cfg.thresholdSkipGpsMv;
+            out["hysteresisMv"]        = cfg.hysteresisMv;
+            out["lowPrioritySlotList"] = cfg.lowPrioritySlotList;
+
+            out["level"]           = GetLevelName(level_);
+            out["mvLast"]          = mvLast_;
+            out["mvMin"]           = mvMin_;
+            out["evalCount"]       = evalCount_;
+            out["slotShedCount"]   = slotShedCount_;
+            out["windowSkipCount"] = windowSkipCount_;
+            out["gpsSkipCount"]    = gpsSkipCount_;
+        });
+
+        JSONMsgRouter::RegisterHandler("REQ_SET_VCC_POLICY", [this](auto &in, auto &out){
+            Log("REQ_SET_VCC_POLICY");
+
+            SetConfig({
+                .thresholdShedMv       = (uint16_t)in["shedMv"],
+                .thresholdSkipWindowMv = (uint16_t)in["skipWindowMv"],
+                .thresholdSkipGpsMv    = (uint16_t)in["skipGpsMv"],
+                .hysteresisMv          = (uint16_t)in["hysteresisMv"],
+                .lowPrioritySlotList   = (const char *)in["lowPrioritySlotList"],
+            });
+        });
+    }
+
+
+private:
+
+    inline static const char *FILE_NAME = "vcc.policy";
+
+    bool   loaded_ = false;
+    Config cfg_;
+
+    Level    level_  = Level::NORMAL;
+    uint16_t mvLast_ = 0;
+    uint16_t mvMin_  = 0;
+
+    uint32_t evalCount_       = 0;
+    uint32_t slotShedCount_   = 0;
+    uint32_t windowSkipCount_ = 0;
+    uint32_t gpsSkipCount_    = 0;
+};
\ No newline at end of file
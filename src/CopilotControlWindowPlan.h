@@ -0,0 +1,424 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+
+// The timeline of a single window, as a list of actions sorted by the time
+// they are to happen.
+//
+// Calculating a plan has no side effects and depends only on its input, so
+// a plan can be checked against a known-good one (see
+// test/CopilotControlWindowPlanTest.cpp).
+//
+// Actions which share a time happen in the order they appear in the plan.
+//
+// A plan can also join a window already in progress, from a later period
+// onwards. Period 0 then runs the js for that first period rather than
+// for period 1.
+class CopilotControlWindowPlan
+{
+public:
+
+    enum class Action : uint8_t
+    {
+        TX_WARMUP,
+        SCHEDULE_LOCK_OUT_START,
+        PERIOD_START,           // slot is the period, 0-5, or 0 then the first period
+        RADIO_IDLE_GAP_START,   // slot is the period just finished
+        TX_REWARMUP,            // slot is the period being warmed up for
+        TX_DISABLE_GPS_ENABLE,
+        SCHEDULE_LOCK_OUT_END,
+    };
+
+    // string literals, safe to hold on to
+    static const char *GetActionName(Action action, uint8_t slot = 0)
+    {
+        static const char *PERIOD_START_NAME_LIST[] = {
+            "PERIOD0_START",
+            "PERIOD1_START",
+            "PERIOD2_START",
+            "PERIOD3_START",
+            "PERIOD4_START",
+            "PERIOD5_START",
+        };
+
+        const char *retVal = "";
+
+        switch (action)
+        {
+        case Action::TX_WARMUP:               retVal = "TX_WARMUP";                                   break;
+        case Action::SCHEDULE_LOCK_OUT_START: retVal = "SCHEDULE_LOCK_OUT_START";                     break;
+        case Action::PERIOD_START:            retVal = PERIOD_START_NAME_LIST[min(slot, (uint8_t)5)]; break;
+        case Action::RADIO_IDLE_GAP_START:    retVal = "RADIO_IDLE_GAP_START";                        break;
+        case Action::TX_REWARMUP:             retVal = "TX_REWARMUP";                                 break;
+        case Action::TX_DISABLE_GPS_ENABLE:   retVal = "TX_DISABLE_GPS_ENABLE";                       break;
+        case Action::SCHEDULE_LOCK_OUT_END:   retVal = "SCHEDULE_LOCK_OUT_END";                       break;
+        }
+
+        return retVal;
+    }
+
+    struct Entry
+    {
+        uint64_t timeAtUs = 0;
+        Action   action   = Action::TX_WARMUP;
+        uint8_t  slot     = 0;
+
+        bool operator==(const Entry &other) const
+        {
+            return timeAtUs == other.timeAtUs && action == other.action && slot == other.slot;
+        }
+    };
+
+    struct Input
+    {
+        uint64_t timeNowUs           = 0;
+        uint64_t timeAtWindowStartUs = 0;
+
+        // index 1-5, index 0 unused
+        bool periodWillTransmit[6] = {};
+
+        uint64_t durationWantWarmupUs = 0;
+        uint64_t durationJsUs         = 0;
+
+        // first period to schedule, earlier ones have already passed
+        uint8_t periodFirst = 1;
+
+        // compress the window to fire in quick succession
+        bool testing = false;
+    };
+
+    // a WSPR transmission, period 5 is cut short to leave time for the gps
+    inline static const uint64_t DURATION_TX_US         = 111 * 1'000 * 1'000;
+    inline static const uint64_t DURATION_TX_PERIOD5_US =  60 * 1'000 * 1'000;
+
+    struct Plan
+    {
+        vector<Entry> entryList;
+
+        uint8_t periodFirst = 1;
+
+        // for reporting
+        uint64_t durationAvailPreWindowUs = 0;
+        uint64_t durationWantWarmupUs     = 0;
+        uint64_t durationUseWarmupUs      = 0;
+        uint64_t durationWantPreWindowUs  = 0;
+        uint64_t durationUsePreWindowUs   = 0;
+    };
+
+
+public:
+
+    static Plan Calculate(const Input &in)
+    {
+        Plan plan;
+
+        // named durations
+        const uint64_t DURATION_ONE_SECOND_US  =      1 * 1'000 * 1'000;
+        const uint64_t DURATION_TWO_MINUTES_US = 2 * 60 * 1'000 * 1'000;
+
+        const uint64_t timeAtWindowStartUs = in.timeAtWindowStartUs;
+
+        const uint8_t PERIOD_FIRST = min(max(in.periodFirst, (uint8_t)1), (uint8_t)5);
+
+        auto PeriodWillTransmit = [&](uint8_t period){
+            return period >= PERIOD_FIRST && in.periodWillTransmit[period];
+        };
+
+
+        // Period start times
+        // There is no advantage to skipping scheduling period 5 when no TX will occur.
+        //
+        // The question arises because there's no JS to run, so if no TX, why even
+        // schedule it. It holds up window end event.
+        //
+        // Holding up the window end doesn't stop us getting a GPS lock.
+        // Holding up the window end also doesn't stop us warming up.
+        //
+        // Warmup Reasoning:
+        // - If there's tx in period 5, you have to wait, and warmup waits too.
+        // - If there's no tx, you wait until the period ends, but that's way before
+        //   the warmup period, so no savings.
+        //
+        // The window timeline is laid out from period 1 even when joining
+        // later, a window start already passed still places the periods.
+        uint64_t TIME_AT_PERIOD_START_US_LIST[6];
+        TIME_AT_PERIOD_START_US_LIST[1] = timeAtWindowStartUs;
+        for (uint8_t period = 2; period <= 5; ++period)
+        {
+            TIME_AT_PERIOD_START_US_LIST[period] = TIME_AT_PERIOD_START_US_LIST[period - 1] + DURATION_TWO_MINUTES_US;
+        }
+
+        if (in.testing)
+        {
+            // Cause events all to fire in order quickly but with a unique
+            // time so that gps can be enabled after a specific period.
+            const uint64_t DURATION_GAP_US = 1;
+
+            // The first period is not required to override, it ends up at its
+            // own start
+            for (uint8_t period = PERIOD_FIRST + 1; period <= 5; ++period)
+            {
+                TIME_AT_PERIOD_START_US_LIST[period] = TIME_AT_PERIOD_START_US_LIST[period - 1] + DURATION_GAP_US;
+            }
+        }
+
+        // everything ahead of the window is timed against its first period
+        const uint64_t TIME_AT_FIRST_PERIOD_START_US = TIME_AT_PERIOD_START_US_LIST[PERIOD_FIRST];
+
+        uint64_t DURATION_AVAIL_PRE_WINDOW_US = TIME_AT_FIRST_PERIOD_START_US - in.timeNowUs;
+
+        if (in.testing)
+        {
+            DURATION_AVAIL_PRE_WINDOW_US = 0;
+        }
+
+
+        // warmup start time
+        //
+        // schedule to start outside the protection of the window lockout.
+        // we don't need to protect against this getting interrupted or
+        // restarted way outside the window.
+        //
+        // the lockout period will protect more sensitive activities.
+        //
+        // No need to schedule if no transmissions will occur.
+        //
+        // How long is wanted depends on the radio (temperature, recent use).
+        const uint64_t DURATION_WANT_WARMUP_US = in.durationWantWarmupUs;
+        const uint64_t DURATION_USE_WARMUP_US  = min(DURATION_WANT_WARMUP_US, DURATION_AVAIL_PRE_WINDOW_US);
+        const uint64_t TIME_AT_WARMUP_US       = TIME_AT_FIRST_PERIOD_START_US - DURATION_USE_WARMUP_US;
+        bool DO_WARMUP = false;
+        if (PeriodWillTransmit(1)) { DO_WARMUP = true; }
+        if (PeriodWillTransmit(2)) { DO_WARMUP = true; }
+        if (PeriodWillTransmit(3)) { DO_WARMUP = true; }
+        if (PeriodWillTransmit(4)) { DO_WARMUP = true; }
+        if (PeriodWillTransmit(5)) { DO_WARMUP = true; }
+
+
+        // duration required for initial JS
+        const uint64_t DURATION_JS_US = in.durationJsUs;
+
+        // duration lockout start
+        //
+        // This relates to protecting all window activities, starting first with
+        // running the initial js.
+        //
+        // Running the initial js needs to complete before the start of the window, so
+        // allocate time for that.
+        const uint64_t DURATION_WANT_PRE_WINDOW_US = DURATION_JS_US;
+        const uint64_t DURATION_USE_PRE_WINDOW_US  = min(DURATION_WANT_PRE_WINDOW_US, DURATION_AVAIL_PRE_WINDOW_US);
+
+        // Schedule Schedule Lock Out Start
+        const uint64_t TIME_AT_SCHEDULE_LOCK_OUT_START_US = TIME_AT_FIRST_PERIOD_START_US - DURATION_USE_PRE_WINDOW_US;
+
+        // js start time
+        // (run immediately after lockout starts)
+        const uint64_t TIME_AT_JS_RUN_US = TIME_AT_SCHEDULE_LOCK_OUT_START_US;
+        TIME_AT_PERIOD_START_US_LIST[0] = TIME_AT_JS_RUN_US;
+
+        // Schedule GPS Req (and tx disable).
+        //
+        // GPS Req should happen after:
+        // - Final transmission period (GPS can't run at same time as TX).
+        //
+        // This is safe because:
+        // - GPS operation does not interfere with running js.
+        // - GPS new locks won't affect this window's data.
+        //
+        // When there is a final transmission period, the GPS Req comes at the
+        // same moment, but after it in the plan, so it happens directly after,
+        // which is as early as possible, and what we want.
+        //
+        // Otherwise it comes at the start of the window (or its first period),
+        // ahead of that period, since no transmission holds it up.
+        uint64_t TIME_AT_GPS_REQ_US = TIME_AT_FIRST_PERIOD_START_US;
+        bool TIME_AT_GPS_REQ_AFTER_PERIOD = false;
+        for (uint8_t period = 1; period <= 5; ++period)
+        {
+            if (PeriodWillTransmit(period))
+            {
+                TIME_AT_GPS_REQ_US           = TIME_AT_PERIOD_START_US_LIST[period];
+                TIME_AT_GPS_REQ_AFTER_PERIOD = true;
+            }
+        }
+
+        // Schedule Lock Out End.
+        //
+        // This event should come after the final period of work.
+        //
+        // It is no harm to end the lock out period after the 5th period
+        // even if no work gets done.
+        const uint64_t TIME_AT_SCHEDULE_LOCK_OUT_END_US = TIME_AT_PERIOD_START_US_LIST[5];
+
+        // Radio idle gaps.
+        //
+        // When periods between two transmitting periods send nothing, the
+        // radio would sit idle. If idle long enough to pay off, the radio
+        // is turned off after the earlier period and warmed up again ahead
+        // of the later one, by as much as the window warmup wants.
+        //
+        // Payoff is judged on real period durations, so testing sees the
+        // same gaps as flight.
+        const uint64_t DURATION_MIN_RADIO_OFF_US = 30 * DURATION_ONE_SECOND_US;
+        uint8_t idleGapPeriodNextList[6] = {};
+        uint8_t periodTxLast = 0;
+        for (uint8_t period = 1; period <= 5; ++period)
+        {
+            if (PeriodWillTransmit(period) == false) { continue; }
+
+            if (periodTxLast && period - periodTxLast >= 2)
+            {
+                uint64_t durationIdleUs = (period - periodTxLast) * DURATION_TWO_MINUTES_US - DURATION_TX_US;
+                uint64_t durationOffUs  = durationIdleUs - min(durationIdleUs, DURATION_WANT_WARMUP_US);
+
+                if (durationOffUs >= DURATION_MIN_RADIO_OFF_US)
+                {
+                    idleGapPeriodNextList[periodTxLast] = period;
+                }
+            }
+
+            periodTxLast = period;
+        }
+
+
+        // Lay out the plan in the order in which actions sharing a time
+        // are to happen.
+        vector<Entry> &el = plan.entryList;
+
+        if (DO_WARMUP)
+        {
+            el.push_back({ TIME_AT_WARMUP_US, Action::TX_WARMUP });
+        }
+
+        el.push_back({ TIME_AT_SCHEDULE_LOCK_OUT_START_US, Action::SCHEDULE_LOCK_OUT_START });
+
+        if (TIME_AT_GPS_REQ_AFTER_PERIOD == false)
+        {
+            el.push_back({ TIME_AT_GPS_REQ_US, Action::TX_DISABLE_GPS_ENABLE });
+        }
+
+        for (uint8_t period = 0; period <= 5; ++period)
+        {
+            if (period != 0 && period < PERIOD_FIRST) { continue; }
+
+            el.push_back({ TIME_AT_PERIOD_START_US_LIST[period], Action::PERIOD_START, period });
+
+            // the gap starts once the period's work is done
+            uint8_t periodNext = idleGapPeriodNextList[period];
+            if (periodNext)
+            {
+                uint64_t timeAtGapStartUs   = TIME_AT_PERIOD_START_US_LIST[period];
+                uint64_t timeAtGapEndUs     = TIME_AT_PERIOD_START_US_LIST[periodNext];
+                uint64_t durationRewarmupUs = min(DURATION_WANT_WARMUP_US, timeAtGapEndUs - timeAtGapStartUs);
+
+                el.push_back({ timeAtGapStartUs,                    Action::RADIO_IDLE_GAP_START, period     });
+                el.push_back({ timeAtGapEndUs - durationRewarmupUs, Action::TX_REWARMUP,          periodNext });
+            }
+        }
+
+        if (TIME_AT_GPS_REQ_AFTER_PERIOD)
+        {
+            el.push_back({ TIME_AT_GPS_REQ_US, Action::TX_DISABLE_GPS_ENABLE });
+        }
+
+        el.push_back({ TIME_AT_SCHEDULE_LOCK_OUT_END_US, Action::SCHEDULE_LOCK_OUT_END });
+
+        // sort while retaining order of equal items
+        stable_sort(el.begin(), el.end(), [](const Entry &e1, const Entry &e2){
+            return e1.timeAtUs < e2.timeAtUs;
+        });
+
+        plan.periodFirst = PERIOD_FIRST;
+
+        // reporting
+        plan.durationAvailPreWindowUs = DURATION_AVAIL_PRE_WINDOW_US;
+        plan.durationWantWarmupUs     = DURATION_WANT_WARMUP_US;
+        plan.durationUseWarmupUs      = DURATION_USE_WARMUP_US;
+        plan.durationWantPreWindowUs  = DURATION_WANT_PRE_WINDOW_US;
+        plan.durationUsePreWindowUs   = DURATION_USE_PRE_WINDOW_US;
+
+        return plan;
+    }
+
+    // The next time the window start minute comes around, at <m>:01.000,
+    // from the gps time seen at timeNowUs.
+    static uint64_t CalculateTimeAtWindowStartUs(uint8_t windowStartMin, uint8_t gpsMin, uint8_t gpsSec, uint32_t gpsUs, uint64_t timeNowUs)
+    {
+        // calculate how far into the future the start minute is from gps time
+        // by modelling a min/sec/ms clock and subtracting gps time from the window time.
+        // the window is nominally at <m>:01.000.
+        int8_t  minDiff = (int8_t)(windowStartMin - (gpsMin % 10));
+        int8_t  secDiff = (int8_t)(1              - gpsSec);
+        int32_t usDiff  = (int32_t)               - gpsUs;
+
+        // then, since you know how far into the future the window start is from the
+        // gps time, you add that duration onto the gps time and arrive at the window
+        // start time.
+        int64_t totalDiffUs = 0;
+        totalDiffUs += minDiff *      60 * 1'000 * 1'000;
+        totalDiffUs +=           secDiff * 1'000 * 1'000;
+        totalDiffUs +=                     usDiff;
+
+        // the exception is when the duration is negative, in which case you just add
+        // 10 minutes.
+        if (totalDiffUs < 0)
+        {
+            totalDiffUs += 10 * 60 * 1'000 * 1'000;
+        }
+
+        // calculate window start time by offset from gps time now
+        uint64_t timeAtWindowStartUs = timeNowUs + totalDiffUs;
+
+        return timeAtWindowStartUs;
+    }
+
+    // The first period of the window in progress which can still be met,
+    // with the lead it needs (warmup, js) ahead of it, or 0 if none can.
+    //
+    // The window in progress is the one ending at the next window start.
+    // Period 1 of it has always passed.
+    static uint8_t CalculatePeriodFirstJoinable(uint64_t timeNowUs, uint64_t timeAtNextWindowStartUs, uint64_t durationLeadUs)
+    {
+        const uint64_t DURATION_TWO_MINUTES_US = 2 * 60 * 1'000 * 1'000;
+
+        uint8_t retVal = 0;
+
+        uint64_t durationToNextWindowUs = timeAtNextWindowStartUs - timeNowUs;
+
+        for (uint8_t period = 2; period <= 5; ++period)
+        {
+            uint64_t durationPeriodToNextWindowUs = (6 - period) * DURATION_TWO_MINUTES_US;
+
+            if (durationToNextWindowUs >= durationPeriodToNextWindowUs + durationLeadUs)
+            {
+                retVal = period;
+
+                break;
+            }
+        }
+
+        return retVal;
+    }
+
+    // zero if not in the plan
+    static uint64_t GetTimeAtActionUs(const Plan &plan, Action action, uint8_t slot = 0)
+    {
+        uint64_t retVal = 0;
+
+        for (const auto &entry : plan.entryList)
+        {
+            if (entry.action == action && (entry.action != Action::PERIOD_START || entry.slot == slot))
+            {
+                retVal = entry.timeAtUs;
+
+                break;
+            }
+        }
+
+        return retVal;
+    }
+};
\ No newline at end of file
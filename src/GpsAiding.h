@@ -0,0 +1,189 @@
+#pragma once
+
+#include "App.h"
+#include "CasicAidIni.h"
+#include "FilesystemLittleFS.h"
+#include "GPS.h"
+#include "TimeClass.h"
+
+#include <string>
+#include <vector>
+using namespace std;
+
+
+// A GPS module which has lost its backup power starts cold, searching the
+// whole sky with no idea of where or when it is.
+//
+// We usually do know roughly. The last 3D fix gives a position, and notional
+// time is GPS-derived. The CASIC AID-INI message hands both to the module
+// right after power on, which lets it narrow its search. The frame is
+// handed to SubsystemGps to send, in turn with the other module commands.
+//
+// The last position is kept in a file so it survives a reboot, which is the
+// most common reason for the module to be cold. Notional time does not
+// survive a reboot, so in that case only position is given.
+//
+// The module doesn't accept ephemeris from the host (it has nowhere to have
+// retained it but its own backup RAM), so that is not offered.
+class GpsAiding
+{
+public:
+
+    void SetEnabled(bool enabled)
+    {
+        enabled_ = enabled;
+    }
+
+    bool GetEnabled()
+    {
+        return enabled_;
+    }
+
+    void OnFix3DPlus(const Fix3DPlus &fix)
+    {
+        Load();
+
+        pos_ = {
+            .valid         = true,
+            .latDeg        = fix.latDegMillionths / 1'000'000.0,
+            .lngDeg        = fix.lngDegMillionths / 1'000'000.0,
+            .altM          = (double)fix.altitudeM,
+            .timeAtFixMs   = PAL.Millis(),
+            .fromThisBoot  = true,
+        };
+
+        // rate limit flash writes, position changes slowly enough anyway
+        if (timeAtLastSaveMs_ == 0 || PAL.Millis() - timeAtLastSaveMs_ >= SAVE_INTERVAL_MS)
+        {
+            Save();
+
+            timeAtLastSaveMs_ = PAL.Millis();
+        }
+    }
+
+    // returns true if there was anything to aid with, the frame for the
+    // caller to send to the module
+    bool MakeFrame(vector<uint8_t> &frame)
+    {
+        Load();
+
+        if (enabled_ == false) { return false; }
+
+        uint64_t timeNowUs  = PAL.Micros();
+        uint64_t notionalUs = Time::GetNotionalUsAtSystemUs(timeNowUs);
+
+        bool timeValid = notionalUs >= NOTIONAL_US_VALID_MIN;
+        bool posValid  = pos_.valid;
+
+        if (timeValid == false && posValid == false)
+        {
+            Log("GPS aiding: nothing known, not sending");
+
+            return false;
+        }
+
+        // the balloon keeps moving after the last fix
+        double ageSec = 0;
+        if (pos_.fromThisBoot)
+        {
+            ageSec = (PAL.Millis() - pos_.timeAtFixMs) / 1'000.0;
+        }
+        else
+        {
+            ageSec = POS_AGE_UNKNOWN_SEC;
+        }
+        double pAccM = min(POS_ACC_BASE_M + ageSec * DRIFT_MPS, POS_ACC_MAX_M);
+
+        frame = CasicAidIni::MakeFrame({
+            .posValid  = posValid,
+            .latDeg    = pos_.latDeg,
+            .lngDeg    = pos_.lngDeg,
+            .altM      = pos_.altM,
+            .pAccM     = (float)pAccM,
+            .timeValid = timeValid,
+            .unixUs    = notionalUs,
+            .tAccSec   = TIME_ACC_SEC,
+        });
+
+        ++sendCount_;
+
+        CasicAidIni::WeekTow wt = CasicAidIni::GetWeekTow(notionalUs);
+
+        Log("GPS aiding:");
+        Log("- Time: ", timeValid ? Time::MakeDateTimeFromUs(notionalUs) : string{"(unknown)"}, timeValid ? string{" (week "} + to_string(wt.week) + ", tow " + to_string((uint32_t)wt.tow) + ")" : string{""});
+        Log("- Pos : ", posValid ? to_string(pos_.latDeg) + ", " + to_string(pos_.lngDeg) + ", " + to_string((int32_t)pos_.altM) + "m" : string{"(unknown)"}, posValid ? string{" +/- "} + Commas((uint32_t)pAccM) + "m" : string{""});
+
+        return true;
+    }
+
+    uint32_t GetSendCount()
+    {
+        return sendCount_;
+    }
+
+
+private:
+
+    /////////////////////////////////////////////////////////////////
+    // Persistence
+    /////////////////////////////////////////////////////////////////
+
+    void Load()
+    {
+        if (loaded_) { return; }
+        loaded_ = true;
+
+        vector<string> partList = Split(FilesystemLittleFS::Read(FILE_NAME), ",");
+        if (partList.size() == 3)
+        {
+            pos_ = {
+                .valid        = true,
+                .latDeg       = atof(partList[0].c_str()),
+                .lngDeg       = atof(partList[1].c_str()),
+                .altM         = atof(partList[2].c_str()),
+                .timeAtFixMs  = 0,
+                .fromThisBoot = false,
+            };
+        }
+    }
+
+    void Save()
+    {
+        FilesystemLittleFS::Write(FILE_NAME, to_string(pos_.latDeg) + "," + to_string(pos_.lngDeg) + "," + to_string(pos_.altM));
+    }
+
+
+private:
+
+    inline static const char *FILE_NAME = "gps.aid";
+
+    // notional time before 2024 has never been set from GPS
+    inline static const uint64_t NOTIONAL_US_VALID_MIN = 1'704'067'200ULL * 1'000'000;
+
+    // notional time is good to the ms when set, and drifts slowly after
+    inline static const float TIME_ACC_SEC = 2;
+
+    // a balloon in the jet stream covers ~50 m/s
+    inline static const double POS_ACC_BASE_M      = 10'000;
+    inline static const double POS_ACC_MAX_M       = 1'000'000;
+    inline static const double DRIFT_MPS           = 50;
+    inline static const double POS_AGE_UNKNOWN_SEC = 6 * 60 * 60;
+
+    inline static const uint32_t SAVE_INTERVAL_MS = 60 * 60 * 1'000;
+
+    struct Position
+    {
+        bool     valid        = false;
+        double   latDeg       = 0;
+        double   lngDeg       = 0;
+        double   altM         = 0;
+        uint64_t timeAtFixMs  = 0;
+        bool     fromThisBoot = false;
+    };
+
+    bool     enabled_          = true;
+    bool     loaded_           = false;
+    Position pos_;
+    uint64_t timeAtLastSaveMs_ = 0;
+    uint32_t sendCount_        = 0;
+};
\ No newline at end of file
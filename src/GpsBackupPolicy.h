@@ -0,0 +1,275 @@
+#pragma once
+
+#include "App.h"
+#include "TimeClass.h"
+
+#include <array>
+#include <string>
+using namespace std;
+
+
+// Decides, each time the GPS is powered down, whether to keep its backup
+// battery supply on.
+//
+// Backup power keeps time, almanac and ephemeris in the module, so the
+// next start is hot (ephemeris still valid) or warm (ephemeris expired,
+// but time and position retained). Without it the next start is cold.
+//
+// The trade is the backup current over the off period versus the extra
+// full-power acquisition time of a worse start. Acquisition times are
+// learned from observed starts of each kind, starting from typical figures.
+// The off period is learned from previous off periods.
+//
+// Every decision is logged with its figures. The start that follows is
+// logged with how it actually went.
+class GpsBackupPolicy
+{
+public:
+
+    enum class StartKind : uint8_t
+    {
+        COLD,
+        COLD_AIDED,
+        WARM,
+        HOT,
+        COUNT,
+    };
+
+    static const char *GetStartKindName(StartKind startKind)
+    {
+        const char *retVal = "";
+
+        switch (startKind)
+        {
+        case StartKind::COLD:       retVal = "cold";       break;
+        case StartKind::COLD_AIDED: retVal = "cold aided"; break;
+        case StartKind::WARM:       retVal = "warm";       break;
+        case StartKind::HOT:        retVal = "hot";        break;
+        default: break;
+        }
+
+        return retVal;
+    }
+
+
+public:
+
+    /////////////////////////////////////////////////////////////////
+    // Events
+    /////////////////////////////////////////////////////////////////
+
+    // returns the kind of start the module is about to have
+    StartKind OnPowerOn(bool moduleCold)
+    {
+        uint64_t timeNowMs = PAL.Millis();
+
+        // account for the off period just ended
+        if (timeAtPowerOffMs_)
+        {
+            uint64_t offMs = timeNowMs - timeAtPowerOffMs_;
+
+            if (backupOn_)
+            {
+                backupOnTotalMs_ += offMs;
+            }
+
+            offMsAvg_ = offMsAvgValid_ ? (offMsAvg_ * 3 + offMs) / 4 : offMs;
+            offMsAvgValid_ = true;
+        }
+
+        if (moduleCold)
+        {
+            startKind_ = StartKind::COLD;
+        }
+        else
+        {
+            startKind_ = GetEphemerisAgeMs(timeNowMs) < EPHEMERIS_VALID_MS ? StartKind::HOT : StartKind::WARM;
+        }
+
+        timeAtPowerOnMs_ = timeNowMs;
+        ttffRecorded_    = false;
+        hadFix_          = false;
+
+        return startKind_;
+    }
+
+    void OnAided()
+    {
+        if (startKind_ == StartKind::COLD)
+        {
+            startKind_ = StartKind::COLD_AIDED;
+        }
+    }
+
+    void OnFirstFix()
+    {
+        if (ttffRecorded_) { return; }
+        ttffRecorded_ = true;
+        hadFix_       = true;
+
+        uint64_t ttffMs = PAL.Millis() - timeAtPowerOnMs_;
+
+        TtffStats &stats = ttffStatsList_[(size_t)startKind_];
+        stats.minMs    = stats.count ? min(stats.minMs, ttffMs) : ttffMs;
+        stats.maxMs    = stats.count ? max(stats.maxMs, ttffMs) : ttffMs;
+        stats.totalMs += ttffMs;
+        ++stats.count;
+
+        Log("GPS TTFF ", Time::MakeTimeMMSSmmmFromMs(ttffMs), " from power on (", GetStartKindName(startKind_), " start)");
+        if (decisionMade_)
+        {
+            Log("- backup policy expected ", GetStartKindName(startKindExpected_), " start in ", Time::MakeTimeMMSSmmmFromMs(GetTtffMs(startKindExpected_)));
+        }
+    }
+
+    // returns true if backup power should be kept on
+    bool DecideKeepBackup(bool aidingEnabled)
+    {
+        uint64_t timeNowMs = PAL.Millis();
+
+        // the module picked up fresh ephemeris if it got a fix this time on
+        if (hadFix_)
+        {
+            timeAtEphemerisMs_ = timeNowMs;
+            haveEphemeris_     = true;
+        }
+
+        uint64_t offMs = offMsAvgValid_ ? offMsAvg_ : OFF_MS_DEFAULT;
+
+        // what the next start would be with backup kept
+        StartKind startKindKept = StartKind::WARM;
+        if (haveEphemeris_ && GetEphemerisAgeMs(timeNowMs) + offMs < EPHEMERIS_VALID_MS)
+        {
+            startKindKept = StartKind::HOT;
+        }
+        StartKind startKindDropped = aidingEnabled ? StartKind::COLD_AIDED : StartKind::COLD;
+
+        // charge in uA-sec
+        uint64_t extraTtffMs = GetTtffMs(startKindDropped) > GetTtffMs(startKindKept) ? GetTtffMs(startKindDropped) - GetTtffMs(startKindKept) : 0;
+        uint64_t costUaSec   = (uint64_t)BACKUP_CURRENT_UA * offMs / 1'000;
+        uint64_t saveUaSec   = (uint64_t)ACTIVE_CURRENT_UA * extraTtffMs / 1'000;
+
+        bool keep = saveUaSec >= costUaSec;
+
+        Log("GPS backup policy: ", keep ? "keep" : "drop", " backup power");
+        Log("- expected off      : ", Time::MakeTimeMMSSmmmFromMs(offMs));
+        Log("- ephemeris age     : ", haveEphemeris_ ? Time::MakeTimeMMSSmmmFromMs(GetEphemerisAgeMs(timeNowMs)) : string{"(none)"});
+        Log("- next start if kept: ", GetStartKindName(startKindKept),    " (", Time::MakeTimeMMSSmmmFromMs(GetTtffMs(startKindKept)),    ")");
+        Log("- next start if not : ", GetStartKindName(startKindDropped), " (", Time::MakeTimeMMSSmmmFromMs(GetTtffMs(startKindDropped)), ")");
+        Log("- backup cost       : ", Commas(costUaSec), " uA-sec");
+        Log("- acquisition saved : ", Commas(saveUaSec), " uA-sec");
+
+        if (keep) { ++keepCount_; }
+        else      { ++dropCount_; }
+
+        backupOn_          = keep;
+        timeAtPowerOffMs_  = timeNowMs;
+        startKindExpected_ = keep ? startKindKept : startKindDropped;
+        decisionMade_      = true;
+
+        return keep;
+    }
+
+    // the battery was turned off some way other than the policy
+    void OnBackupLost()
+    {
+        backupOn_      = false;
+        haveEphemeris_ = false;
+    }
+
+    void Report()
+    {
+        Log("GPS Backup Policy");
+        Log("- decisions      : ", keepCount_, " keep, ", dropCount_, " drop");
+        Log("- backup on total: ", Time::MakeDurationFromUs(backupOnTotalMs_ * 1'000));
+        Log("- avg off period : ", offMsAvgValid_ ? Time::MakeTimeMMSSmmmFromMs(offMsAvg_) : string{"(none)"});
+        Log("- ephemeris age  : ", haveEphemeris_ ? Time::MakeTimeMMSSmmmFromMs(GetEphemerisAgeMs(PAL.Millis())) : string{"(none)"});
+        Log("TTFF by start kind");
+        for (size_t i = 0; i < ttffStatsList_.size(); ++i)
+        {
+            const TtffStats &stats = ttffStatsList_[i];
+
+            string avg = stats.count ? Time::MakeTimeMMSSmmmFromMs(stats.totalMs / stats.count) : string{"-"};
+            string lo  = stats.count ? Time::MakeTimeMMSSmmmFromMs(stats.minMs) : string{"-"};
+            string hi  = stats.count ? Time::MakeTimeMMSSmmmFromMs(stats.maxMs) : string{"-"};
+
+            Log("- ", StrUtl::PadRight(GetStartKindName((StartKind)i), ' ', 10), ": ", stats.count, " starts, avg ", avg, ", min ", lo, ", max ", hi);
+        }
+    }
+
+
+private:
+
+    uint64_t GetEphemerisAgeMs(uint64_t timeNowMs)
+    {
+        return haveEphemeris_ ? timeNowMs - timeAtEphemerisMs_ : EPHEMERIS_VALID_MS;
+    }
+
+    // observed average, or a typical figure until there is one
+    uint64_t GetTtffMs(StartKind startKind)
+    {
+        const TtffStats &stats = ttffStatsList_[(size_t)startKind];
+
+        uint64_t retVal = 0;
+
+        if (stats.count)
+        {
+            retVal = stats.totalMs / stats.count;
+        }
+        else
+        {
+            switch (startKind)
+            {
+            case StartKind::COLD:       retVal = 35'000; break;
+            case StartKind::COLD_AIDED: retVal = 30'000; break;
+            case StartKind::WARM:       retVal = 28'000; break;
+            case StartKind::HOT:        retVal =  2'000; break;
+            default: break;
+            }
+        }
+
+        return retVal;
+    }
+
+
+private:
+
+    // GPS broadcast ephemeris is good for ~4 hours
+    inline static const uint64_t EPHEMERIS_VALID_MS = 4 * 60 * 60 * 1'000;
+
+    // typical gap between windows until one is observed
+    inline static const uint64_t OFF_MS_DEFAULT = 10 * 60 * 1'000;
+
+    // module datasheet figures
+    inline static const uint32_t ACTIVE_CURRENT_UA = 25'000;
+    inline static const uint32_t BACKUP_CURRENT_UA = 15;
+
+    struct TtffStats
+    {
+        uint32_t count   = 0;
+        uint64_t totalMs = 0;
+        uint64_t minMs   = 0;
+        uint64_t maxMs   = 0;
+    };
+
+    array<TtffStats, (size_t)StartKind::COUNT> ttffStatsList_;
+
+    StartKind startKind_         = StartKind::COLD;
+    StartKind startKindExpected_ = StartKind::COLD;
+    bool      decisionMade_      = false;
+    uint64_t  timeAtPowerOnMs_   = 0;
+    bool      ttffRecorded_      = false;
+    bool      hadFix_            = false;
+
+    bool      haveEphemeris_     = false;
+    uint64_t  timeAtEphemerisMs_ = 0;
+
+    bool      backupOn_          = false;
+    uint64_t  timeAtPowerOffMs_  = 0;
+    uint64_t  backupOnTotalMs_   = 0;
+    uint64_t  offMsAvg_          = 0;
+    bool      offMsAvgValid_     = false;
+
+    uint32_t  keepCount_         = 0;
+    uint32_t  dropCount_         = 0;
+};
\ No newline at end of file
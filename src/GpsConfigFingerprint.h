@@ -0,0 +1,202 @@
+#pragma once
+
+#include "App.h"
+#include "FilesystemLittleFS.h"
+#include "NmeaSentence.h"
+
+#include <set>
+#include <string>
+using namespace std;
+
+
+// The GPS module keeps its configuration across power cycles as long as the
+// backup battery is up, so there is no need to send it on every enable.
+//
+// What was last sent is remembered as a fingerprint (firmware version and
+// configuration mode) in a file. If the fingerprint on record doesn't match
+// what this firmware wants, the configuration is sent.
+//
+// The module can't be asked what configuration it has, so it is verified by
+// what it says instead. The set of NMEA sentence types emitted right after
+// power up is a signature of the message rate configuration in effect. The
+// signature seen right after the full configuration was sent is recorded as
+// the reference, and any later signature which differs means the module lost
+// its configuration some way we didn't see, so the fingerprint is dropped.
+//
+// A fingerprint without a reference (eg recorded by older firmware) can't
+// be trusted either, so it fails the check and the configuration is sent.
+//
+// Anything which loses the module configuration (battery off, factory reset)
+// invalidates the fingerprint.
+class GpsConfigFingerprint
+{
+public:
+
+    static string Make(bool maxGpsMessages)
+    {
+        return Version::GetVersionShort() + ":" + (maxGpsMessages ? "max" : "min");
+    }
+
+    static bool IsCurrent(const string &fingerprint)
+    {
+        Load();
+
+        return fingerprint_ == fingerprint;
+    }
+
+    static void SetCurrent(const string &fingerprint)
+    {
+        Load();
+
+        if (fingerprint_ != fingerprint)
+        {
+            Log("GPS config fingerprint now ", fingerprint);
+
+            fingerprint_ = fingerprint;
+            signature_   = "";
+
+            Save();
+        }
+    }
+
+    static void Invalidate()
+    {
+        Load();
+
+        if (fingerprint_ != "")
+        {
+            Log("GPS config fingerprint invalidated");
+
+            fingerprint_ = "";
+            signature_   = "";
+
+            Save();
+        }
+    }
+
+    // only right after the configuration was sent
+    static void RecordSignature(const string &signature)
+    {
+        Load();
+
+        if (fingerprint_ == "" || signature == "") { return; }
+
+        if (signature_ != signature)
+        {
+            Log("GPS config signature recorded: ", signature);
+
+            signature_ = signature;
+
+            Save();
+        }
+    }
+
+    // returns false if the signature contradicts the fingerprint
+    static bool CheckSignature(const string &signature)
+    {
+        Load();
+
+        bool retVal = true;
+
+        if (fingerprint_ == "" || signature == "")
+        {
+            // nothing to compare, or nothing heard
+        }
+        else if (signature_ == "")
+        {
+            Log("GPS config signature has no reference, configuration unverified");
+
+            retVal = false;
+        }
+        else if (signature_ != signature)
+        {
+            Log("GPS config signature mismatch");
+            Log("- expected: ", signature_);
+            Log("- observed: ", signature);
+
+            retVal = false;
+        }
+
+        return retVal;
+    }
+
+    static void Report()
+    {
+        Load();
+
+        Log("GPS Config Fingerprint");
+        Log("- Fingerprint: ", fingerprint_ == "" ? "(none)" : fingerprint_);
+        Log("- Signature  : ", signature_   == "" ? "(none)" : signature_);
+    }
+
+
+public:
+
+    // accumulates the sentence types seen
+    class SignatureBuilder
+    {
+    public:
+
+        void Reset()
+        {
+            typeSet_.clear();
+        }
+
+        void OnSentence(const NmeaSentenceView &sentence)
+        {
+            // "GNGGA", only copied the first time seen
+            string_view address = sentence.GetAddress();
+            if (typeSet_.find(address) == typeSet_.end())
+            {
+                typeSet_.emplace(address);
+            }
+        }
+
+        string Get()
+        {
+            string retVal;
+
+            string sep = "";
+            for (const auto &type : typeSet_)
+            {
+                retVal += sep + type;
+                sep = ",";
+            }
+
+            return retVal;
+        }
+
+    private:
+
+        set<string, less<>> typeSet_;
+    };
+
+
+private:
+
+    static void Load()
+    {
+        if (loaded_) { return; }
+
+        vector<string> lineList = Split(FilesystemLittleFS::Read(FILE_NAME), "\n", false, true);
+
+        fingerprint_ = lineList.size() >= 1 ? lineList[0] : "";
+        signature_   = lineList.size() >= 2 ? lineList[1] : "";
+
+        loaded_ = true;
+    }
+
+    static void Save()
+    {
+        FilesystemLittleFS::Write(FILE_NAME, fingerprint_ + "\n" + signature_);
+    }
+
+
+private:
+
+    inline static const char *FILE_NAME = "gps.cfg";
+
+    inline static bool   loaded_      = false;
+    inline static string fingerprint_;
+    inline static string signature_;
+};
\ No newline at end of file
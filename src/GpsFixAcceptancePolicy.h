@@ -0,0 +1,294 @@
+#pragma once
+
+#include "App.h"
+#include "FilesystemLittleFS.h"
+#include "GPS.h"
+#include "NmeaSentence.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+// Decides whether a 3D fix is good enough to use, or whether to keep the
+// GPS on and wait for another.
+//
+// Quality comes from the GGA sentence (satellites used, HDOP), which is
+// tracked alongside the fixes GPSReader produces. A fix is:
+// - accepted immediately if quality is good
+// - accepted if quality is marginal, but it agrees with the fix before it
+//   (position and altitude moved no more than plausible in that time)
+// - accepted regardless once a configured number of fixes have been seen,
+//   so a poor sky never keeps the GPS on indefinitely
+//
+// The GGA tracked is the most recent seen when the fix arrives, which is
+// from the same reporting second or, at worst, the one before.
+//
+// The configuration is kept in a file, so it survives a reboot.
+class GpsFixAcceptancePolicy
+{
+public:
+
+    struct Config
+    {
+        uint8_t  minSats        = 6;
+        uint16_t maxHdopX100    = 250;
+        uint32_t maxJumpM       = 150;     // per second between fixes
+        uint32_t maxAltJumpM    = 50;      // per second between fixes
+        uint8_t  maxFixesToWait = 5;
+    };
+
+    enum class Decision : uint8_t
+    {
+        WAIT,
+        ACCEPT_GOOD,
+        ACCEPT_CONSISTENT,
+        ACCEPT_FALLBACK,
+    };
+
+    static const char *GetDecisionName(Decision decision)
+    {
+        const char *retVal = "";
+
+        switch (decision)
+        {
+        case Decision::WAIT:              retVal = "wait";                        break;
+        case Decision::ACCEPT_GOOD:       retVal = "accept (good quality)";       break;
+        case Decision::ACCEPT_CONSISTENT: retVal = "accept (consistent)";         break;
+        case Decision::ACCEPT_FALLBACK:   retVal = "accept (waited long enough)"; break;
+        }
+
+        return retVal;
+    }
+
+
+public:
+
+    Config &GetConfig()
+    {
+        Load();
+
+        return cfg_;
+    }
+
+    // Applies a new configuration only if every value is in range, otherwise
+    // leaves the current one and says which values were not.
+    bool SetConfig(int32_t minSats, double maxHdop, int32_t maxJumpM, int32_t maxAltJumpM, int32_t maxFixesToWait, string &err)
+    {
+        Load();
+
+        bool ok = ApplyConfig(minSats, maxHdop, maxJumpM, maxAltJumpM, maxFixesToWait, err);
+
+        if (ok)
+        {
+            Save();
+        }
+
+        return ok;
+    }
+
+    void Reset()
+    {
+        fixCount_ = 0;
+        havePrev_ = false;
+        sats_     = 0;
+        hdopX100_ = 0;
+        haveGga_  = false;
+    }
+
+    void OnGga(const NmeaSentenceView &gga)
+    {
+        // $GNGGA,time,lat,N,lng,E,quality,sats,hdop,alt,M,...
+        sats_     = (uint8_t)gga.GetFieldInt(7);
+        hdopX100_ = (uint16_t)gga.GetFieldX100(8);
+        haveGga_  = gga.GetField(8).empty() == false;
+    }
+
+    Decision OnFix3DPlus(const Fix3DPlus &fix)
+    {
+        Load();
+
+        ++fixCount_;
+
+        Decision retVal = Decision::WAIT;
+
+        bool goodQuality = haveGga_ && sats_ >= cfg_.minSats && hdopX100_ <= cfg_.maxHdopX100;
+
+        if (goodQuality)
+        {
+            retVal = Decision::ACCEPT_GOOD;
+        }
+        else if (havePrev_ && IsConsistent(prev_, fix))
+        {
+            retVal = Decision::ACCEPT_CONSISTENT;
+        }
+        else if (fixCount_ >= cfg_.maxFixesToWait)
+        {
+            retVal = Decision::ACCEPT_FALLBACK;
+        }
+
+        Log("Fix3DPlus #", fixCount_, ": sats ", sats_, ", hdop ", hdopX100_ / 100, ".", StrUtl::PadLeft(hdopX100_ % 100, '0', 2), " -> ", GetDecisionName(retVal));
+
+        prev_            = fix;
+        timeAtPrevFixMs_ = PAL.Millis();
+        havePrev_        = true;
+
+        if (retVal != Decision::WAIT)
+        {
+            ++acceptCountList_[(uint8_t)retVal];
+            fixesToAcceptTotal_ += fixCount_;
+        }
+
+        return retVal;
+    }
+
+    void Report()
+    {
+        Load();
+
+        uint32_t acceptCount = acceptCountList_[1] + acceptCountList_[2] + acceptCountList_[3];
+
+        Log("GPS Fix Acceptance");
+        Log("- min sats       : ", cfg_.minSats);
+        Log("- max hdop       : ", cfg_.maxHdopX100 / 100, ".", StrUtl::PadLeft(cfg_.maxHdopX100 % 100, '0', 2));
+        Log("- max jump       : ", Commas(cfg_.maxJumpM), " m/s, alt ", Commas(cfg_.maxAltJumpM), " m/s");
+        Log("- max fixes      : ", cfg_.maxFixesToWait);
+        Log("- accepted good  : ", acceptCountList_[(uint8_t)Decision::ACCEPT_GOOD]);
+        Log("- accepted consis: ", acceptCountList_[(uint8_t)Decision::ACCEPT_CONSISTENT]);
+        Log("- accepted fallbk: ", acceptCountList_[(uint8_t)Decision::ACCEPT_FALLBACK]);
+        if (acceptCount)
+        {
+            Log("- avg fixes seen : ", fixesToAcceptTotal_ * 100 / acceptCount / 100, ".", StrUtl::PadLeft(fixesToAcceptTotal_ * 100 / acceptCount % 100, '0', 2));
+        }
+    }
+
+
+private:
+
+    bool ApplyConfig(int32_t minSats, double maxHdop, int32_t maxJumpM, int32_t maxAltJumpM, int32_t maxFixesToWait, string &err)
+    {
+        bool ok = true;
+        string sep;
+
+        auto Check = [&](bool inRange, const char *what){
+            if (inRange == false)
+            {
+                ok = false;
+                err += sep + "Invalid " + what;
+                sep = ", ";
+            }
+        };
+
+        Check(minSats        >= MIN_SATS_MIN          && minSats        <= MIN_SATS_MAX,          "minSats");
+        Check(maxHdop        >= MAX_HDOP_MIN          && maxHdop        <= MAX_HDOP_MAX,          "maxHdop");
+        Check(maxJumpM       >= MAX_JUMP_M_MIN        && maxJumpM       <= MAX_JUMP_M_MAX,        "maxJumpM");
+        Check(maxAltJumpM    >= MAX_JUMP_M_MIN        && maxAltJumpM    <= MAX_JUMP_M_MAX,        "maxAltJumpM");
+        Check(maxFixesToWait >= MAX_FIXES_TO_WAIT_MIN && maxFixesToWait <= MAX_FIXES_TO_WAIT_MAX, "maxFixesToWait");
+
+        if (ok)
+        {
+            cfg_.minSats        = (uint8_t)minSats;
+            cfg_.maxHdopX100    = (uint16_t)round(maxHdop * 100);
+            cfg_.maxJumpM       = (uint32_t)maxJumpM;
+            cfg_.maxAltJumpM    = (uint32_t)maxAltJumpM;
+            cfg_.maxFixesToWait = (uint8_t)maxFixesToWait;
+        }
+
+        return ok;
+    }
+
+    bool IsConsistent(const Fix3DPlus &a, const Fix3DPlus &b)
+    {
+        // equirectangular approximation, fine at these distances
+        static const double M_PER_DEG = 111'320.0;
+
+        double latA = a.latDegMillionths / 1'000'000.0;
+        double latB = b.latDegMillionths / 1'000'000.0;
+        double lngA = a.lngDegMillionths / 1'000'000.0;
+        double lngB = b.lngDegMillionths / 1'000'000.0;
+
+        double dyM = (latB - latA) * M_PER_DEG;
+        double dxM = (lngB - lngA) * M_PER_DEG * cos((latA + latB) / 2 * M_PI / 180);
+        double dM  = sqrt(dxM * dxM + dyM * dyM);
+
+        int32_t dAltM = abs((int32_t)b.altitudeM - (int32_t)a.altitudeM);
+
+        // allow for the time between fixes, which is normally a second
+        uint32_t elapsedSec = max((uint64_t)1, (PAL.Millis() - timeAtPrevFixMs_ + 999) / 1'000);
+
+        return dM <= (double)cfg_.maxJumpM * elapsedSec && (uint32_t)dAltM <= cfg_.maxAltJumpM * elapsedSec;
+    }
+
+
+private:
+
+    /////////////////////////////////////////////////////////////////
+    // Persistence
+    /////////////////////////////////////////////////////////////////
+
+    // minSats,maxHdopX100,maxJumpM,maxAltJumpM,maxFixesToWait
+    //
+    // A file which doesn't hold a valid configuration leaves the defaults.
+    void Load()
+    {
+        if (loaded_) { return; }
+        loaded_ = true;
+
+        vector<string> partList = Split(FilesystemLittleFS::Read(FILE_NAME), ",");
+        if (partList.size() == 5)
+        {
+            string err;
+            if (ApplyConfig(atoi(partList[0].c_str()),
+                            atoi(partList[1].c_str()) / 100.0,
+                            atoi(partList[2].c_str()),
+                            atoi(partList[3].c_str()),
+                            atoi(partList[4].c_str()),
+                            err) == false)
+            {
+                Log("GPS fix acceptance: ignoring saved config: ", err);
+            }
+        }
+    }
+
+    void Save()
+    {
+        FilesystemLittleFS::Write(FILE_NAME,
+                                  to_string(cfg_.minSats)        + "," +
+                                  to_string(cfg_.maxHdopX100)    + "," +
+                                  to_string(cfg_.maxJumpM)       + "," +
+                                  to_string(cfg_.maxAltJumpM)    + "," +
+                                  to_string(cfg_.maxFixesToWait));
+    }
+
+
+private:
+
+    inline static const char *FILE_NAME = "gps.accept";
+
+    // a satellite count or hdop nothing reaches would always fall back, and
+    // waiting for 0 fixes would accept every fix without looking at it
+    inline static const int32_t MIN_SATS_MIN          = 1;
+    inline static const int32_t MIN_SATS_MAX          = 24;
+    inline static const double  MAX_HDOP_MIN          = 0.5;
+    inline static const double  MAX_HDOP_MAX          = 20.0;
+    inline static const int32_t MAX_JUMP_M_MIN        = 1;
+    inline static const int32_t MAX_JUMP_M_MAX        = 1'000;
+    inline static const int32_t MAX_FIXES_TO_WAIT_MIN = 1;
+    inline static const int32_t MAX_FIXES_TO_WAIT_MAX = 60;
+
+    Config cfg_;
+    bool   loaded_ = false;
+
+    uint8_t   sats_     = 0;
+    uint16_t  hdopX100_ = 0;
+    bool      haveGga_  = false;
+
+    uint8_t   fixCount_        = 0;
+    Fix3DPlus prev_;
+    uint64_t  timeAtPrevFixMs_ = 0;
+    bool      havePrev_        = false;
+
+    uint32_t acceptCountList_[4] = {};
+    uint32_t fixesToAcceptTotal_ = 0;
+};
\ No newline at end of file
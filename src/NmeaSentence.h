@@ -0,0 +1,381 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+using namespace std;
+
+
+// A tokenized view of an NMEA sentence, which references the line it was
+// made from rather than copying it. The line must outlive the view.
+//
+// "$GNGGA,123519,4807.038,N,...*47"
+//   field 0 = "GNGGA" (talker "GN", type "GGA")
+//   field 1 = "123519"
+//   ...
+//
+// Fields beyond MAX_FIELDS are not tokenized.
+class NmeaSentenceView
+{
+public:
+
+    inline static const uint8_t MAX_FIELDS = 24;
+
+    NmeaSentenceView(string_view line)
+    : line_(line)
+    {
+        Tokenize();
+    }
+
+    // The address ("GNGGA") straight off a raw line, without checksumming
+    // or tokenizing it, so a line can be passed over cheaply.
+    // Empty if the line doesn't start like a sentence.
+    static string_view GetAddressFromLine(string_view line)
+    {
+        string_view retVal;
+
+        // "$GNGGA,..."
+        if (line.size() >= 7 && line[0] == '$' && line[6] == ',')
+        {
+            retVal = line.substr(1, 5);
+        }
+
+        return retVal;
+    }
+
+    bool IsValid() const
+    {
+        return valid_;
+    }
+
+    string_view GetLine() const
+    {
+        return line_;
+    }
+
+    string_view GetAddress() const
+    {
+        return GetField(0);
+    }
+
+    string_view GetTalker() const
+    {
+        return GetAddress().substr(0, 2);
+    }
+
+    string_view GetType() const
+    {
+        string_view address = GetAddress();
+
+        return address.size() >= 5 ? address.substr(2, 3) : string_view{};
+    }
+
+    uint8_t GetFieldCount() const
+    {
+        return fieldCount_;
+    }
+
+    // empty if not present
+    string_view GetField(uint8_t idx) const
+    {
+        return idx < fieldCount_ ? fieldList_[idx] : string_view{};
+    }
+
+    // 0 if empty or not present
+    int32_t GetFieldInt(uint8_t idx) const
+    {
+        string_view field = GetField(idx);
+
+        int32_t retVal = 0;
+        for (char c : field)
+        {
+            if (c < '0' || c > '9') { break; }
+
+            retVal = retVal * 10 + (c - '0');
+        }
+
+        return retVal;
+    }
+
+    // fixed point, scaled by 100, 0 if empty or not present
+    // "1.27" -> 127
+    int32_t GetFieldX100(uint8_t idx) const
+    {
+        string_view field = GetField(idx);
+
+        int32_t whole    = 0;
+        int32_t frac     = 0;
+        int8_t  fracDigs = -1;
+        for (char c : field)
+        {
+            if (c == '.' && fracDigs == -1) { fracDigs = 0; continue; }
+            if (c < '0' || c > '9')         { break; }
+
+            if (fracDigs == -1)
+            {
+                whole = whole * 10 + (c - '0');
+            }
+            else if (fracDigs < 2)
+            {
+                frac = frac * 10 + (c - '0');
+                ++fracDigs;
+            }
+        }
+        if (fracDigs == 1) { frac *= 10; }
+
+        return whole * 100 + frac;
+    }
+
+
+private:
+
+    void Tokenize()
+    {
+        // tolerate line endings
+        while (line_.size() && (line_.back() == '\r' || line_.back() == '\n'))
+        {
+            line_.remove_suffix(1);
+        }
+
+        // $ + at least an address, then *XX
+        if (line_.size() < 9 || line_[0] != '$') { return; }
+
+        size_t starIdx = line_.rfind('*');
+        if (starIdx == string_view::npos || starIdx + 3 != line_.size()) { return; }
+
+        // checksum covers everything between $ and *
+        uint8_t ckSum = 0;
+        for (size_t i = 1; i < starIdx; ++i)
+        {
+            ckSum ^= (uint8_t)line_[i];
+        }
+
+        int hi = HexVal(line_[starIdx + 1]);
+        int lo = HexVal(line_[starIdx + 2]);
+        if (hi < 0 || lo < 0 || ckSum != (uint8_t)(hi << 4 | lo)) { return; }
+
+        // split fields in place
+        string_view body = line_.substr(1, starIdx - 1);
+        while (fieldCount_ < MAX_FIELDS)
+        {
+            size_t commaIdx = body.find(',');
+
+            fieldList_[fieldCount_] = body.substr(0, commaIdx);
+            ++fieldCount_;
+
+            if (commaIdx == string_view::npos) { break; }
+
+            body.remove_prefix(commaIdx + 1);
+        }
+
+        valid_ = true;
+    }
+
+    static int HexVal(char c)
+    {
+        int retVal = -1;
+
+        if      (c >= '0' && c <= '9') { retVal = c - '0';      }
+        else if (c >= 'A' && c <= 'F') { retVal = c - 'A' + 10; }
+        else if (c >= 'a' && c <= 'f') { retVal = c - 'a' + 10; }
+
+        return retVal;
+    }
+
+
+private:
+
+    string_view                    line_;
+    bool                           valid_      = false;
+    uint8_t                        fieldCount_ = 0;
+    array<string_view, MAX_FIELDS> fieldList_;
+};
+
+
+// A set of sentences by address, used to pass over the ones nobody wants
+// before they are tokenized.
+//
+// An entry is either a type ("GGA", any talker) or a talker and type
+// ("GNGGA"). An empty filter passes everything.
+class NmeaSentenceFilter
+{
+public:
+
+    inline static const uint8_t MAX_ENTRIES = 8;
+
+    void Clear()
+    {
+        entryCount_ = 0;
+    }
+
+    // comma separated, eg "GGA,GNRMC". "all" or empty clears.
+    bool Set(string_view csv, string &err)
+    {
+        Clear();
+
+        bool retVal = true;
+
+        if (csv == "all") { csv = {}; }
+
+        while (csv.empty() == false)
+        {
+            size_t      commaIdx = csv.find(',');
+            string_view entry    = csv.substr(0, commaIdx);
+
+            if (entry.size() != 3 && entry.size() != 5)
+            {
+                err = "entry \"" + string{entry} + "\" is not TYPE or TTTYPE";
+                retVal = false;
+                break;
+            }
+            if (entryCount_ == MAX_ENTRIES)
+            {
+                err = "more than " + to_string(MAX_ENTRIES) + " entries";
+                retVal = false;
+                break;
+            }
+
+            Entry &e = entryList_[entryCount_];
+            e.len = (uint8_t)entry.copy(e.str, sizeof(e.str));
+            ++entryCount_;
+
+            if (commaIdx == string_view::npos) { break; }
+            csv.remove_prefix(commaIdx + 1);
+        }
+
+        if (retVal == false)
+        {
+            Clear();
+        }
+
+        return retVal;
+    }
+
+    bool Passes(string_view address) const
+    {
+        bool retVal = entryCount_ == 0;
+
+        for (uint8_t i = 0; i < entryCount_ && retVal == false; ++i)
+        {
+            const Entry &e = entryList_[i];
+
+            if (e.len == 5)
+            {
+                retVal = address == string_view{e.str, 5};
+            }
+            else
+            {
+                retVal = address.size() == 5 && address.substr(2) == string_view{e.str, 3};
+            }
+        }
+
+        return retVal;
+    }
+
+    string ToString() const
+    {
+        string retVal;
+
+        if (entryCount_ == 0)
+        {
+            retVal = "all";
+        }
+
+        for (uint8_t i = 0; i < entryCount_; ++i)
+        {
+            if (i) { retVal += ","; }
+
+            retVal += string_view{entryList_[i].str, entryList_[i].len};
+        }
+
+        return retVal;
+    }
+
+
+private:
+
+    struct Entry
+    {
+        char    str[5] = {};
+        uint8_t len    = 0;
+    };
+
+    array<Entry, MAX_ENTRIES> entryList_;
+    uint8_t                   entryCount_ = 0;
+};
+
+
+// The CPU time spent on sentences, by type, so the cost of each can be
+// seen. Fixed size so recording never allocates, types beyond the table
+// are counted together under "...".
+class NmeaSentenceCost
+{
+public:
+
+    inline static const uint8_t MAX_TYPES = 16;
+
+    struct Entry
+    {
+        char     type[4] = {};
+        uint32_t count   = 0;
+        uint64_t totalUs = 0;
+        uint32_t maxUs   = 0;
+    };
+
+    void Record(string_view type, uint32_t durationUs)
+    {
+        Entry *entry = nullptr;
+        for (uint8_t i = 0; i < entryCount_; ++i)
+        {
+            if (type == entryList_[i].type)
+            {
+                entry = &entryList_[i];
+                break;
+            }
+        }
+        if (entry == nullptr)
+        {
+            if (entryCount_ < MAX_TYPES - 1)
+            {
+                entry = &entryList_[entryCount_];
+                ++entryCount_;
+
+                type.substr(0, 3).copy(entry->type, 3);
+            }
+            else
+            {
+                entry = &entryList_[MAX_TYPES - 1];
+
+                string_view{"..."}.copy(entry->type, 3);
+            }
+        }
+
+        ++entry->count;
+        entry->totalUs += durationUs;
+        entry->maxUs    = max(entry->maxUs, durationUs);
+    }
+
+    uint8_t GetEntryCount() const
+    {
+        return entryCount_ + (entryList_[MAX_TYPES - 1].count ? 1 : 0);
+    }
+
+    const Entry &GetEntry(uint8_t idx) const
+    {
+        return idx < entryCount_ ? entryList_[idx] : entryList_[MAX_TYPES - 1];
+    }
+
+    void Reset()
+    {
+        entryList_  = {};
+        entryCount_ = 0;
+    }
+
+
+private:
+
+    array<Entry, MAX_TYPES> entryList_;
+    uint8_t                 entryCount_ = 0;
+};
\ No newline at end of file
@@ -0,0 +1,221 @@
+#pragma once
+
+#include "App.h"
+#include "JSONMsgRouter.h"
+#include "TimeClass.h"
+
+#include "hardware/clocks.h"
+#include "hardware/rtc.h"
+#include "hardware/structs/scb.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "hardware/watchdog.h"
+#include "pico/util/datetime.h"
+
+#include <string>
+#include <vector>
+using namespace std;
+
+
+// Deep sleep gates every clock except the RTC, and stops the core until an
+// RTC alarm fires.
+//
+// While asleep the system timer does not count, which would otherwise leave
+// notional time (and every pending Timer) behind by the sleep duration.
+// The RTC is the only thing counting, so on wake the system timer is moved
+// forward by exactly the number of RTC seconds slept. The alarm fires on the
+// RTC second boundary, so the restored time is good to within one RTC clock
+// period (~21us).
+//
+// Resolution is whole seconds, callers should ask to wake a little before
+// anything actually needs to happen.
+class PowerDeepSleep
+{
+public:
+
+    PowerDeepSleep()
+    {
+        SetupShell();
+        SetupJSON();
+    }
+
+    // returns the duration actually slept, which is zero if the requested
+    // duration was too short to be worth it
+    uint64_t SleepUntilUs(uint64_t timeAtWakeUs)
+    {
+        uint64_t timeNowUs = PAL.Micros();
+
+        uint64_t durationUs = timeAtWakeUs > timeNowUs ? timeAtWakeUs - timeNowUs : 0;
+
+        return SleepForUs(durationUs);
+    }
+
+    uint64_t SleepForUs(uint64_t durationUs)
+    {
+        uint32_t durationSec = (uint32_t)(durationUs / 1'000'000);
+
+        if (durationSec < MIN_SLEEP_SEC)
+        {
+            return 0;
+        }
+
+        // keep well inside what a single day of RTC alarm can express
+        durationSec = min(durationSec, MAX_SLEEP_SEC);
+
+        LogModeSync();
+        Log("Deep sleep for ", Commas(durationSec), " sec");
+        LogModeAsync();
+
+        // the watchdog counts on the reference clock tick which is not
+        // going to be running, and there is nobody to feed it anyway.
+        // it may not be running at all (eg test configurations).
+        bool watchdogWasEnabled = (watchdog_hw->ctrl & WATCHDOG_CTRL_ENABLE_BITS) != 0;
+        if (watchdogWasEnabled)
+        {
+            Watchdog::Feed();
+            hw_clear_bits(&watchdog_hw->ctrl, WATCHDOG_CTRL_ENABLE_BITS);
+        }
+
+        // run the RTC directly from the crystal so it is independent of
+        // whatever the PLLs are doing at the moment
+        clock_configure(clk_rtc,
+                        0,
+                        CLOCKS_CLK_RTC_CTRL_AUXSRC_VALUE_XOSC_CLKSRC,
+                        XOSC_MHZ * MHZ,
+                        RTC_CLOCK_HZ);
+        rtc_init();
+
+        // the RTC is used as a stopwatch from an arbitrary, valid, reference
+        datetime_t dtStart = {
+            .year  = 2000,
+            .month = 1,
+            .day   = 1,
+            .dotw  = 6,
+            .hour  = 0,
+            .min   = 0,
+            .sec   = 0,
+        };
+        datetime_t dtAlarm = dtStart;
+        dtAlarm.hour = (int8_t)( durationSec / 3'600);
+        dtAlarm.min  = (int8_t)((durationSec % 3'600) / 60);
+        dtAlarm.sec  = (int8_t)( durationSec % 60);
+
+        awake_ = false;
+
+        uint32_t sleepEn0 = clocks_hw->sleep_en0;
+        uint32_t sleepEn1 = clocks_hw->sleep_en1;
+
+        rtc_set_datetime(&dtStart);
+        uint64_t timeAtSleepUs = time_us_64();
+        rtc_set_alarm(&dtAlarm, []{
+            awake_ = true;
+        });
+
+        // only the RTC keeps its clock while the core is asleep
+        clocks_hw->sleep_en0 = CLOCKS_SLEEP_EN0_CLK_RTC_RTC_BITS;
+        clocks_hw->sleep_en1 = 0;
+        scb_hw->scr |= M0PLUS_SCR_SLEEPDEEP_BITS;
+
+        while (awake_ == false)
+        {
+            __wfi();
+        }
+
+        scb_hw->scr &= ~M0PLUS_SCR_SLEEPDEEP_BITS;
+        clocks_hw->sleep_en0 = sleepEn0;
+        clocks_hw->sleep_en1 = sleepEn1;
+
+        rtc_disable_alarm();
+
+        // move the system timer forward by the time it didn't see
+        uint64_t durationSleptUs = (uint64_t)durationSec * 1'000'000;
+        uint64_t durationSeenUs  = time_us_64() - timeAtSleepUs;
+        if (durationSleptUs > durationSeenUs)
+        {
+            AdvanceSystemTimerUs(durationSleptUs - durationSeenUs);
+        }
+
+        // bring the watchdog back, only if something is there to feed it
+        if (watchdogWasEnabled)
+        {
+            Watchdog::Start();
+            Watchdog::Feed();
+        }
+
+        ++sleepCount_;
+        durationSleptTotalUs_ += durationSleptUs;
+
+        LogModeSync();
+        Log("Deep sleep woke after ", Commas(durationSec), " sec (timer moved forward ", Commas(durationSleptUs - min(durationSleptUs, durationSeenUs)), " us)");
+        LogModeAsync();
+
+        return durationSleptUs;
+    }
+
+
+private:
+
+    void AdvanceSystemTimerUs(uint64_t durationUs)
+    {
+        uint32_t irqState = save_and_disable_interrupts();
+
+        uint64_t timeNowUs = time_us_64() + durationUs;
+
+        // lower word must be written first
+        timer_hw->timelw = (uint32_t)(timeNowUs);
+        timer_hw->timehw = (uint32_t)(timeNowUs >> 32);
+
+        restore_interrupts(irqState);
+
+        // any armed alarm targets may have just been skipped over rather
+        // than matched, so have each alarm handler re-evaluate now
+        for (uint alarmNum = 0; alarmNum < NUM_TIMERS; ++alarmNum)
+        {
+            if (timer_hw->armed & (1u << alarmNum))
+            {
+                hardware_alarm_force_irq(alarmNum);
+            }
+        }
+    }
+
+
+private:
+
+    void SetupShell()
+    {
+        Shell::AddCommand("app.power.sleep", [this](vector<string> argList){
+            uint32_t durationSec = (uint32_t)atoi(argList[0].c_str());
+
+            SleepForUs((uint64_t)durationSec * 1'000'000);
+        }, { .argCount = 1, .help = "deep sleep for <sec>"});
+
+        Shell::AddCommand("app.power.sleep.stats", [this](vector<string> argList){
+            Log("Deep sleep count: ", Commas(sleepCount_));
+            Log("Deep sleep total: ", Time::MakeDurationFromUs(durationSleptTotalUs_));
+        }, { .argCount = 0, .help = "report deep sleep stats"});
+    }
+
+    void SetupJSON()
+    {
+        JSONMsgRouter::RegisterHandler("REQ_GET_DEEP_SLEEP_STATS", [this](auto &in, auto &out){
+            out["type"] = "REP_GET_DEEP_SLEEP_STATS";
+
+            out["count"]        = sleepCount_;
+            out["totalSleptMs"] = durationSleptTotalUs_ / 1'000;
+        });
+    }
+
+
+private:
+
+    // 12MHz crystal / 256
+    inline static const uint32_t RTC_CLOCK_HZ = 46'875;
+
+    inline static const uint32_t MIN_SLEEP_SEC = 1;
+    inline static const uint32_t MAX_SLEEP_SEC = 23 * 60 * 60;
+
+    inline static volatile bool awake_ = false;
+
+    uint32_t sleepCount_           = 0;
+    uint64_t durationSleptTotalUs_ = 0;
+};
\ No newline at end of file
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "App.h"
+
+#include <array>
+#include <functional>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+// Peripherals which are only needed during certain phases of operation are
+// clocked only while some phase which needs them is active.
+//
+// Phases declare themselves as a Use. The table below says which Uses need
+// which peripheral. A peripheral is enabled while any of its Uses are
+// active, and disabled otherwise.
+//
+// Gating does nothing until started, so that configuration mode (USB
+// powered, everything in play) is unaffected.
+//
+// Not gated:
+// - USB, which is already powered down by USB::EnablePowerSaveMode() and
+//   brought back on VBUS detection, outside the knowledge of this table.
+class PowerPeripheralGating
+{
+public:
+
+    enum class Use : uint8_t
+    {
+        GPS,        // gps module powered, NMEA arriving on UART1
+        JS,         // slot javascript running, user sensors on I2C1 and ADC
+        RADIO,      // transmitter powered, Si5351 on I2C0
+        SAMPLING,   // internal ADC readings (VCC, temperature)
+        COUNT,
+    };
+
+private:
+
+    using Peripheral = decltype(PeripheralControl::UART1);
+
+    struct GatingRule
+    {
+        Peripheral  peripheral;
+        const char *name;
+        vector<Use> useList;
+
+        bool enabled = true;
+    };
+
+    inline static vector<GatingRule> gatingRuleList_ = {
+        { PeripheralControl::UART1, "UART1", { Use::GPS                } },
+        { PeripheralControl::I2C0,  "I2C0",  { Use::RADIO              } },
+        { PeripheralControl::I2C1,  "I2C1",  { Use::JS                 } },
+        { PeripheralControl::ADC,   "ADC",   { Use::JS, Use::SAMPLING  } },
+    };
+
+    inline static array<uint8_t, (size_t)Use::COUNT> useCountList_ = {};
+
+    inline static bool started_ = false;
+
+
+public:
+
+    static void Start()
+    {
+        Log("Peripheral gating started");
+
+        started_ = true;
+
+        Apply();
+    }
+
+    // For uses which are on or off, like a module being powered.
+    // Safe to call repeatedly.
+    static void SetInUse(Use use, bool inUse)
+    {
+        useCountList_[(size_t)use] = inUse ? 1 : 0;
+
+        Apply();
+    }
+
+    // For uses which are scoped around some work, may be nested.
+    static void WhileInUse(Use use, function<void()> fn)
+    {
+        ++useCountList_[(size_t)use];
+        Apply();
+
+        fn();
+
+        if (useCountList_[(size_t)use]) { --useCountList_[(size_t)use]; }
+        Apply();
+    }
+
+    static void Report()
+    {
+        Log("Peripheral Gating (", started_ ? "started" : "not started", ")");
+        for (const auto &rule : gatingRuleList_)
+        {
+            string useListStr;
+            string sep = "";
+            for (auto use : rule.useList)
+            {
+                useListStr += sep + GetUseName(use);
+                sep = ", ";
+            }
+
+            Log("- ", StrUtl::PadRight(rule.name, ' ', 5), ": ", rule.enabled ? "on " : "off", " (needed by ", useListStr, ")");
+        }
+        for (size_t i = 0; i < useCountList_.size(); ++i)
+        {
+            Log("- Use ", StrUtl::PadRight(GetUseName((Use)i), ' ', 8), ": ", useCountList_[i] ? "active" : "idle");
+        }
+    }
+
+    static void SetupShell()
+    {
+        Shell::AddCommand("app.power.gating", [](vector<string> argList){
+            Report();
+        }, { .argCount = 0, .help = "show peripheral gating state"});
+    }
+
+
+private:
+
+    static void Apply()
+    {
+        if (started_ == false) { return; }
+
+        for (auto &rule : gatingRuleList_)
+        {
+            bool needed = false;
+            for (auto use : rule.useList)
+            {
+                needed |= useCountList_[(size_t)use] != 0;
+            }
+
+            if (needed != rule.enabled)
+            {
+                if (needed) { PeripheralControl::EnablePeripheralList({ rule.peripheral });  }
+                else        { PeripheralControl::DisablePeripheralList({ rule.peripheral }); }
+
+                rule.enabled = needed;
+            }
+        }
+    }
+
+    static const char *GetUseName(Use use)
+    {
+        const char *retVal = "";
+
+        switch (use)
+        {
+        case Use::GPS:      retVal = "GPS";      break;
+        case Use::JS:       retVal = "JS";       break;
+        case Use::RADIO:    retVal = "RADIO";    break;
+        case Use::SAMPLING: retVal = "SAMPLING"; break;
+        default: break;
+        }
+
+        return retVal;
+    }
+};
\ No newline at end of file
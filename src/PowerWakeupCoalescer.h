@@ -0,0 +1,175 @@
+#pragma once
+
+#include "App.h"
+#include "JSONMsgRouter.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+// Periodic housekeeping (watchdog feeding, idle LED blinks, etc) used to
+// each run off of their own Timer, meaning each got its own wakeup at its
+// own unrelated instant.
+//
+// The coalescer owns a single interval Timer and runs each registered task
+// on a multiple of that base tick. Work which used to be spread out now
+// shares the same wakeup, and between ticks the event loop has nothing to
+// do, so the core stays idle for the full tick.
+//
+// Wakeup counts are kept so the reduction can be observed on a real device.
+class PowerWakeupCoalescer
+{
+    struct Task
+    {
+        string           name;
+        uint32_t         everyNTicks = 1;
+        function<void()> fn          = []{};
+        bool             enabled     = true;
+
+        uint32_t runCount = 0;
+    };
+
+public:
+
+    PowerWakeupCoalescer(uint32_t tickMs)
+    : tickMs_(tickMs)
+    {
+        timer_.SetCallback([this]{
+            OnTick();
+        });
+
+        SetupShell();
+        SetupJSON();
+    }
+
+    uint32_t GetTickMs()
+    {
+        return tickMs_;
+    }
+
+    // tasks run in the order added when they share a tick
+    void AddTask(const string &name, uint32_t everyNTicks, function<void()> fn, bool enabled = true)
+    {
+        taskList_.push_back({
+            .name        = name,
+            .everyNTicks = everyNTicks ? everyNTicks : 1,
+            .fn          = fn,
+            .enabled     = enabled,
+        });
+    }
+
+    void SetTaskEnabled(const string &name, bool enabled)
+    {
+        for (auto &task : taskList_)
+        {
+            if (task.name == name)
+            {
+                task.enabled = enabled;
+            }
+        }
+    }
+
+    void Start()
+    {
+        if (timer_.IsPending()) { return; }
+
+        timeAtStartUs_ = PAL.Micros();
+
+        timer_.TimeoutIntervalMs(tickMs_, 0);
+    }
+
+    void Stop()
+    {
+        timer_.Cancel();
+    }
+
+    uint32_t GetWakeupCount()
+    {
+        return wakeupCount_;
+    }
+
+
+private:
+
+    void OnTick()
+    {
+        ++wakeupCount_;
+
+        for (auto &task : taskList_)
+        {
+            if (task.enabled && (tickCount_ % task.everyNTicks) == 0)
+            {
+                ++task.runCount;
+
+                task.fn();
+            }
+        }
+
+        ++tickCount_;
+    }
+
+    // wakeups per minute, scaled by 100 to keep two decimal places
+    uint32_t GetWakeupsPerMinuteX100()
+    {
+        uint64_t durationUs = PAL.Micros() - timeAtStartUs_;
+        uint64_t durationMs = durationUs / 1'000;
+
+        uint32_t retVal = 0;
+        if (durationMs)
+        {
+            retVal = (uint32_t)((uint64_t)wakeupCount_ * 60 * 1'000 * 100 / durationMs);
+        }
+
+        return retVal;
+    }
+
+    void Report()
+    {
+        uint32_t perMinX100 = GetWakeupsPerMinuteX100();
+
+        Log("Wakeup Coalescer");
+        Log("- Tick       : ", Commas(tickMs_), " ms");
+        Log("- Wakeups    : ", Commas(wakeupCount_));
+        Log("- Per Minute : ", perMinX100 / 100, ".", StrUtl::PadLeft(perMinX100 % 100, '0', 2));
+        for (const auto &task : taskList_)
+        {
+            Log("- ", StrUtl::PadRight(task.name, ' ', 16), ": every ", Commas(task.everyNTicks * tickMs_), " ms, ", task.enabled ? "enabled" : "disabled", ", ", Commas(task.runCount), " runs");
+        }
+    }
+
+
+private:
+
+    void SetupShell()
+    {
+        Shell::AddCommand("app.power.wakeups", [this](vector<string> argList){
+            Report();
+        }, { .argCount = 0, .help = "report coalesced wakeup counts"});
+    }
+
+    void SetupJSON()
+    {
+        JSONMsgRouter::RegisterHandler("REQ_GET_WAKEUP_STATS", [this](auto &in, auto &out){
+            out["type"] = "REP_GET_WAKEUP_STATS";
+
+            out["tickMs"]           = tickMs_;
+            out["wakeups"]          = wakeupCount_;
+            out["wakeupsPerMinute"] = GetWakeupsPerMinuteX100() / 100.0;
+        });
+    }
+
+
+private:
+
+    uint32_t tickMs_ = 0;
+
+    Timer timer_ = { "TIMER_WAKEUP_COALESCER" };
+
+    vector<Task> taskList_;
+
+    uint32_t tickCount_     = 0;
+    uint32_t wakeupCount_   = 0;
+    uint64_t timeAtStartUs_ = 0;
+};
\ No newline at end of file
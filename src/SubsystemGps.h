@@ -2,8 +2,20 @@
 
 #include "App.h"
 #include "GPS.h"
+#include "GpsAiding.h"
+#include "GpsBackupPolicy.h"
+#include "GpsConfigFingerprint.h"
+#include "GpsFixAcceptancePolicy.h"
 #include "JSONMsgRouter.h"
+#include "NmeaSentence.h"
+#include "PowerPeripheralGating.h"
 #include "TimeClass.h"
+#include "UartRxBatching.h"
+
+#include "hardware/uart.h"
+
+#include <array>
+using namespace std;
 
 
 class SubsystemGps
@@ -12,6 +24,20 @@ public:
 
     SubsystemGps()
     {
+        timerSeq_.SetCallback([this]{
+            SeqRunSteps();
+        });
+
+        timerCfgVerify_.SetCallback([this]{
+            OnConfigVerifyWindowEnd();
+        });
+
+        // the single place NMEA lines are handed out to anything in this
+        // application (the GPSReader has its own path)
+        UartAddLineStreamCallback(UART::UART_1, [this](const string &line){
+            OnNmeaLine(line);
+        });
+
         UartDisable(UART::UART_1);
 
         Disable();
@@ -37,6 +63,39 @@ public:
         EnableInternal(false);
     }
 
+    void EnableFlightModeAsync(function<void()> fnCbOnDone)
+    {
+        EnableInternalAsync(false, fnCbOnDone);
+    }
+
+    void EnableInternalAsync(bool maxGpsMessages, function<void()> fnCbOnDone)
+    {
+        vector<SeqStep> stepList = GetStepListPowerOnBatteryOn();
+        auto Append = [&](const vector<SeqStep> &stepListMore){
+            for (const auto &step : stepListMore)
+            {
+                stepList.push_back(step);
+            }
+        };
+
+        Append(GetStepListWriterMonitor());
+        if (GpsConfigFingerprint::IsCurrent(GpsConfigFingerprint::Make(maxGpsMessages)))
+        {
+            // module should already have it, check in the background
+            Log("GPS config current, not sending");
+            Append(GetStepListReaderMonitor());
+            stepList.push_back({ "VERIFY_CONFIG", [=, this]{ StartConfigVerify(maxGpsMessages, false); }, 0 });
+        }
+        else
+        {
+            Append(GetStepListSendConfig(maxGpsMessages));
+            Append(GetStepListReaderMonitor());
+            stepList.push_back({ "RECORD_CONFIG", [=, this]{ StartConfigVerify(maxGpsMessages, true); }, 0 });
+        }
+
+        SeqStart("Enable", stepList, fnCbOnDone);
+    }
+
     void EnableInternal(bool maxGpsMessages)
     {
         ModulePowerOnBatteryOn();
@@ -56,10 +115,13 @@ public:
             gpsWriter_.SendModuleMessageRateConfigurationMinimal();
         }
         gpsWriter_.SendModuleSaveConfiguration();
+        GpsConfigFingerprint::SetCurrent(GpsConfigFingerprint::Make(maxGpsMessages));
 
         // Start decoding NMEA
         gpsReader_.Reset();
         gpsReader_.StartMonitoring();
+
+        StartConfigVerify(maxGpsMessages, true);
     }
 
     void RequestNewFixTimeAnd3DPlus(function<void(const FixTime   &)> fnCbOnFixTime,
@@ -73,7 +135,14 @@ public:
 
         gpsReader_.Reset();
 
-        gpsReader_.SetCallbackOnFixTime([=, this](const FixTime &fix){
+        // track fix quality alongside the fixes themselves
+        fixAcceptance_.Reset();
+        fixAcceptanceActive_ = true;
+
+        gpsReader_.SetCallbackOnFixTime([=, this](const FixTime &fixIn){
+            FixTime fix = fixIn;
+            UseBurstTimestamp(fix);
+
             Log("Got FixTime   in ", Time::MakeTimeMMSSmmmFromMs(PAL.Millis() - timeStart), " at GPS Time ", fix.dateTime, " UTC");
             fix.Print();
 
@@ -89,18 +158,26 @@ public:
             fix.Print();
             gpsReader_.UnSetCallbackOnFix2D();
         });
-        gpsReader_.SetCallbackOnFix3DPlus([=, this](const Fix3DPlus &fix){
+        gpsReader_.SetCallbackOnFix3DPlus([=, this](const Fix3DPlus &fixIn){
+            Fix3DPlus fix = fixIn;
+            UseBurstTimestamp(fix);
+
             ++count;
 
-            // let a few locks go by, hopefully bringing figures closer to
-            // accurate where that is possible.  this is not a deeply researched
-            // area, mostly leaving in place for historical purposes.  eyeballing
-            // the data doesn't show any improvement in such a small delay.
-            if (count == 2)
+            if (count == 1)
+            {
+                OnFirstFix3DPlusSincePowerOn();
+            }
+
+            // take the first fix of good enough quality, only waiting
+            // for more when quality is marginal
+            if (fixAcceptance_.OnFix3DPlus(fix) != GpsFixAcceptancePolicy::Decision::WAIT)
             {
                 Log("Got Fix3DPlus in ", Time::MakeTimeMMSSmmmFromMs(PAL.Millis() - timeStart), " at GPS Time ", fix.dateTime, " UTC");
                 fix.Print();
                 LogNL();
+                StopFixAcceptance();
+                aiding_.OnFix3DPlus(fix);
                 fnCbOnFix3dPlus(fix);
                 gpsReader_.UnSetCallbackOnFix3DPlus();
             }
@@ -109,6 +186,7 @@ public:
 
     void CancelNewFix3DPlus()
     {
+        StopFixAcceptance();
         gpsReader_.UnSetCallbackOnFix3DPlus();
     }
 
@@ -116,31 +194,49 @@ public:
     {
         Log("GPS Monitor Mode");
 
-        UartAddLineStreamCallback(UART::UART_1, [this](const string &line){
-            if (NMEAStringParser::IsValid(line))
-            {
-                router_.Send([&](const auto &out){
-                    out["type"] = "GPS_LINE";
-                    out["line"] = line.c_str();
-                });
-            }
-        });
+        monitorForwarding_ = true;
 
         StartMonitorLockSequenceWeb();
     }
 
     void Disable()
     {
+        SeqCancel();
+        StopConfigVerify();
+        StopFixAcceptance();
+
         gpsReader_.StopMonitoring();
         gpsWriter_.StopMonitorForReplies();
 
-        ModulePowerOffBatteryOn();
+        if (modulePowered_ && backupPolicy_.DecideKeepBackup(aiding_.GetEnabled()) == false)
+        {
+            ModulePowerOff();
+        }
+        else
+        {
+            ModulePowerOffBatteryOn();
+        }
     }
 
     GPSReader &GetGPSReader()
     {
         return gpsReader_;
     }
+
+    uint32_t GetNmeaLineCount()
+    {
+        return nmeaLineCount_;
+    }
+
+    void SetNmeaEcho(bool echo)
+    {
+        nmeaEcho_ = echo;
+    }
+
+    bool GetNmeaEcho()
+    {
+        return nmeaEcho_;
+    }
     
 
 private:
@@ -177,18 +273,19 @@ public:
 
     void ModulePowerOnBatteryOn()
     {
-        Log("GPS Module Power On, Battery On");
-
-        // enable power
-        pinGpsLoadSwitchOnOff_.DigitalWrite(0);
-        pinGpsReset_.DigitalWrite(1);
-        pinGpsBatteryPowerOnOff_.DigitalWrite(1);
+        ModulePowerOnBatteryOnStart();
 
         // Give it time to start up
-        PAL.Delay(500);
+        PAL.Delay(MODULE_POWER_ON_SETTLE_MS);
 
-        // enable uart function, this overrides the previous pin function
-        UartEnable(UART::UART_1);
+        ModulePowerOnBatteryOnFinish();
+        SendAidingIfPending();
+        PAL.Delay(CMD_GAP_MS);
+    }
+
+    void ModulePowerOnBatteryOnAsync(function<void()> fnCbOnDone)
+    {
+        SeqStart("PowerOn", GetStepListPowerOnBatteryOn(), fnCbOnDone);
     }
 
     void ModulePowerOffBatteryOn(bool log = true)
@@ -201,6 +298,8 @@ public:
         // prevent interrupts and any data processing for testing mode
         // when the signals above don't affect external module
         UartDisable(UART::UART_1);
+        PowerPeripheralGating::SetInUse(PowerPeripheralGating::Use::GPS, false);
+        modulePowered_ = false;
 
         // Drive pin low to avoid current draw from GPS
         // this overrides the previous uart function
@@ -220,6 +319,13 @@ public:
         ModulePowerOffBatteryOn(false);
 
         pinGpsBatteryPowerOnOff_.DigitalWrite(0);
+
+        // configuration is not retained without the battery
+        GpsConfigFingerprint::Invalidate();
+
+        // neither is anything else
+        moduleCold_ = true;
+        backupPolicy_.OnBackupLost();
     }
 
     void ModuleHardReset()
@@ -228,10 +334,403 @@ public:
         gpsWriter_.SendModuleResetColdCasic();
 
         ModulePowerOff();
-        PAL.Delay(1'000);
+        PAL.Delay(MODULE_HARD_RESET_OFF_MS);
         ModulePowerOnBatteryOn();
     }
 
+    void ModuleHardResetAsync(function<void()> fnCbOnDone)
+    {
+        vector<SeqStep> stepList = {
+            { "SEND_FACTORY_RESET", [this]{ gpsWriter_.SendModuleFactoryResetConfiguration(); }, CMD_GAP_MS               },
+            { "SEND_COLD_RESET",    [this]{ gpsWriter_.SendModuleResetColdCasic();            }, CMD_GAP_MS               },
+            { "POWER_OFF",          [this]{ ModulePowerOff();                                 }, MODULE_HARD_RESET_OFF_MS },
+        };
+        for (const auto &step : GetStepListPowerOnBatteryOn())
+        {
+            stepList.push_back(step);
+        }
+
+        SeqStart("HardReset", stepList, fnCbOnDone);
+    }
+
+    bool IsSequenceInProgress()
+    {
+        return seqStepList_.empty() == false;
+    }
+
+private:
+
+    void ModulePowerOnBatteryOnStart()
+    {
+        Log("GPS Module Power On, Battery On");
+
+        // battery keeps the module warm from here on, but aid this start
+        // if it was cold
+        backupPolicy_.OnPowerOn(moduleCold_);
+        aidPending_    = moduleCold_;
+        moduleCold_    = false;
+        modulePowered_ = true;
+
+        // enable power
+        pinGpsLoadSwitchOnOff_.DigitalWrite(0);
+        pinGpsReset_.DigitalWrite(1);
+        pinGpsBatteryPowerOnOff_.DigitalWrite(1);
+    }
+
+    void ModulePowerOnBatteryOnFinish()
+    {
+        // enable uart function, this overrides the previous pin function
+        PowerPeripheralGating::SetInUse(PowerPeripheralGating::Use::GPS, true);
+        UartEnable(UART::UART_1);
+        UartRxBatching::Apply();
+    }
+
+    // Aiding goes out as the first command once the UART is up, and is
+    // given the same gap as the GPSWriter commands which may follow.
+    void SendAidingIfPending()
+    {
+        if (aidPending_ == false) { return; }
+        aidPending_ = false;
+
+        vector<uint8_t> frame;
+        if (aiding_.MakeFrame(frame))
+        {
+            SendToModule(frame);
+
+            backupPolicy_.OnAided();
+        }
+    }
+
+    // For frames GPSWriter has no command for. Only called from a sequence
+    // step, so it never lands in the middle of a GPSWriter command.
+    void SendToModule(const vector<uint8_t> &frame)
+    {
+        uart_write_blocking(uart1, frame.data(), frame.size());
+    }
+
+
+    /////////////////////////////////////////////////////////////////
+    // Asynchronous Power Sequencing
+    /////////////////////////////////////////////////////////////////
+
+    // Power up, configuration and hard reset are each a list of steps.
+    // Waiting between steps (module boot, reset hold, letting a command
+    // drain out of the UART) is done on a timer rather than in a delay,
+    // so the event loop keeps running while the module gets ready.
+    //
+    // One sequence runs at a time. Starting another, or Disable(), drops
+    // the one in progress without calling its completion callback.
+
+    struct SeqStep
+    {
+        const char       *name;
+        function<void()>  fn;
+        uint32_t          delayAfterMs = 0;
+    };
+
+    vector<SeqStep> GetStepListPowerOnBatteryOn()
+    {
+        return {
+            { "POWER_ON",    [this]{ ModulePowerOnBatteryOnStart();  }, MODULE_POWER_ON_SETTLE_MS },
+            { "UART_ENABLE", [this]{ ModulePowerOnBatteryOnFinish(); }, 0                         },
+            { "SEND_AIDING", [this]{ SendAidingIfPending();          }, CMD_GAP_MS                },
+        };
+    }
+
+    vector<SeqStep> GetStepListWriterMonitor()
+    {
+        return {
+            { "WRITER_MONITOR", [this]{
+                // Have GPSWriter watch for NMEA/UBX messages (replies to commands)
+                gpsWriter_.Reset();
+                gpsWriter_.StartMonitorForReplies();
+            }, 0 },
+        };
+    }
+
+    vector<SeqStep> GetStepListSendConfig(bool maxGpsMessages)
+    {
+        return {
+            { "SEND_HIGH_ALTITUDE", [this]{
+                gpsWriter_.SendHighAltitudeMode();
+            }, CMD_GAP_MS },
+            { "SEND_MESSAGE_RATE", [this, maxGpsMessages]{
+                if (maxGpsMessages)
+                {
+                    gpsWriter_.SendModuleMessageRateConfigurationMaximal();
+                }
+                else
+                {
+                    gpsWriter_.SendModuleMessageRateConfigurationMinimal();
+                }
+            }, CMD_GAP_MS },
+            { "SEND_SAVE", [this, maxGpsMessages]{
+                gpsWriter_.SendModuleSaveConfiguration();
+                GpsConfigFingerprint::SetCurrent(GpsConfigFingerprint::Make(maxGpsMessages));
+            }, CMD_GAP_MS },
+        };
+    }
+
+    vector<SeqStep> GetStepListReaderMonitor()
+    {
+        return {
+            { "READER_MONITOR", [this]{
+                // Start decoding NMEA
+                gpsReader_.Reset();
+                gpsReader_.StartMonitoring();
+            }, 0 },
+        };
+    }
+
+    void SeqStart(const char *seqName, const vector<SeqStep> &stepList, function<void()> fnCbOnDone)
+    {
+        SeqCancel();
+
+        seqName_        = seqName;
+        seqStepList_    = stepList;
+        seqIdx_         = 0;
+        fnCbSeqDone_    = fnCbOnDone;
+        timeAtSeqStart_ = PAL.Millis();
+
+        SeqRunSteps();
+    }
+
+    void SeqCancel()
+    {
+        if (IsSequenceInProgress())
+        {
+            Log("GPS sequence ", seqName_, " cancelled at step ", seqIdx_, " of ", seqStepList_.size());
+        }
+
+        timerSeq_.Cancel();
+        seqStepList_.clear();
+        seqIdx_      = 0;
+        fnCbSeqDone_ = nullptr;
+    }
+
+    void SeqRunSteps()
+    {
+        while (seqIdx_ < seqStepList_.size())
+        {
+            // copy out, the step may not outlive its own execution
+            function<void()> fn           = seqStepList_[seqIdx_].fn;
+            uint32_t         delayAfterMs = seqStepList_[seqIdx_].delayAfterMs;
+            ++seqIdx_;
+
+            fn();
+
+            if (delayAfterMs)
+            {
+                timerSeq_.TimeoutInMs(delayAfterMs);
+
+                return;
+            }
+        }
+
+        Log("GPS sequence ", seqName_, " complete in ", Commas(PAL.Millis() - timeAtSeqStart_), " ms");
+
+        function<void()> fnCbOnDone = fnCbSeqDone_;
+        seqStepList_.clear();
+        seqIdx_      = 0;
+        fnCbSeqDone_ = nullptr;
+
+        if (fnCbOnDone)
+        {
+            fnCbOnDone();
+        }
+    }
+
+
+    /////////////////////////////////////////////////////////////////
+    // NMEA Lines
+    /////////////////////////////////////////////////////////////////
+
+    // Runs for every line the module sends, alongside the GPSReader, so
+    // does as little as it can. The address is checked on the raw line
+    // first, and lines nobody currently wants are passed over without
+    // being checksummed or tokenized. The rest are tokenized once, and the
+    // same view given to each consumer.
+    //
+    // In flight, only GGA is wanted, and only while a fix is requested.
+    void OnNmeaLine(const string &line)
+    {
+        ++nmeaLineCount_;
+
+        UartRxBatching::OnLine(line);
+
+        if (nmeaEcho_)
+        {
+            UartTarget target(UART::UART_0);
+            Log(line);
+        }
+
+        string_view address = NmeaSentenceView::GetAddressFromLine(line);
+        string_view type    = address.size() == 5 ? address.substr(2) : string_view{};
+
+        bool wantMonitor = monitorForwarding_ && nmeaFilter_.Passes(address);
+        bool wantGga     = fixAcceptanceActive_ && type == "GGA";
+
+        if (wantMonitor == false && cfgVerifying_ == false && wantGga == false)
+        {
+            ++nmeaPassedOverCount_;
+
+            return;
+        }
+
+        uint64_t timeStartUs = PAL.Micros();
+
+        NmeaSentenceView view(line);
+        if (view.IsValid())
+        {
+            if (wantMonitor)
+            {
+                router_.Send([&](const auto &out){
+                    out["type"] = "GPS_LINE";
+                    out["line"] = line.c_str();
+                });
+            }
+
+            if (cfgVerifying_)
+            {
+                cfgSignatureBuilder_.OnSentence(view);
+            }
+
+            if (wantGga)
+            {
+                fixAcceptance_.OnGga(view);
+            }
+        }
+        else
+        {
+            ++nmeaInvalidCount_;
+        }
+
+        nmeaCost_.Record(type.empty() ? "?" : type, (uint32_t)(PAL.Micros() - timeStartUs));
+    }
+
+    void ReportNmea()
+    {
+        Log("GPS NMEA Lines");
+        Log("- Lines      : ", Commas(nmeaLineCount_));
+        Log("- Passed over: ", Commas(nmeaPassedOverCount_), " (not wanted)");
+        Log("- Invalid    : ", Commas(nmeaInvalidCount_));
+        Log("- Filter     : ", nmeaFilter_.ToString(), " (monitor mode)");
+        for (uint8_t i = 0; i < nmeaCost_.GetEntryCount(); ++i)
+        {
+            const NmeaSentenceCost::Entry &cost = nmeaCost_.GetEntry(i);
+
+            uint32_t avgUs = cost.count ? (uint32_t)(cost.totalUs / cost.count) : 0;
+
+            Log("- ", cost.type, ": ", Commas(cost.count), " parsed, avg ", Commas(avgUs), " us, max ", Commas(cost.maxUs), " us");
+        }
+    }
+
+
+    /////////////////////////////////////////////////////////////////
+    // Configuration Verification
+    /////////////////////////////////////////////////////////////////
+
+    // The reference signature is only taken right after the full
+    // configuration was sent, when the module is known to have it. Other
+    // times, the signature is checked against it.
+    void StartConfigVerify(bool maxGpsMessages, bool recordReference)
+    {
+        cfgVerifyMaxGpsMessages_ = maxGpsMessages;
+        cfgVerifyRecord_         = recordReference;
+
+        cfgSignatureBuilder_.Reset();
+        cfgVerifying_ = true;
+
+        timerCfgVerify_.TimeoutInMs(CFG_VERIFY_WINDOW_MS);
+    }
+
+    void StopConfigVerify()
+    {
+        timerCfgVerify_.Cancel();
+        cfgVerifying_ = false;
+    }
+
+    void OnConfigVerifyWindowEnd()
+    {
+        StopConfigVerify();
+
+        if (cfgVerifyRecord_)
+        {
+            GpsConfigFingerprint::RecordSignature(cfgSignatureBuilder_.Get());
+        }
+        else if (GpsConfigFingerprint::CheckSignature(cfgSignatureBuilder_.Get()) == false)
+        {
+            // module lost its config somehow, put it back, and take a new
+            // reference once it has it
+            GpsConfigFingerprint::Invalidate();
+
+            bool maxGpsMessages = cfgVerifyMaxGpsMessages_;
+            vector<SeqStep> stepList = GetStepListSendConfig(maxGpsMessages);
+            stepList.push_back({ "RECORD_CONFIG", [=, this]{ StartConfigVerify(maxGpsMessages, true); }, 0 });
+
+            SeqStart("Reconfigure", stepList, nullptr);
+        }
+    }
+
+
+    /////////////////////////////////////////////////////////////////
+    // Fix Timestamping
+    /////////////////////////////////////////////////////////////////
+
+    // The reader stamps a fix with the time its sentence was parsed, which
+    // is after the rest of the burst before it arrived. The module starts
+    // each burst a fixed time after the second it reports, so the start of
+    // the burst is a much steadier reference.
+    template <typename T>
+    void UseBurstTimestamp(T &fix)
+    {
+        uint64_t timeAtBurstStartUs = UartRxBatching::GetTimeAtBurstStartUs(fix.timeAtPpsUs);
+
+        if (timeAtBurstStartUs)
+        {
+            fix.timeAtPpsUs = timeAtBurstStartUs;
+        }
+    }
+
+
+    /////////////////////////////////////////////////////////////////
+    // Fix Acceptance
+    /////////////////////////////////////////////////////////////////
+
+    void StopFixAcceptance()
+    {
+        fixAcceptanceActive_ = false;
+    }
+
+
+    /////////////////////////////////////////////////////////////////
+    // Time To First Fix
+    /////////////////////////////////////////////////////////////////
+
+    void OnFirstFix3DPlusSincePowerOn()
+    {
+        backupPolicy_.OnFirstFix();
+    }
+
+    void ReportStatus()
+    {
+        UartRxIrqStats irqStats = UartRxBatching::GetIrqStats();
+
+        Log("GPS Status");
+        Log("- Module      : ", modulePowered_ ? "on" : "off", moduleCold_ ? " (cold)" : "");
+        Log("- Sequence    : ", IsSequenceInProgress() ? seqName_ : "(none)");
+        Log("- NMEA lines  : ", Commas(nmeaLineCount_));
+        Log("- UART1 IRQs  : ", Commas(irqStats.GetIrqCount()), " (counter ", UartRxBatching::GetIrqCounterMode(), ")");
+        Log("- IRQs/burst  : ", irqStats.GetIrqsPerBurstX10() / 10, ".", irqStats.GetIrqsPerBurstX10() % 10);
+    }
+
+    void ReportTtff()
+    {
+        Log("GPS aiding ", aiding_.GetEnabled() ? "on" : "off", ", sent ", aiding_.GetSendCount(), " times");
+        backupPolicy_.Report();
+    }
+
+
 private:
 
     /////////////////////////////////////////////////////////////////
@@ -468,6 +967,10 @@ private:
             else                    { ModulePowerOffBatteryOn(); }
         }, { .argCount = 1, .help = "gps subsystem <on/off>"});
 
+        Shell::AddCommand("app.ss.gps.status", [this](vector<string> argList){
+            ReportStatus();
+        }, { .argCount = 0, .help = "gps subsystem status, uart interrupt (wake) counts"});
+
         Shell::AddCommand("app.ss.gps.flightmode", [this](vector<string> argList){
             EnableFlightMode();
         }, { .argCount = 0, .help = "gps enable flight mode"});
@@ -476,6 +979,79 @@ private:
             ModuleHardReset();
         }, { .argCount = 0, .help = "gps hard reset module"});
 
+        Shell::AddCommand("app.ss.gps.async", [this](vector<string> argList){
+            auto FnOnDone = []{ Log("GPS async sequence done"); };
+
+            if (argList[0] == "flightmode") { EnableFlightModeAsync(FnOnDone);  }
+            else                            { ModuleHardResetAsync(FnOnDone);   }
+        }, { .argCount = 1, .help = "gps async <flightmode/hardreset>"});
+
+        Shell::AddCommand("app.ss.gps.cfg.fp", [this](vector<string> argList){
+            GpsConfigFingerprint::Report();
+        }, { .argCount = 0, .help = "gps show configuration fingerprint"});
+
+        Shell::AddCommand("app.ss.gps.cfg.fp.clear", [this](vector<string> argList){
+            GpsConfigFingerprint::Invalidate();
+        }, { .argCount = 0, .help = "gps clear configuration fingerprint (config sent on next enable)"});
+
+        Shell::AddCommand("app.ss.gps.aid", [this](vector<string> argList){
+            aiding_.SetEnabled(argList[0] == "on");
+            Log("GPS aiding ", aiding_.GetEnabled() ? "on" : "off");
+        }, { .argCount = 1, .help = "gps aiding on cold start <on/off>"});
+
+        Shell::AddCommand("app.ss.gps.ttff", [this](vector<string> argList){
+            ReportTtff();
+        }, { .argCount = 0, .help = "gps time to first fix and backup policy stats"});
+
+        Shell::AddCommand("app.ss.gps.uart.stats", [this](vector<string> argList){
+            UartRxBatching::Report();
+        }, { .argCount = 0, .help = "gps uart receive batching stats"});
+
+        Shell::AddCommand("app.ss.gps.nmea.stats", [this](vector<string> argList){
+            ReportNmea();
+
+            if (argList.size() && argList[0] == "reset")
+            {
+                nmeaLineCount_       = 0;
+                nmeaPassedOverCount_ = 0;
+                nmeaInvalidCount_    = 0;
+                nmeaCost_.Reset();
+            }
+        }, { .argCount = -1, .help = "gps nmea line stats and cost per sentence type [reset]"});
+
+        Shell::AddCommand("app.ss.gps.nmea.filter", [this](vector<string> argList){
+            if (argList.size())
+            {
+                string err;
+                if (nmeaFilter_.Set(argList[0], err) == false)
+                {
+                    Log("ERR: ", err);
+                }
+            }
+
+            Log("GPS NMEA monitor filter: ", nmeaFilter_.ToString());
+        }, { .argCount = -1, .help = "gps nmea sentences forwarded in monitor mode [<all/GGA,GNRMC,...>]"});
+
+        Shell::AddCommand("app.ss.gps.fix.accept", [this](vector<string> argList){
+            if (argList.size() == 3)
+            {
+                auto &cfg = fixAcceptance_.GetConfig();
+
+                string err;
+                if (fixAcceptance_.SetConfig(atoi(argList[0].c_str()),
+                                             atof(argList[1].c_str()),
+                                             (int32_t)cfg.maxJumpM,
+                                             (int32_t)cfg.maxAltJumpM,
+                                             atoi(argList[2].c_str()),
+                                             err) == false)
+                {
+                    Log("ERR: ", err);
+                }
+            }
+
+            fixAcceptance_.Report();
+        }, { .argCount = -1, .help = "gps fix acceptance [<minSats> <maxHdop> <maxFixes>]"});
+
         Shell::AddCommand("app.ss.gps.mode.monitor", [this](vector<string> argList){
             EnterMonitorMode();
         }, { .argCount = 0, .help = "gps subsystem enter monitor mode"});
@@ -496,7 +1072,7 @@ private:
 
         Shell::AddCommand("app.ss.gps.bat", [this](vector<string> argList){
             if (argList[0] == "on") { pinGpsBatteryPowerOnOff_.DigitalWrite(1);  }
-            else                    { pinGpsBatteryPowerOnOff_.DigitalWrite(0); }
+            else                    { pinGpsBatteryPowerOnOff_.DigitalWrite(0); GpsConfigFingerprint::Invalidate(); moduleCold_ = true; backupPolicy_.OnBackupLost(); }
         }, { .argCount = 1, .help = "gps battery <on/off>"});
     }
 
@@ -519,6 +1095,35 @@ private:
             StartMonitorLockSequenceWeb();
         });
 
+        JSONMsgRouter::RegisterHandler("REQ_GET_GPS_FIX_ACCEPT", [this](auto &in, auto &out){
+            out["type"] = "REP_GET_GPS_FIX_ACCEPT";
+
+            const auto &cfg = fixAcceptance_.GetConfig();
+            out["minSats"]        = cfg.minSats;
+            out["maxHdop"]        = cfg.maxHdopX100 / 100.0;
+            out["maxJumpM"]       = cfg.maxJumpM;
+            out["maxAltJumpM"]    = cfg.maxAltJumpM;
+            out["maxFixesToWait"] = cfg.maxFixesToWait;
+        });
+
+        JSONMsgRouter::RegisterHandler("REQ_SET_GPS_FIX_ACCEPT", [this](auto &in, auto &out){
+            out["type"] = "REP_SET_GPS_FIX_ACCEPT";
+
+            string err;
+            bool ok = fixAcceptance_.SetConfig((int32_t)in["minSats"],
+                                               (double)in["maxHdop"],
+                                               (int32_t)in["maxJumpM"],
+                                               (int32_t)in["maxAltJumpM"],
+                                               (int32_t)in["maxFixesToWait"],
+                                               err);
+
+            Log("REQ_SET_GPS_FIX_ACCEPT");
+            Log("OK: ", ok, ", err: \"", err, "\"");
+
+            out["ok"]  = ok;
+            out["err"] = err;
+        });
+
         JSONMsgRouter::RegisterHandler("REQ_GPS_POWER_ON", [this](auto &in, auto &out){
             ModulePowerOnBatteryOn();
             StartMonitorLockSequenceWeb();
@@ -538,6 +1143,19 @@ private:
 
 private:
 
+    // module boot time before talking to it
+    inline static const uint32_t MODULE_POWER_ON_SETTLE_MS = 500;
+
+    // how long to hold the module fully unpowered during a hard reset
+    inline static const uint32_t MODULE_HARD_RESET_OFF_MS = 1'000;
+
+    // longest config command is ~60 bytes, ~63ms at 9600 baud
+    inline static const uint32_t CMD_GAP_MS = 75;
+
+    // long enough to see every sentence type of a 1 second reporting cycle
+    // at least twice
+    inline static const uint32_t CFG_VERIFY_WINDOW_MS = 2'500;
+
     Pin pinGpsLoadSwitchOnOff_    { 2, Pin::Type::OUTPUT, 1 };
     Pin pinGpsReset_              { 6, Pin::Type::OUTPUT, 0 };
     Pin pinGpsBatteryPowerOnOff_  { 3, Pin::Type::OUTPUT, 1 };
@@ -545,6 +1163,40 @@ private:
 
     JSONMsgRouter::Iface router_;
 
+    // NMEA lines go to whichever of these is active. In flight, that is
+    // only fix acceptance while a fix is requested.
+    uint32_t           nmeaLineCount_       = 0;
+    uint32_t           nmeaPassedOverCount_ = 0;
+    uint32_t           nmeaInvalidCount_    = 0;
+    NmeaSentenceCost   nmeaCost_;
+    NmeaSentenceFilter nmeaFilter_;
+    bool               nmeaEcho_            = false;
+    bool               monitorForwarding_   = false;
+
     GPSReader gpsReader_;
     GPSWriter gpsWriter_;
+
+    Timer timerSeq_ = { "TIMER_GPS_POWER_SEQ" };
+    const char       *seqName_        = "";
+    vector<SeqStep>   seqStepList_;
+    size_t            seqIdx_         = 0;
+    function<void()>  fnCbSeqDone_;
+    uint64_t          timeAtSeqStart_ = 0;
+
+    Timer timerCfgVerify_ = { "TIMER_GPS_CFG_VERIFY" };
+    bool                                   cfgVerifying_            = false;
+    bool                                   cfgVerifyMaxGpsMessages_ = false;
+    bool                                   cfgVerifyRecord_         = false;
+    GpsConfigFingerprint::SignatureBuilder cfgSignatureBuilder_;
+
+    // the module state at boot is unknown, so assume the worst
+    GpsAiding aiding_;
+    bool      moduleCold_    = true;
+    bool      aidPending_    = false;
+    bool      modulePowered_ = false;
+
+    GpsBackupPolicy backupPolicy_;
+
+    GpsFixAcceptancePolicy fixAcceptance_;
+    bool                   fixAcceptanceActive_ = false;
 };
\ No newline at end of file
@@ -1,11 +1,17 @@
 #pragma once
 
+#include "ADCInternal.h"
 #include "App.h"
 #include "JSONMsgRouter.h"
 #include "WsprEncodedDynamic.h"
 #include "WSPRMessageTransmitter.h"
 
 #include "Configuration.h"
+#include "PowerPeripheralGating.h"
+#include "TxBrownoutGuard.h"
+#include "TxWarmupTable.h"
+
+#include <cmath>
 
 
 // Do we want a warmup period before sending?
@@ -53,6 +59,7 @@ public:
     void Enable()
     {
         Log("TX Subsystem On");
+        PowerPeripheralGating::SetInUse(PowerPeripheralGating::Use::RADIO, true);
         pinTxLoadSwitchOnOff_.DigitalWrite(0);
 
         // Give it time to start up
@@ -65,6 +72,13 @@ public:
     {
         Log("Radio on");
         wsprMessageTransmitter_.RadioOn();
+        warmupTable_.OnRadioOn();
+
+        // any drive reduction lasts only as long as the radio is on
+        if (driveStep_ != TxBrownoutGuard::DRIVE_STEP_MAX)
+        {
+            SetDriveStep(TxBrownoutGuard::DRIVE_STEP_MAX);
+        }
 
         on_ = true;
     }
@@ -74,6 +88,11 @@ public:
         return on_;
     }
 
+    TxWarmupTable &GetWarmupTable()
+    {
+        return warmupTable_;
+    }
+
     void SetupTransmitterForCalibration()
     {
         // unlike normal flight mode, this:
@@ -106,19 +125,81 @@ public:
         wsprMessageTransmitter_.SetCorrection(cfg_.correction);
     }
 
+    // Decide whether CLK1 is used for the coming window, according to the
+    // configured mode. In auto mode both VCC and the sun must be high
+    // enough. The sun is only considered when the position is known.
+    //
+    // Takes effect on the next RadioOn().
+    void ConfigureClk1ForWindow(uint16_t mv, bool posValid, double latDeg, double lngDeg, uint64_t timeUnixUs)
+    {
+        cfg_.GetClk1();
+
+        bool clk1Enabled = true;
+        if (cfg_.clk1Mode == "single")
+        {
+            clk1Enabled = false;
+        }
+        else if (cfg_.clk1Mode == "auto")
+        {
+            bool mvOk  = mv >= cfg_.clk1AutoMinMv;
+            bool sunOk = true;
+
+            LogNNL("CLK1 auto: ", mv, " mV (need ", cfg_.clk1AutoMinMv, ")");
+            if (posValid)
+            {
+                double sunDeg = GetSunElevationDeg(latDeg, lngDeg, timeUnixUs);
+                sunOk = sunDeg >= cfg_.clk1AutoMinSunDeg;
+
+                LogNNL(", sun ", (int32_t)round(sunDeg), " deg (need ", cfg_.clk1AutoMinSunDeg, ")");
+            }
+            LogNL();
+
+            clk1Enabled = mvOk && sunOk;
+        }
+
+        SetClk1Enabled(clk1Enabled);
+    }
+
+    void SetClk1Enabled(bool tf)
+    {
+        Log("CLK1 ", tf ? "on (dual)" : "off (single)");
+
+        wsprMessageTransmitter_.SetClk1Enabled(tf);
+    }
+
+    bool GetClk1Enabled()
+    {
+        return wsprMessageTransmitter_.GetClk1Enabled();
+    }
+
     void SetCallbackOnTxStart(function<void()> fn)
     {
-        wsprMessageTransmitter_.SetCallbackOnTxStart(fn);
+        wsprMessageTransmitter_.SetCallbackOnTxStart([this, fn]{
+            brownoutGuard_.Start(GetClk1Enabled(), driveStep_);
+
+            fn();
+        });
     }
 
     void SetCallbackOnBitChange(function<void()> fn)
     {
-        wsprMessageTransmitter_.SetCallbackOnBitChange(fn);
+        wsprMessageTransmitter_.SetCallbackOnBitChange([this, fn]{
+            OnBitChangeCheckBrownout();
+
+            fn();
+        });
     }
 
     void SetCallbackOnTxEnd(function<void()> fn)
     {
-        wsprMessageTransmitter_.SetCallbackOnTxEnd(fn);
+        wsprMessageTransmitter_.SetCallbackOnTxEnd([this, fn]{
+            if (brownoutGuard_.GetActionCount())
+            {
+                Log("Brownout guard: ", brownoutGuard_.GetActionCount(), " steps, VCC min ", brownoutGuard_.GetMvMin(), " mV");
+            }
+
+            fn();
+        });
     }
 
     void SetTxQuitAfterMs(uint64_t ms)
@@ -197,6 +278,7 @@ public:
         Log("Radio off");
         LogNL();
         wsprMessageTransmitter_.RadioOff();
+        warmupTable_.OnRadioOff(PAL.Micros());
 
         on_ = false;
     }
@@ -206,6 +288,7 @@ public:
         Log("TX Subsystem Off");
         LogNL();
         pinTxLoadSwitchOnOff_.DigitalWrite(1);
+        PowerPeripheralGating::SetInUse(PowerPeripheralGating::Use::RADIO, false);
 
         enabled_ = false;
     }
@@ -213,6 +296,86 @@ public:
 
 private:
 
+    /////////////////////////////////////////////////////////////////
+    // Brownout Guard
+    /////////////////////////////////////////////////////////////////
+
+    // VCC is sampled each symbol, and output power backed off in steps if
+    // it heads for the brownout point. Steps taken hold until the radio is
+    // next turned on (drive) or the next window (CLK1).
+    void OnBitChangeCheckBrownout()
+    {
+        uint16_t mv = 0;
+        PowerPeripheralGating::WhileInUse(PowerPeripheralGating::Use::SAMPLING, [&]{
+            mv = (uint16_t)ADC::GetMilliVoltsVCC();
+        });
+
+        TxBrownoutGuard::Action action = brownoutGuard_.OnSample(mv);
+
+        if (action == TxBrownoutGuard::Action::DROP_CLK1)
+        {
+            Log("Brownout guard: VCC ", mv, " mV, projected ", brownoutGuard_.GetProjMv(), " mV, dropping CLK1");
+
+            // re-applying the drive shuts CLK1 off now, not on the next RadioOn()
+            wsprMessageTransmitter_.SetClk1Enabled(false);
+            SetDriveStep(driveStep_);
+        }
+        else if (action == TxBrownoutGuard::Action::DROP_DRIVE)
+        {
+            uint8_t driveStep = brownoutGuard_.GetDriveStep();
+
+            Log("Brownout guard: VCC ", mv, " mV, projected ", brownoutGuard_.GetProjMv(), " mV, drive ", TxBrownoutGuard::GetDriveMa(driveStep), " mA");
+
+            SetDriveStep(driveStep);
+        }
+    }
+
+    void SetDriveStep(uint8_t driveStep)
+    {
+        static const si5351_drive DRIVE_LIST[] = {
+            SI5351_DRIVE_2MA,
+            SI5351_DRIVE_4MA,
+            SI5351_DRIVE_6MA,
+            SI5351_DRIVE_8MA,
+        };
+
+        driveStep_ = driveStep;
+
+        wsprMessageTransmitter_.SetDrive(DRIVE_LIST[driveStep_]);
+    }
+
+
+private:
+
+    // Low precision solar position (~1 degree), plenty to tell midday
+    // from a low sun.
+    static double GetSunElevationDeg(double latDeg, double lngDeg, uint64_t timeUnixUs)
+    {
+        const double RAD = M_PI / 180;
+
+        // days since J2000.0 (2000-01-01 12:00 UTC)
+        double d = (double)timeUnixUs / 1'000'000 / 86'400 - 10'957.5;
+
+        // ecliptic longitude of the sun, and obliquity
+        double g = (357.529 + 0.98560028 * d) * RAD;
+        double q =  280.459 + 0.98564736 * d;
+        double l = (q + 1.915 * sin(g) + 0.020 * sin(2 * g)) * RAD;
+        double e = (23.439 - 0.00000036 * d) * RAD;
+
+        // equatorial coordinates
+        double ra  = atan2(cos(e) * sin(l), cos(l));
+        double dec = asin(sin(e) * sin(l));
+
+        // local hour angle from sidereal time
+        double gmstDeg = fmod(280.46061837 + 360.98564736629 * d, 360);
+        double ha      = gmstDeg * RAD + lngDeg * RAD - ra;
+
+        double lat = latDeg * RAD;
+        double sinElev = sin(lat) * sin(dec) + cos(lat) * cos(dec) * cos(ha);
+
+        return asin(sinElev) / RAD;
+    }
+
 
     void TestWsprSend(string callsign, string grid, uint8_t powerDbm = 17)
     {
@@ -271,6 +434,28 @@ private:
             else                    {            RadioOff(); }
         }, { .argCount = 1, .help = "clockgen run <on/off>"});
 
+        Shell::AddCommand("app.tx.clk1", [this](vector<string> argList){
+            SetClk1Enabled(argList[0] == "on");
+        }, { .argCount = 1, .help = "use clk1 on next radio on <on/off> (until next window)"});
+
+        Shell::AddCommand("app.tx.brownout", [this](vector<string> argList){
+            TxBrownoutGuard::Config &cfg = brownoutGuard_.GetConfig();
+
+            if (argList.size() == 2)
+            {
+                cfg.brownoutMv = (uint16_t)atoi(argList[0].c_str());
+                cfg.marginMv   = (uint16_t)atoi(argList[1].c_str());
+            }
+
+            Log("Brownout guard");
+            Log("- brownout : ", cfg.brownoutMv, " mV");
+            Log("- margin   : ", cfg.marginMv, " mV");
+            Log("- horizon  : ", cfg.horizonSymbols, " symbols");
+            Log("- holdoff  : ", cfg.holdoffSymbols, " symbols");
+            Log("- last tx  : ", brownoutGuard_.GetActionCount(), " steps, VCC min ", brownoutGuard_.GetMvMin(), " mV");
+            Log("- drive    : ", TxBrownoutGuard::GetDriveMa(driveStep_), " mA, CLK1 ", GetClk1Enabled() ? "on" : "off");
+        }, { .argCount = -1, .help = "report brownout guard, or set [<brownoutMv> <marginMv>] (until reboot)"});
+
         Shell::AddCommand("app.wspr.quitms", [this](vector<string> argList){
             uint64_t quitMs = (uint64_t)atoi(argList[0].c_str());
 
@@ -386,4 +571,8 @@ private:
     bool on_ = false;
 
     WSPRMessageTransmitter wsprMessageTransmitter_;
+
+    TxWarmupTable   warmupTable_;
+    TxBrownoutGuard brownoutGuard_;
+    uint8_t         driveStep_ = TxBrownoutGuard::DRIVE_STEP_MAX;
 };
\ No newline at end of file
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+using namespace std;
+
+
+// Watches VCC through a transmission and backs off output power in steps
+// when it sags towards the brownout point, rather than letting the board
+// reset mid-message.
+//
+// VCC is sampled once per WSPR symbol (~683ms, ~162 per message). The
+// level and trend are smoothed, and the level projected a number of
+// symbols ahead. When the projection comes within the margin of the
+// brownout point, the next step is taken:
+// - drop CLK1 (single clock output)
+// - drop drive strength, 8mA -> 6mA -> 4mA -> 2mA
+//
+// After a step, some symbols are let pass before another is considered,
+// so the supply has time to respond.
+//
+// The decisions are kept free of hardware so they can be run against
+// synthetic voltage traces (see test/TxBrownoutGuardTest.cpp).
+class TxBrownoutGuard
+{
+public:
+
+    enum class Action : uint8_t
+    {
+        NONE,
+        DROP_CLK1,
+        DROP_DRIVE,
+    };
+
+    static const char *GetActionName(Action action)
+    {
+        const char *retVal = "";
+
+        switch (action)
+        {
+        case Action::NONE:       retVal = "none";       break;
+        case Action::DROP_CLK1:  retVal = "drop clk1";  break;
+        case Action::DROP_DRIVE: retVal = "drop drive"; break;
+        }
+
+        return retVal;
+    }
+
+    struct Config
+    {
+        uint16_t brownoutMv     = 2'700;
+        uint16_t marginMv       = 150;
+        uint8_t  horizonSymbols = 8;
+        uint8_t  holdoffSymbols = 6;
+    };
+
+    // Si5351 drive strength steps, 0=2mA .. 3=8mA
+    inline static const uint8_t DRIVE_STEP_MIN = 0;
+    inline static const uint8_t DRIVE_STEP_MAX = 3;
+
+
+public:
+
+    Config &GetConfig()
+    {
+        return cfg_;
+    }
+
+    void Start(bool clk1Enabled, uint8_t driveStep)
+    {
+        clk1Enabled_ = clk1Enabled;
+        driveStep_   = driveStep;
+
+        sampleCount_   = 0;
+        avgMvX16_      = 0;
+        slopeMvX16_    = 0;
+        mvPrev_        = 0;
+        holdoffRemain_ = 0;
+        mvMin_         = 0;
+        actionCount_   = 0;
+    }
+
+    // returns the step to take now, if any
+    Action OnSample(uint16_t mv)
+    {
+        Action retVal = Action::NONE;
+
+        if (mv == 0) { return retVal; }
+
+        ++sampleCount_;
+        mvMin_ = mvMin_ ? min(mvMin_, mv) : mv;
+
+        // exponential averages, 1/4 weight, fixed point x16
+        int32_t mvX16 = (int32_t)mv * 16;
+        if (sampleCount_ == 1)
+        {
+            avgMvX16_ = mvX16;
+        }
+        else
+        {
+            slopeMvX16_ += ((int32_t)(mv - mvPrev_) * 16 - slopeMvX16_) / 4;
+            avgMvX16_   += (mvX16 - avgMvX16_) / 4;
+        }
+        mvPrev_ = mv;
+
+        // a rising trend doesn't offset a low level
+        int32_t slopeDownX16 = min(slopeMvX16_, (int32_t)0);
+        int32_t projMv       = (avgMvX16_ + slopeDownX16 * cfg_.horizonSymbols) / 16;
+
+        projMvLast_ = projMv;
+
+        if (holdoffRemain_)
+        {
+            --holdoffRemain_;
+        }
+        else if (projMv < (int32_t)cfg_.brownoutMv + cfg_.marginMv)
+        {
+            if (clk1Enabled_)
+            {
+                clk1Enabled_ = false;
+                retVal = Action::DROP_CLK1;
+            }
+            else if (driveStep_ > DRIVE_STEP_MIN)
+            {
+                --driveStep_;
+                retVal = Action::DROP_DRIVE;
+            }
+
+            if (retVal != Action::NONE)
+            {
+                holdoffRemain_ = cfg_.holdoffSymbols;
+                ++actionCount_;
+            }
+        }
+
+        return retVal;
+    }
+
+    bool     GetClk1Enabled()  { return clk1Enabled_; }
+    uint8_t  GetDriveStep()    { return driveStep_;   }
+    int32_t  GetProjMv()       { return projMvLast_;  }
+    uint16_t GetMvMin()        { return mvMin_;       }
+    uint32_t GetActionCount()  { return actionCount_; }
+
+    static uint8_t GetDriveMa(uint8_t driveStep)
+    {
+        return (driveStep + 1) * 2;
+    }
+
+
+private:
+
+    Config cfg_;
+
+    bool    clk1Enabled_ = true;
+    uint8_t driveStep_   = DRIVE_STEP_MAX;
+
+    uint32_t sampleCount_   = 0;
+    int32_t  avgMvX16_      = 0;
+    int32_t  slopeMvX16_    = 0;
+    uint16_t mvPrev_        = 0;
+    int32_t  projMvLast_    = 0;
+    uint8_t  holdoffRemain_ = 0;
+    uint16_t mvMin_         = 0;
+    uint32_t actionCount_   = 0;
+};
\ No newline at end of file
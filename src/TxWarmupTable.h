@@ -0,0 +1,355 @@
+#pragma once
+
+#include "App.h"
+#include "FilesystemLittleFS.h"
+#include "JSONMsgRouter.h"
+#include "Log.h"
+#include "Shell.h"
+#include "Utl.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+// A configurable table of how long the radio runs before a window to let
+// the oscillator settle, rather than always the worst case.
+//
+// The duration comes from a temperature table, interpolated between
+// points and clamped beyond the ends. A cold board takes longer to settle
+// than a warm one.
+//
+// The radio's own history counts too. If it was on recently, it still
+// holds some of its heat, and the duration scales down with the time since
+// it was turned off, reaching the full table duration after the cooldown.
+// That time is taken up to when the warmup will start, not when it is
+// planned, which can be minutes before. The floor applies in all cases.
+//
+// Nothing is learned. This board has no path to measure the clock output
+// against a reference, so settling isn't observed, and the table is only
+// as good as what it is set to.
+//
+// Configuration is kept in a file, separate from the main configuration.
+class TxWarmupTable
+{
+public:
+
+    struct Point
+    {
+        int16_t  tempC;
+        uint16_t durationSec;
+    };
+
+    struct Config
+    {
+        // ascending by temperature.
+        // flat at the fixed 30 sec this replaced, until measured
+        vector<Point> pointList = {
+            { 0, 30 },
+        };
+
+        uint16_t cooldownSec = 300;
+        uint16_t floorSec    = 5;
+    };
+
+
+public:
+
+    TxWarmupTable()
+    {
+        SetupShell();
+        SetupJSON();
+    }
+
+    Config &GetConfig()
+    {
+        Load();
+
+        return cfg_;
+    }
+
+    void SetConfig(const Config &cfg)
+    {
+        Load();
+
+        cfg_ = cfg;
+        sort(cfg_.pointList.begin(), cfg_.pointList.end(), [](const Point &a, const Point &b){
+            return a.tempC < b.tempC;
+        });
+
+        Save();
+    }
+
+    void OnRadioOn()
+    {
+        radioOn_ = true;
+    }
+
+    void OnRadioOff(uint64_t timeNowUs)
+    {
+        if (radioOn_)
+        {
+            radioOn_          = false;
+            timeAtRadioOffUs_ = timeNowUs;
+        }
+    }
+
+    // timeAtWarmupStartUs is when the warmup will start, at or after now
+    uint64_t GetWarmupDurationUs(int16_t tempC, uint64_t timeNowUs, uint64_t timeAtWarmupStartUs)
+    {
+        Load();
+
+        uint64_t durationTableUs = GetTableDurationSec(tempC) * 1'000'000ULL;
+        uint64_t durationUs      = durationTableUs;
+
+        // residual heat from recent use, left by the time the warmup starts.
+        // a radio on now is taken as turning off now.
+        uint64_t cooldownUs       = cfg_.cooldownSec * 1'000'000ULL;
+        uint64_t timeAtRadioOffUs = radioOn_ ? timeNowUs : timeAtRadioOffUs_;
+        if (timeAtRadioOffUs)
+        {
+            uint64_t durationOffUs = timeAtWarmupStartUs > timeAtRadioOffUs ? timeAtWarmupStartUs - timeAtRadioOffUs : 0;
+
+            if (durationOffUs < cooldownUs)
+            {
+                durationUs = durationTableUs * durationOffUs / cooldownUs;
+            }
+        }
+
+        durationUs = max(durationUs, cfg_.floorSec * 1'000'000ULL);
+
+        tempCLast_      = tempC;
+        durationUsLast_ = durationUs;
+        ++calcCount_;
+
+        return durationUs;
+    }
+
+    void Report()
+    {
+        Load();
+
+        Log("TX Warmup Table");
+        LogNNL("- table      :");
+        for (const auto &point : cfg_.pointList)
+        {
+            LogNNL(" ", point.tempC, "C=", point.durationSec, "s");
+        }
+        LogNL();
+        Log("- cooldown   : ", cfg_.cooldownSec, " sec");
+        Log("- floor      : ", cfg_.floorSec, " sec");
+        Log("- radio      : ", radioOn_ ? "on" : "off");
+        Log("- last       : ", tempCLast_, "C, ", Time::MakeDurationFromUs(durationUsLast_));
+        Log("- calculated : ", Commas(calcCount_));
+    }
+
+
+private:
+
+    uint16_t GetTableDurationSec(int16_t tempC)
+    {
+        uint16_t retVal = cfg_.floorSec;
+
+        const vector<Point> &pl = cfg_.pointList;
+
+        if (pl.empty() == false)
+        {
+            if (tempC <= pl.front().tempC)
+            {
+                retVal = pl.front().durationSec;
+            }
+            else if (tempC >= pl.back().tempC)
+            {
+                retVal = pl.back().durationSec;
+            }
+            else
+            {
+                for (size_t i = 1; i < pl.size(); ++i)
+                {
+                    if (tempC <= pl[i].tempC)
+                    {
+                        const Point &a = pl[i - 1];
+                        const Point &b = pl[i];
+
+                        int32_t num = ((int32_t)b.durationSec - a.durationSec) * (tempC - a.tempC);
+                        int32_t den = b.tempC - a.tempC;
+
+                        retVal = (uint16_t)(a.durationSec + (den ? num / den : 0));
+
+                        break;
+                    }
+                }
+            }
+        }
+
+        return retVal;
+    }
+
+    // "tempC:sec tempC:sec ..."
+    static bool ParsePointList(const string &str, vector<Point> &pointList)
+    {
+        bool retVal = true;
+
+        pointList.clear();
+        for (const auto &part : Split(str, " "))
+        {
+            vector<string> tv = Split(part, ":");
+            if (tv.size() == 2)
+            {
+                pointList.push_back({
+                    .tempC       = (int16_t)atoi(tv[0].c_str()),
+                    .durationSec = (uint16_t)atoi(tv[1].c_str()),
+                });
+            }
+            else
+            {
+                retVal = false;
+            }
+        }
+
+        return retVal && pointList.empty() == false;
+    }
+
+    static string MakePointListStr(const vector<Point> &pointList)
+    {
+        string retVal;
+
+        string sep;
+        for (const auto &point : pointList)
+        {
+            retVal += sep + to_string(point.tempC) + ":" + to_string(point.durationSec);
+            sep = " ";
+        }
+
+        return retVal;
+    }
+
+    // cooldownSec,floorSec,pointList
+    void Load()
+    {
+        if (loaded_) { return; }
+        loaded_ = true;
+
+        vector<string> partList = Split(FilesystemLittleFS::Read(FILE_NAME), ",");
+        if (partList.size() == 3)
+        {
+            Config cfg;
+            cfg.cooldownSec = (uint16_t)atoi(partList[0].c_str());
+            cfg.floorSec    = (uint16_t)atoi(partList[1].c_str());
+
+            if (ParsePointList(partList[2], cfg.pointList))
+            {
+                cfg_ = cfg;
+            }
+        }
+    }
+
+    void Save()
+    {
+        FilesystemLittleFS::Write(FILE_NAME,
+                                  to_string(cfg_.cooldownSec) + "," +
+                                  to_string(cfg_.floorSec)    + "," +
+                                  MakePointListStr(cfg_.pointList));
+    }
+
+
+private:
+
+    void SetupShell()
+    {
+        Shell::AddCommand("app.tx.warmup", [this](vector<string> argList){
+            Report();
+        }, { .argCount = 0, .help = "report tx warmup table"});
+
+        Shell::AddCommand("app.tx.warmup.set", [this](vector<string> argList){
+            if (argList.size() < 3)
+            {
+                Log("ERR: expected <cooldownSec> <floorSec> <tempC:sec> ...");
+                return;
+            }
+
+            Config cfg;
+            cfg.cooldownSec = (uint16_t)atoi(argList[0].c_str());
+            cfg.floorSec    = (uint16_t)atoi(argList[1].c_str());
+
+            string pointListStr;
+            string sep;
+            for (size_t i = 2; i < argList.size(); ++i)
+            {
+                pointListStr += sep + argList[i];
+                sep = " ";
+            }
+
+            if (ParsePointList(pointListStr, cfg.pointList))
+            {
+                SetConfig(cfg);
+            }
+            else
+            {
+                Log("ERR: could not parse table, expected tempC:sec ...");
+            }
+
+            Report();
+        }, { .argCount = -1, .help = "set tx warmup <cooldownSec> <floorSec> <tempC:sec> [<tempC:sec> ...]"});
+
+        Shell::AddCommand("app.tx.warmup.calc", [this](vector<string> argList){
+            if (argList.empty())
+            {
+                Log("ERR: expected <tempC> [<sec>]");
+                return;
+            }
+
+            uint64_t timeNowUs = PAL.Micros();
+            uint64_t inSec     = argList.size() >= 2 ? (uint64_t)atoi(argList[1].c_str()) : 0;
+
+            uint64_t durationUs = GetWarmupDurationUs((int16_t)atoi(argList[0].c_str()), timeNowUs, timeNowUs + inSec * 1'000'000);
+
+            Log("Warmup: ", Time::MakeDurationFromUs(durationUs));
+        }, { .argCount = -1, .help = "calculate tx warmup for <tempC> [starting in <sec>]"});
+    }
+
+    void SetupJSON()
+    {
+        JSONMsgRouter::RegisterHandler("REQ_GET_TX_WARMUP", [this](auto &in, auto &out){
+            out["type"] = "REP_GET_TX_WARMUP";
+
+            const Config &cfg = GetConfig();
+            out["cooldownSec"] = cfg.cooldownSec;
+            out["floorSec"]    = cfg.floorSec;
+            out["table"]       = MakePointListStr(cfg.pointList);
+
+            out["tempCLast"]      = tempCLast_;
+            out["durationMsLast"] = durationUsLast_ / 1'000;
+            out["calcCount"]      = calcCount_;
+        });
+
+        JSONMsgRouter::RegisterHandler("REQ_SET_TX_WARMUP", [this](auto &in, auto &out){
+            Log("REQ_SET_TX_WARMUP");
+
+            Config cfg;
+            cfg.cooldownSec = (uint16_t)in["cooldownSec"];
+            cfg.floorSec    = (uint16_t)in["floorSec"];
+
+            if (ParsePointList((const char *)in["table"], cfg.pointList))
+            {
+                SetConfig(cfg);
+            }
+        });
+    }
+
+
+private:
+
+    inline static const char *FILE_NAME = "tx.warmup";
+
+    bool   loaded_ = false;
+    Config cfg_;
+
+    bool     radioOn_          = false;
+    uint64_t timeAtRadioOffUs_ = 0;
+
+    int16_t  tempCLast_      = 0;
+    uint64_t durationUsLast_ = 0;
+    uint32_t calcCount_      = 0;
+};
\ No newline at end of file
@@ -0,0 +1,218 @@
+#pragma once
+
+#include "App.h"
+#include "UartRxBurst.h"
+
+#include "hardware/clocks.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "hardware/uart.h"
+
+#include <string>
+using namespace std;
+
+
+// NMEA arrives from the GPS as a burst of a few hundred bytes once per
+// second, and is otherwise silent.
+//
+// Left at a low receive FIFO level, the UART interrupts (and wakes the core)
+// every few bytes of every burst. Instead, receive is batched in hardware:
+// - the FIFO is enabled, 32 bytes deep
+// - the receive interrupt fires only once the FIFO is 7/8 full
+// - the receive timeout interrupt fires after 32 bit-times of idle line,
+//   which collects whatever is left at the end of a burst
+//
+// The UART driver's interrupt handler drains the FIFO as before, just a
+// FIFO's worth at a time.
+//
+// Interrupts are counted ahead of the driver's handler, so the effect can
+// be seen on a device. A driver which installed its handler as shared gets
+// another shared handler alongside, run first. One which installed it as
+// exclusive has it wrapped.
+//
+// The interrupt is also where the start of each burst is noted, which fix
+// times are taken from. Lines coming back through the driver's line stream
+// note it too, for when the interrupt can't (see UartRxBurst).
+class UartRxBatching
+{
+public:
+
+    // call after the UART is (re-)enabled, which resets its configuration
+    static void Apply()
+    {
+        uart_inst_t *uart = uart1;
+        uart_hw_t   *hw   = uart_get_hw(uart);
+
+        uint32_t irqState = save_and_disable_interrupts();
+
+        uart_set_fifo_enabled(uart, true);
+
+        hw_write_masked(&hw->ifls,
+                        RX_FIFO_LEVEL_7_8 << UART_UARTIFLS_RXIFLSEL_LSB,
+                        UART_UARTIFLS_RXIFLSEL_BITS);
+        hw_set_bits(&hw->imsc, UART_UARTIMSC_RXIM_BITS | UART_UARTIMSC_RTIM_BITS);
+
+        InstallIrqCounter();
+
+        restore_interrupts(irqState);
+
+        // baud = clk_peri / (16 * (ibrd + fbrd / 64)), 10 bits per byte
+        uint32_t divX64 = hw->ibrd * 64 + hw->fbrd;
+        if (divX64)
+        {
+            uint32_t baud = (uint32_t)((uint64_t)clock_get_hz(clk_peri) * 4 / divX64);
+
+            uint32_t byteDurationUs = baud ? 10'000'000 / baud : 0;
+
+            burst_.SetByteDurationUs(byteDurationUs);
+
+            irqState = save_and_disable_interrupts();
+            irqStats_.SetByteDurationUs(byteDurationUs);
+            restore_interrupts(irqState);
+        }
+
+        applied_ = true;
+    }
+
+    // call with each line from the UART1 line stream
+    static void OnLine(const string &line)
+    {
+        burst_.OnLine(PAL.Micros(), (uint32_t)line.size());
+    }
+
+    // System time the first byte arrived of the burst holding the line
+    // completed at timeAtLineUs, 0 if not known.
+    //
+    // Taken from the interrupt where it can be, which is known before any
+    // line of the burst is handed out. Otherwise from the line stream.
+    static uint64_t GetTimeAtBurstStartUs(uint64_t timeAtLineUs)
+    {
+        uint64_t retVal = GetIrqStats().GetTimeAtBurstStartUs(timeAtLineUs);
+
+        if (retVal)
+        {
+            ++burstStartFromIrqCount_;
+        }
+        else
+        {
+            retVal = burst_.GetTimeAtBurstStartUs(timeAtLineUs);
+
+            if (retVal)
+            {
+                ++burstStartFromLineCount_;
+            }
+        }
+
+        return retVal;
+    }
+
+    // copied out with interrupts off, the handler updates it
+    static UartRxIrqStats GetIrqStats()
+    {
+        uint32_t irqState = save_and_disable_interrupts();
+        UartRxIrqStats retVal = irqStats_;
+        restore_interrupts(irqState);
+
+        return retVal;
+    }
+
+    static const char *GetIrqCounterMode()
+    {
+        const char *retVal = "not installed";
+
+        if      (irqCounterMode_ == IrqCounterMode::SHARED)  { retVal = "shared";  }
+        else if (irqCounterMode_ == IrqCounterMode::WRAPPED) { retVal = "wrapped"; }
+
+        return retVal;
+    }
+
+    static void Report()
+    {
+        UartRxIrqStats irqStats = GetIrqStats();
+
+        Log("UART1 RX Batching (", applied_ ? "applied" : "not applied", ")");
+        Log("- IRQs (wakes): ", Commas(irqStats.GetIrqCount()), " (counter ", GetIrqCounterMode(), ")");
+        Log("- IRQ bursts  : ", Commas(irqStats.GetBurstCount()));
+        Log("- IRQs/burst  : ", irqStats.GetIrqsPerBurstX10() / 10, ".", irqStats.GetIrqsPerBurstX10() % 10);
+        Log("- Bursts      : ", Commas(burst_.GetBurstCount()));
+        Log("- Lines       : ", Commas(burst_.GetLineCount()));
+        Log("- Byte time   : ", burst_.GetByteDurationUs(), " us");
+        if (burst_.GetBurstCount())
+        {
+            Log("- Lines/burst : ", burst_.GetLineCount() / burst_.GetBurstCount());
+        }
+        Log("- Fix times   : ", Commas(burstStartFromIrqCount_), " from IRQ, ", Commas(burstStartFromLineCount_), " from line");
+    }
+
+
+private:
+
+    // Called with interrupts off. The driver may re-install its handler
+    // when the UART is enabled, so this is checked every time.
+    static void InstallIrqCounter()
+    {
+        if (irqCounterMode_ == IrqCounterMode::SHARED) { return; }
+
+        if (irq_has_shared_handler(UART1_IRQ))
+        {
+            irq_add_shared_handler(UART1_IRQ, OnIrq, PICO_SHARED_IRQ_HANDLER_HIGHEST_ORDER_PRIORITY);
+
+            irqCounterMode_ = IrqCounterMode::SHARED;
+        }
+        else
+        {
+            irq_handler_t handler = irq_get_exclusive_handler(UART1_IRQ);
+            if (handler && handler != OnIrqThenDriver)
+            {
+                fnIrqHandlerDriver_ = handler;
+
+                irq_remove_handler(UART1_IRQ, handler);
+                irq_set_exclusive_handler(UART1_IRQ, OnIrqThenDriver);
+
+                irqCounterMode_ = IrqCounterMode::WRAPPED;
+            }
+        }
+    }
+
+    // Runs ahead of the driver's handler, so the FIFO hasn't been drained
+    // yet, and the level interrupt is still raised if that is what fired.
+    static void OnIrq()
+    {
+        uint64_t timeNowUs = time_us_64();
+
+        bool atLevel = uart_get_hw(uart1)->mis & UART_UARTMIS_RXMIS_BITS;
+
+        irqStats_.OnIrq(timeNowUs, atLevel ? RX_FIFO_LEVEL_7_8_BYTES : 0);
+    }
+
+    static void OnIrqThenDriver()
+    {
+        OnIrq();
+
+        fnIrqHandlerDriver_();
+    }
+
+
+private:
+
+    // PL011 IFLS encoding: 0=1/8, 1=1/4, 2=1/2, 3=3/4, 4=7/8
+    inline static const uint32_t RX_FIFO_LEVEL_7_8       = 4;
+    inline static const uint32_t RX_FIFO_LEVEL_7_8_BYTES = 28;
+
+    enum class IrqCounterMode : uint8_t
+    {
+        NONE,
+        SHARED,
+        WRAPPED,
+    };
+
+    inline static bool           applied_            = false;
+    inline static UartRxBurst    burst_;
+    inline static UartRxIrqStats irqStats_;
+    inline static IrqCounterMode irqCounterMode_     = IrqCounterMode::NONE;
+    inline static irq_handler_t  fnIrqHandlerDriver_ = nullptr;
+
+    inline static uint32_t burstStartFromIrqCount_  = 0;
+    inline static uint32_t burstStartFromLineCount_ = 0;
+};
\ No newline at end of file
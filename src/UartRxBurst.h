@@ -0,0 +1,210 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+using namespace std;
+
+
+// Finds when each NMEA burst began, from the lines the burst is made of.
+//
+// The GPS sends a burst of lines once per second, and is otherwise silent.
+// A line completing after a gap longer than any inside a burst is the
+// first line of a new burst.
+//
+// By the time the first line has completed, all of its bytes (and its line
+// ending) have arrived, so the burst start is that many byte times earlier.
+//
+// Kept free of hardware so it can be run on the host.
+class UartRxBurst
+{
+public:
+
+    // bursts are 1 second apart, lines within a burst ms apart at 9600
+    inline static const uint64_t BURST_GAP_US = 200'000;
+
+    // "\r\n", not passed along with the line
+    inline static const uint32_t LINE_ENDING_LEN = 2;
+
+    void SetByteDurationUs(uint32_t byteDurationUs)
+    {
+        byteDurationUs_ = byteDurationUs;
+    }
+
+    uint32_t GetByteDurationUs()
+    {
+        return byteDurationUs_;
+    }
+
+    // call as each line completes, lineLen excludes the line ending
+    void OnLine(uint64_t timeNowUs, uint32_t lineLen)
+    {
+        if (lineCount_ == 0 || timeNowUs - timeAtLastLineUs_ >= BURST_GAP_US)
+        {
+            uint64_t backUs = (uint64_t)(lineLen + LINE_ENDING_LEN) * byteDurationUs_;
+
+            timeAtBurstStartUs_ = timeNowUs - min(backUs, timeNowUs);
+            ++burstCount_;
+        }
+        timeAtLastLineUs_ = timeNowUs;
+
+        ++lineCount_;
+    }
+
+    // time the first byte of the most recent burst arrived, 0 if none yet
+    uint64_t GetTimeAtBurstStartUs()
+    {
+        return timeAtBurstStartUs_;
+    }
+
+    // Time the burst began which holds the line completed at timeAtLineUs,
+    // 0 if not known.
+    //
+    // Other line stream callbacks may see a line before it is passed here.
+    // A line opening a burst not seen yet only has its own time to go on.
+    uint64_t GetTimeAtBurstStartUs(uint64_t timeAtLineUs)
+    {
+        uint64_t retVal = 0;
+
+        if (lineCount_ == 0 || timeAtLineUs < timeAtBurstStartUs_)
+        {
+            retVal = 0;
+        }
+        else if (timeAtLineUs <= timeAtLastLineUs_ || timeAtLineUs - timeAtLastLineUs_ < BURST_GAP_US)
+        {
+            retVal = timeAtBurstStartUs_;
+        }
+        else
+        {
+            retVal = timeAtLineUs;
+        }
+
+        return retVal;
+    }
+
+    uint32_t GetBurstCount()
+    {
+        return burstCount_;
+    }
+
+    uint32_t GetLineCount()
+    {
+        return lineCount_;
+    }
+
+
+private:
+
+    uint32_t byteDurationUs_     = 0;
+    uint64_t timeAtLastLineUs_   = 0;
+    uint64_t timeAtBurstStartUs_ = 0;
+    uint32_t burstCount_         = 0;
+    uint32_t lineCount_          = 0;
+};
+
+
+// Counts receive interrupts, and the bursts they come in, to see how well
+// receive is batched. Each interrupt is a core wake while the GPS is on.
+//
+// Also notes when each burst began, as seen from the interrupt rather than
+// from a completed line, so it is known before any line of the burst is
+// handed out. The first interrupt of a burst is a FIFO level interrupt
+// when the first line is longer than the level, which NMEA lines are, so
+// the burst began that many byte times before it. A burst which only
+// raised the receive timeout is too short to say.
+//
+// Called from the interrupt handler, so does little more than count.
+class UartRxIrqStats
+{
+public:
+
+    void SetByteDurationUs(uint32_t byteDurationUs)
+    {
+        byteDurationUs_ = byteDurationUs;
+    }
+
+    // bytesInFifo is the FIFO level if the interrupt was raised by it, 0 if
+    // not (receive timeout)
+    void OnIrq(uint64_t timeNowUs, uint32_t bytesInFifo)
+    {
+        if (irqCount_ == 0 || timeNowUs - timeAtLastIrqUs_ >= UartRxBurst::BURST_GAP_US)
+        {
+            burstPrev_ = burst_;
+            burst_     = { .timeAtIrqUs = timeNowUs, .timeAtStartUs = 0 };
+
+            if (bytesInFifo && byteDurationUs_)
+            {
+                uint64_t backUs = (uint64_t)bytesInFifo * byteDurationUs_;
+
+                burst_.timeAtStartUs = timeNowUs - min(backUs, timeNowUs);
+            }
+
+            ++burstCount_;
+        }
+        timeAtLastIrqUs_ = timeNowUs;
+
+        ++irqCount_;
+    }
+
+    // Time the burst began which holds the line completed at timeAtLineUs,
+    // 0 if not known.
+    //
+    // The most recent burst to have begun before the line, if the line
+    // could still be part of it. The one before is kept as well, should
+    // the next burst have begun by the time this is asked. A burst whose
+    // start isn't known gives 0, rather than the burst before it.
+    uint64_t GetTimeAtBurstStartUs(uint64_t timeAtLineUs) const
+    {
+        uint64_t retVal = 0;
+
+        for (const Burst &burst : { burst_, burstPrev_ })
+        {
+            if (burst.timeAtIrqUs && burst.timeAtIrqUs <= timeAtLineUs)
+            {
+                if (timeAtLineUs - burst.timeAtIrqUs < BURST_SPAN_MAX_US)
+                {
+                    retVal = burst.timeAtStartUs;
+                }
+
+                break;
+            }
+        }
+
+        return retVal;
+    }
+
+    uint32_t GetIrqCount() const
+    {
+        return irqCount_;
+    }
+
+    uint32_t GetBurstCount() const
+    {
+        return burstCount_;
+    }
+
+    // x10, to see fractions of an interrupt, 0 if no bursts
+    uint32_t GetIrqsPerBurstX10() const
+    {
+        return burstCount_ ? irqCount_ * 10 / burstCount_ : 0;
+    }
+
+
+private:
+
+    // bursts are a second apart, so no line belongs to one older than that
+    inline static const uint64_t BURST_SPAN_MAX_US = 1'000'000;
+
+    struct Burst
+    {
+        uint64_t timeAtIrqUs   = 0;
+        uint64_t timeAtStartUs = 0;
+    };
+
+    uint32_t byteDurationUs_  = 0;
+    uint64_t timeAtLastIrqUs_ = 0;
+    Burst    burst_;
+    Burst    burstPrev_;
+    uint32_t irqCount_        = 0;
+    uint32_t burstCount_      = 0;
+};
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "HostTest.h"
+#include "CasicAidIni.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+template <typename T>
+static T Get(const vector<uint8_t> &buf, size_t offset)
+{
+    T val;
+    memcpy(&val, &buf[offset], sizeof(T));
+    return val;
+}
+
+
+// Checks the AID-INI frame against the CASIC layout, with the week and
+// time of week worked out by hand.
+int main()
+{
+    HostTest t;
+
+    // 2024-06-01T00:00:00Z, unix 1717200000
+    // gps sec = 1717200000 - 315964800 + 18 = 1401235218
+    // week    = 1401235218 / 604800 = 2316 (rem 518,418)
+    uint64_t unixUs = 1'717'200'000ULL * 1'000'000 + 250'000;
+
+    CasicAidIni::WeekTow wt = CasicAidIni::GetWeekTow(unixUs);
+    t.Check(wt.week == 2316,                                    "week");
+    t.Check(wt.tow > 518'418.249 && wt.tow < 518'418.251,       "tow, with fraction");
+
+    // the gps epoch itself, less leap seconds
+    wt = CasicAidIni::GetWeekTow(315'964'800ULL * 1'000'000);
+    t.Check(wt.week == 0 && wt.tow > 17.999 && wt.tow < 18.001, "gps epoch");
+
+    CasicAidIni::Input in = {
+        .posValid  = true,
+        .latDeg    = 40.7,
+        .lngDeg    = -74.0,
+        .altM      = 12'000,
+        .pAccM     = 10'000,
+        .timeValid = true,
+        .unixUs    = unixUs,
+        .tAccSec   = 2,
+    };
+
+    vector<uint8_t> payload = CasicAidIni::MakePayload(in);
+    t.Check(payload.size() == CasicAidIni::PAYLOAD_LEN,  "payload is 56 bytes");
+    t.Check(Get<double>  (payload,  0) == 40.7,           "payload lat");
+    t.Check(Get<double>  (payload,  8) == -74.0,          "payload lng");
+    t.Check(Get<double>  (payload, 16) == 12'000,         "payload alt");
+    t.Check(Get<double>  (payload, 24) == CasicAidIni::GetWeekTow(unixUs).tow, "payload tow");
+    t.Check(Get<float>   (payload, 36) == 10'000,         "payload pos accuracy");
+    t.Check(Get<float>   (payload, 40) == 2,              "payload time accuracy");
+    t.Check(Get<uint16_t>(payload, 52) == 2316,           "payload week");
+    t.Check(payload[55] == 0x23,                          "payload flags, pos+time+lla");
+
+    vector<uint8_t> frame = CasicAidIni::MakeFrame(in);
+    t.Check(frame.size() == 6 + 56 + 4,                   "frame length");
+    t.Check(frame[0] == 0xBA && frame[1] == 0xCE,         "frame header");
+    t.Check(Get<uint16_t>(frame, 2) == 56,                "frame len field");
+    t.Check(frame[4] == 0x0B && frame[5] == 0x01,         "frame class, id");
+    t.Check(memcmp(&frame[6], payload.data(), 56) == 0,   "frame carries payload");
+
+    uint32_t ckSum = (0x01u << 24) + (0x0Bu << 16) + 56;
+    for (size_t i = 0; i < 56; i += 4)
+    {
+        ckSum += Get<uint32_t>(payload, i);
+    }
+    t.Check(Get<uint32_t>(frame, 62) == ckSum,            "frame checksum");
+
+    // a known frame, all-zero payload, worked out by hand
+    vector<uint8_t> frameZero = CasicAidIni::MakeCasicFrame(0x0B, 0x01, vector<uint8_t>(8, 0));
+    t.Check(frameZero == vector<uint8_t>{ 0xBA, 0xCE, 0x08, 0x00, 0x0B, 0x01,
+                                          0, 0, 0, 0, 0, 0, 0, 0,
+                                          0x08, 0x00, 0x0B, 0x01 },
+                                                          "known frame");
+
+    // position only, time not known
+    in.timeValid = false;
+    payload = CasicAidIni::MakePayload(in);
+    t.Check(Get<uint16_t>(payload, 52) == 0 && Get<double>(payload, 24) == 0,
+                                                          "no time, week and tow zero");
+    t.Check(payload[55] == 0x21,                          "no time, flags pos+lla");
+
+    return t.Done();
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "HostTest.h"
+#include "CopilotControlRecording.h"
+
+using Type     = CopilotControlRecording::Type;
+using Record   = CopilotControlRecording::Record;
+using DateTime = CopilotControlRecording::DateTime;
+
+
+int main()
+{
+    HostTest t;
+
+    // a gps time record as the device sends it, 2025-01-01 12:10:00.500
+    const string HEX_GPS_TIME = "08070605040302010300f40180c24268";
+
+    DateTime dt = { .year = 2025, .month = 1, .day = 1, .hour = 12, .minute = 10, .second = 0 };
+
+    Record recGpsTime = {
+        .timeUs = 0x0102030405060708,
+        .type   = Type::GPS_TIME,
+        .arg    = 0,
+        .ms     = 500,
+        .value  = CopilotControlRecording::PackDateTime(dt),
+    };
+
+    t.Check(CopilotControlRecording::MakeHex({ recGpsTime }) == HEX_GPS_TIME, "record sent as little endian hex");
+
+    vector<Record> recordList;
+    t.Check(CopilotControlRecording::ParseHex(HEX_GPS_TIME, recordList), "sent record parses");
+    t.Check(recordList.size() == 1, "one record parsed");
+
+    DateTime dtParsed = CopilotControlRecording::UnpackDateTime(recordList[0].value);
+    t.Check(recordList[0].timeUs == recGpsTime.timeUs && recordList[0].type == Type::GPS_TIME && recordList[0].ms == 500, "record fields survive");
+    t.Check(dtParsed.year == 2025 && dtParsed.month == 1 && dtParsed.day == 1 &&
+            dtParsed.hour == 12 && dtParsed.minute == 10 && dtParsed.second == 0, "date and time survive");
+
+    t.Check(CopilotControlRecording::UnpackDateTime(CopilotControlRecording::PackDateTime({ .hour = 23, .minute = 59, .second = 59 })).year == 0, "no date stays no date");
+
+    // types are stored by value, so new ones only ever go on the end
+    t.Check((uint8_t)Type::WARMUP == 8 && (uint8_t)Type::RESTART == 9, "type values kept across versions");
+    t.Check(string{CopilotControlRecording::GetTypeName(Type::RESTART)} == "RESTART", "restart named");
+
+    vector<Record> recordListBad;
+    t.Check(CopilotControlRecording::ParseHex(HEX_GPS_TIME.substr(2), recordListBad) == false, "partial record refused");
+    t.Check(CopilotControlRecording::ParseHex(string(31, '0') + "x", recordListBad) == false, "non-hex refused");
+    t.Check(recordListBad.empty(), "refused hex adds nothing");
+
+    // a recording of two segments, received newest first, as the ring
+    // wrapped, and one which was cut short
+    string hexSeg7 = CopilotControlRecording::MakeHex({
+        { .timeUs = 1'000, .type = Type::START, .value = 2 },
+        { .timeUs = 2'000, .type = Type::CLOCK, .arg = 1 },
+    });
+    string hexSeg8 = CopilotControlRecording::MakeHex({
+        { .timeUs = 3'000, .type = Type::VCC,       .value = 3'300 },
+        { .timeUs = 4'000, .type = Type::JS_RESULT, .arg = 3, .ms = 120, .value = 1 },
+        { .timeUs = 5'000, .type = Type::STOP },
+    });
+
+    vector<Record> replayList = CopilotControlRecording::MakeRecordList({
+        { 8, hexSeg8 },
+        { 9, "0011" },
+        { 7, hexSeg7 },
+    });
+
+    vector<Type> typeList;
+    for (const auto &rec : replayList) { typeList.push_back(rec.type); }
+
+    t.Check(typeList == vector<Type>{ Type::START, Type::CLOCK, Type::VCC, Type::JS_RESULT, Type::STOP }, "segments put in sequence order, broken one left out");
+    t.Check(replayList[3].arg == 3 && replayList[3].ms == 120 && replayList[3].value == 1, "js result fields survive");
+    t.Check(string{CopilotControlRecording::GetTypeName(replayList[2].type)} == "VCC", "type named");
+
+    return t.Done();
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#include "HostTest.h"
+#include "CopilotControlTraceFormat.h"
+
+#include <string>
+#include <vector>
+using namespace std;
+
+using Format = CopilotControlTraceFormat;
+
+
+int main()
+{
+    HostTest t;
+
+    // _START and _END pair up as one async span, named without the suffix
+    string b = Format::MakeMark(1'000, "PERIOD1_START");
+    string e = Format::MakeMark(5'000, "PERIOD1_END");
+    t.Check(b == R"({"name":"PERIOD1","ph":"b","ts":1000,"pid":1,"cat":"cc","id":"PERIOD1"})", "_START is a span begin");
+    t.Check(e == R"({"name":"PERIOD1","ph":"e","ts":5000,"pid":1,"cat":"cc","id":"PERIOD1"})", "_END is the matching span end");
+
+    // any other mark is an instant, a bare suffix is not a span
+    t.Check(Format::MakeMark(7, "TX_REWARMUP") == R"({"name":"TX_REWARMUP","ph":"i","ts":7,"pid":1,"tid":1,"s":"p"})", "mark is an instant");
+    t.Check(Format::MakeMark(7, "_END").find(R"("ph":"i")") != string::npos,     "bare suffix is an instant");
+    t.Check(Format::MakeMark(7, "SEND_END_X").find(R"("ph":"i")") != string::npos, "suffix must end the name");
+
+    // spans and counters
+    t.Check(Format::MakeSpan(2'000, 300, "JS_SLOT2") == R"({"name":"JS_SLOT2","ph":"X","ts":2000,"pid":1,"tid":1,"dur":300})", "span is a complete event");
+    t.Check(Format::MakeCounter(9, "radio", 1) == R"({"name":"radio","ph":"C","ts":9,"pid":1,"args":{"value":1}})", "counter is a counter track");
+
+    // document shape
+    const string HEAD = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+                        "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"CopilotControl\"}}";
+    t.Check(Format::MakeDocument({}) == HEAD + "\n]}", "empty document has only the process name");
+    t.Check(Format::MakeDocument({ "A", "B" }) == HEAD + ",\nA,\nB\n]}", "events one per line, comma separated");
+
+    // from a simulator timeline, shifted by the lead, negatives held at 0
+    string doc = Format::MakeDocumentFromTimeline("-3000:RADIO_IDLE_GAP_START -500:RADIO_IDLE_GAP_END noColon 0:TX_REWARMUP", 1'000);
+    string want = HEAD + ",\n" +
+        R"({"name":"RADIO_IDLE_GAP","ph":"b","ts":0,"pid":1,"cat":"cc","id":"RADIO_IDLE_GAP"})" + ",\n" +
+        R"({"name":"RADIO_IDLE_GAP","ph":"e","ts":500000,"pid":1,"cat":"cc","id":"RADIO_IDLE_GAP"})" + ",\n" +
+        R"({"name":"TX_REWARMUP","ph":"i","ts":1000000,"pid":1,"tid":1,"s":"p"})" + "\n]}";
+    t.Check(doc == want, "timeline document");
+    t.Check(Format::MakeDocumentFromTimeline("", 0) == HEAD + "\n]}",        "empty timeline");
+    t.Check(Format::MakeDocumentFromTimeline("5:A  6:B ", 0) == Format::MakeDocument({ Format::MakeMark(5'000, "A"), Format::MakeMark(6'000, "B") }), "extra spaces skipped");
+
+    return t.Done();
+}
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include "CopilotControlWindowPlan.h"
+#include "HostTest.h"
+
+#include <string>
+using namespace std;
+
+using WindowPlan = CopilotControlWindowPlan;
+using Action     = WindowPlan::Action;
+using Entry      = WindowPlan::Entry;
+using Input      = WindowPlan::Input;
+
+
+// Calculates plans for fixed inputs and compares them against known-good
+// plans.
+int main()
+{
+    HostTest t;
+
+    struct TestCase
+    {
+        string        name;
+        Input         in;
+        vector<Entry> expectedList;
+    };
+
+    const uint64_t SEC = 1'000'000;
+
+    auto MakeInput = [&](uint64_t timeNowUs, vector<uint8_t> periodTxList, bool testing, uint8_t periodFirst = 1){
+        Input in;
+        in.timeNowUs            = timeNowUs;
+        in.timeAtWindowStartUs  = 600 * SEC;
+        in.durationWantWarmupUs =  20 * SEC;
+        in.durationJsUs         =   6 * SEC;
+        in.periodFirst          = periodFirst;
+        in.testing              = testing;
+        for (auto period : periodTxList)
+        {
+            in.periodWillTransmit[period] = true;
+        }
+        return in;
+    };
+
+    vector<TestCase> testCaseList = {
+        {
+            .name = "flight, tx in 1 3 5, idle gaps between",
+            .in   = MakeInput(0, { 1, 3, 5 }, false),
+            .expectedList = {
+                {  580 * SEC, Action::TX_WARMUP,               0 },
+                {  594 * SEC, Action::SCHEDULE_LOCK_OUT_START, 0 },
+                {  594 * SEC, Action::PERIOD_START,            0 },
+                {  600 * SEC, Action::PERIOD_START,            1 },
+                {  600 * SEC, Action::RADIO_IDLE_GAP_START,    1 },
+                {  720 * SEC, Action::PERIOD_START,            2 },
+                {  820 * SEC, Action::TX_REWARMUP,             3 },
+                {  840 * SEC, Action::PERIOD_START,            3 },
+                {  840 * SEC, Action::RADIO_IDLE_GAP_START,    3 },
+                {  960 * SEC, Action::PERIOD_START,            4 },
+                { 1060 * SEC, Action::TX_REWARMUP,             5 },
+                { 1080 * SEC, Action::PERIOD_START,            5 },
+                { 1080 * SEC, Action::TX_DISABLE_GPS_ENABLE,   0 },
+                { 1080 * SEC, Action::SCHEDULE_LOCK_OUT_END,   0 },
+            },
+        },
+        {
+            .name = "flight, short notice, warmup and js squeezed",
+            .in   = MakeInput(596 * SEC, { 1, 2 }, false),
+            .expectedList = {
+                {  596 * SEC, Action::TX_WARMUP,               0 },
+                {  596 * SEC, Action::SCHEDULE_LOCK_OUT_START, 0 },
+                {  596 * SEC, Action::PERIOD_START,            0 },
+                {  600 * SEC, Action::PERIOD_START,            1 },
+                {  720 * SEC, Action::PERIOD_START,            2 },
+                {  720 * SEC, Action::TX_DISABLE_GPS_ENABLE,   0 },
+                {  840 * SEC, Action::PERIOD_START,            3 },
+                {  960 * SEC, Action::PERIOD_START,            4 },
+                { 1080 * SEC, Action::PERIOD_START,            5 },
+                { 1080 * SEC, Action::SCHEDULE_LOCK_OUT_END,   0 },
+            },
+        },
+        {
+            .name = "flight, joined at period 3, tx in 2 3 5",
+            .in   = MakeInput(700 * SEC, { 2, 3, 5 }, false, 3),
+            .expectedList = {
+                {  820 * SEC, Action::TX_WARMUP,               0 },
+                {  834 * SEC, Action::SCHEDULE_LOCK_OUT_START, 0 },
+                {  834 * SEC, Action::PERIOD_START,            0 },
+                {  840 * SEC, Action::PERIOD_START,            3 },
+                {  840 * SEC, Action::RADIO_IDLE_GAP_START,    3 },
+                {  960 * SEC, Action::PERIOD_START,            4 },
+                { 1060 * SEC, Action::TX_REWARMUP,             5 },
+                { 1080 * SEC, Action::PERIOD_START,            5 },
+                { 1080 * SEC, Action::TX_DISABLE_GPS_ENABLE,   0 },
+                { 1080 * SEC, Action::SCHEDULE_LOCK_OUT_END,   0 },
+            },
+        },
+        {
+            .name = "testing, no tx, gps at window start",
+            .in   = MakeInput(0, {}, true),
+            .expectedList = {
+                {  600 * SEC,     Action::SCHEDULE_LOCK_OUT_START, 0 },
+                {  600 * SEC,     Action::TX_DISABLE_GPS_ENABLE,   0 },
+                {  600 * SEC,     Action::PERIOD_START,            0 },
+                {  600 * SEC,     Action::PERIOD_START,            1 },
+                {  600 * SEC + 1, Action::PERIOD_START,            2 },
+                {  600 * SEC + 2, Action::PERIOD_START,            3 },
+                {  600 * SEC + 3, Action::PERIOD_START,            4 },
+                {  600 * SEC + 4, Action::PERIOD_START,            5 },
+                {  600 * SEC + 4, Action::SCHEDULE_LOCK_OUT_END,   0 },
+            },
+        },
+    };
+
+    for (const auto &tc : testCaseList)
+    {
+        vector<Entry> actualList = WindowPlan::Calculate(tc.in).entryList;
+
+        if (t.Check(actualList == tc.expectedList, tc.name) == false)
+        {
+            printf("- expected:\n");
+            for (const auto &entry : tc.expectedList) { printf("  %llu %s\n", (unsigned long long)entry.timeAtUs, WindowPlan::GetActionName(entry.action, entry.slot)); }
+            printf("- actual  :\n");
+            for (const auto &entry : actualList) { printf("  %llu %s\n", (unsigned long long)entry.timeAtUs, WindowPlan::GetActionName(entry.action, entry.slot)); }
+        }
+    }
+
+    // joining, next window at 1200 sec, needing 26 sec of lead
+    struct JoinTestCase
+    {
+        uint64_t timeNowUs;
+        uint8_t  periodFirstExpected;
+    };
+
+    vector<JoinTestCase> joinTestCaseList = {
+        {  600 * SEC + 1, 2 },  // just after window start
+        {  694 * SEC,     2 },  // period 2 just met
+        {  695 * SEC,     3 },  // period 2 just missed
+        { 1054 * SEC,     5 },  // period 5 just met
+        { 1055 * SEC,     0 },  // nothing left, wait for next window
+        { 1190 * SEC,     0 },
+    };
+
+    for (const auto &tc : joinTestCaseList)
+    {
+        uint8_t periodFirst = WindowPlan::CalculatePeriodFirstJoinable(tc.timeNowUs, 1200 * SEC, 26 * SEC);
+
+        string name = "join at " + to_string(tc.timeNowUs / SEC) + " sec, period " + to_string(periodFirst);
+
+        if (t.Check(periodFirst == tc.periodFirstExpected, name) == false)
+        {
+            printf("- expected: period %d\n", (int)tc.periodFirstExpected);
+        }
+    }
+
+    return t.Done();
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+using namespace std;
+
+
+// Reports results the way the on-device self tests do, and gives the exit
+// code ctest goes by.
+class HostTest
+{
+public:
+
+    bool Check(bool ok, const string &name)
+    {
+        printf("%s: %s\n", ok ? "OK " : "ERR", name.c_str());
+
+        ok_ &= ok;
+
+        return ok;
+    }
+
+    int Done()
+    {
+        printf("=== Tests %sok ===\n", ok_ ? "" : "NOT ");
+
+        return ok_ ? 0 : 1;
+    }
+
+
+private:
+
+    bool ok_ = true;
+};
\ No newline at end of file
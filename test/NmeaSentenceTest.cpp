@@ -0,0 +1,83 @@
+#include "HostTest.h"
+#include "NmeaSentence.h"
+
+#include <string>
+using namespace std;
+
+
+int main()
+{
+    HostTest t;
+
+    // tokenizing
+    string gga = "$GNGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*59";
+    {
+        NmeaSentenceView view(gga);
+        t.Check(view.IsValid(),                      "gga valid");
+        t.Check(view.GetTalker() == "GN",            "gga talker");
+        t.Check(view.GetType() == "GGA",             "gga type");
+        t.Check(view.GetFieldInt(7) == 8,            "gga sats");
+        t.Check(view.GetFieldX100(8) == 90,          "gga hdop x100");
+        t.Check(view.GetField(14).empty(),           "gga empty field");
+        t.Check(view.GetLine().data() == gga.data(), "view refers to the line, no copy");
+    }
+    t.Check(NmeaSentenceView(gga + "\r\n").IsValid(),                            "line ending tolerated");
+    t.Check(NmeaSentenceView(string{gga}.replace(gga.size() - 2, 2, "00")).IsValid() == false, "bad checksum");
+    t.Check(NmeaSentenceView("GNGGA,1*00").IsValid() == false,                   "no $");
+
+    // address off the raw line
+    t.Check(NmeaSentenceView::GetAddressFromLine(gga) == "GNGGA",     "address");
+    t.Check(NmeaSentenceView::GetAddressFromLine("$GNGGA").empty(),   "address, short line");
+    t.Check(NmeaSentenceView::GetAddressFromLine("$PCAS03,1").empty(), "address, not 5 chars");
+
+    // filter
+    {
+        NmeaSentenceFilter filter;
+        string err;
+
+        t.Check(filter.Passes("GNGSV"),              "empty filter passes all");
+
+        t.Check(filter.Set("GGA,GPRMC", err),        "filter set");
+        t.Check(filter.Passes("GNGGA"),              "type, any talker");
+        t.Check(filter.Passes("GPGGA"),              "type, other talker");
+        t.Check(filter.Passes("GPRMC"),              "talker and type");
+        t.Check(filter.Passes("GNRMC") == false,     "talker and type, other talker");
+        t.Check(filter.Passes("GNGSV") == false,     "not listed");
+        t.Check(filter.Passes("") == false,          "no address");
+        t.Check(filter.ToString() == "GGA,GPRMC",    "filter to string");
+
+        t.Check(filter.Set("GGA,GSVX", err) == false, "bad entry refused");
+        t.Check(filter.Passes("GNGSV"),              "refused set leaves filter passing all");
+
+        t.Check(filter.Set("all", err) && filter.ToString() == "all", "all");
+        t.Check(filter.Set("A01,A02,A03,A04,A05,A06,A07,A08,A09", err) == false, "too many entries");
+    }
+
+    // cost
+    {
+        NmeaSentenceCost cost;
+        cost.Record("GGA", 100);
+        cost.Record("GGA", 300);
+        cost.Record("RMC", 50);
+
+        t.Check(cost.GetEntryCount() == 2,                         "cost types");
+        t.Check(string{cost.GetEntry(0).type} == "GGA",            "cost type name");
+        t.Check(cost.GetEntry(0).count == 2,                       "cost count");
+        t.Check(cost.GetEntry(0).totalUs == 400,                   "cost total");
+        t.Check(cost.GetEntry(0).maxUs == 300,                     "cost max");
+
+        for (int i = 0; i < 20; ++i)
+        {
+            string type = to_string(100 + i);
+            cost.Record(type, 1);
+        }
+        t.Check(cost.GetEntryCount() == NmeaSentenceCost::MAX_TYPES, "cost table full");
+        const NmeaSentenceCost::Entry &rest = cost.GetEntry(NmeaSentenceCost::MAX_TYPES - 1);
+        t.Check(string{rest.type} == "..." && rest.count == 7,     "cost overflow counted together");
+
+        cost.Reset();
+        t.Check(cost.GetEntryCount() == 0,                         "cost reset");
+    }
+
+    return t.Done();
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "HostTest.h"
+#include "TxBrownoutGuard.h"
+
+#include <string>
+#include <vector>
+using namespace std;
+
+using Action = TxBrownoutGuard::Action;
+
+
+// Runs synthetic traces through the decision logic, checking each produced
+// the expected steps.
+//
+// A trace is the supply as it would be at full output power. Each step
+// taken lightens the load, which the trace is raised by from then on.
+int main()
+{
+    HostTest t;
+
+    struct TestCase
+    {
+        string           name;
+        bool             clk1Enabled;
+        vector<uint16_t> traceMv;
+        uint16_t         reliefMvPerStep;
+        vector<Action>   expectedList;
+    };
+
+    auto MakeRamp = [](uint16_t mvStart, uint16_t mvEnd, uint16_t count){
+        vector<uint16_t> retVal;
+        for (uint16_t i = 0; i < count; ++i)
+        {
+            retVal.push_back((uint16_t)(mvStart + ((int32_t)mvEnd - mvStart) * i / (count - 1)));
+        }
+        return retVal;
+    };
+
+    auto Concat = [](vector<uint16_t> a, const vector<uint16_t> &b){
+        a.insert(a.end(), b.begin(), b.end());
+        return a;
+    };
+
+    // +/- 40mV symbol to symbol
+    auto MakeNoisy = [](uint16_t mv, uint16_t count){
+        vector<uint16_t> retVal;
+        for (uint16_t i = 0; i < count; ++i)
+        {
+            retVal.push_back((uint16_t)(mv + (i % 2 ? 40 : -40)));
+        }
+        return retVal;
+    };
+
+    vector<TestCase> testCaseList = {
+        {
+            .name            = "steady supply",
+            .clk1Enabled     = true,
+            .traceMv         = vector<uint16_t>(162, 3'300),
+            .reliefMvPerStep = 0,
+            .expectedList    = {},
+        },
+        {
+            .name            = "noisy but clear of margin",
+            .clk1Enabled     = true,
+            .traceMv         = MakeNoisy(3'000, 162),
+            .reliefMvPerStep = 0,
+            .expectedList    = {},
+        },
+        {
+            .name            = "slow sag, clk1 dropped before drive",
+            .clk1Enabled     = true,
+            .traceMv         = Concat(MakeRamp(3'300, 2'780, 60), vector<uint16_t>(102, 2'780)),
+            .reliefMvPerStep = 60,
+            .expectedList    = { Action::DROP_CLK1, Action::DROP_DRIVE },
+        },
+        {
+            .name            = "sag with clk1 already off",
+            .clk1Enabled     = false,
+            .traceMv         = Concat(MakeRamp(3'300, 2'850, 60), vector<uint16_t>(102, 2'850)),
+            .reliefMvPerStep = 0,
+            .expectedList    = { Action::DROP_DRIVE, Action::DROP_DRIVE, Action::DROP_DRIVE },
+        },
+        {
+            .name            = "sag which recovers after first step",
+            .clk1Enabled     = true,
+            .traceMv         = Concat(MakeRamp(3'300, 2'900, 30), vector<uint16_t>(132, 3'100)),
+            .reliefMvPerStep = 0,
+            .expectedList    = { Action::DROP_CLK1 },
+        },
+        {
+            .name            = "floor reached, no further steps",
+            .clk1Enabled     = false,
+            .traceMv         = vector<uint16_t>(162, 2'600),
+            .reliefMvPerStep = 0,
+            .expectedList    = { Action::DROP_DRIVE, Action::DROP_DRIVE, Action::DROP_DRIVE },
+        },
+    };
+
+    for (const auto &tc : testCaseList)
+    {
+        TxBrownoutGuard guard;
+        guard.Start(tc.clk1Enabled, TxBrownoutGuard::DRIVE_STEP_MAX);
+
+        vector<Action> actualList;
+        for (auto mv : tc.traceMv)
+        {
+            Action action = guard.OnSample(mv + tc.reliefMvPerStep * actualList.size());
+            if (action != Action::NONE)
+            {
+                actualList.push_back(action);
+            }
+        }
+
+        if (t.Check(actualList == tc.expectedList, tc.name) == false)
+        {
+            printf("- expected:");
+            for (auto action : tc.expectedList) { printf(" %s", TxBrownoutGuard::GetActionName(action)); }
+            printf("\n");
+            printf("- actual  :");
+            for (auto action : actualList) { printf(" %s", TxBrownoutGuard::GetActionName(action)); }
+            printf("\n");
+        }
+    }
+
+    return t.Done();
+}
\ No newline at end of file
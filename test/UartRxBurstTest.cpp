@@ -0,0 +1,104 @@
+#include "HostTest.h"
+#include "UartRxBurst.h"
+
+
+int main()
+{
+    HostTest t;
+
+    // 9600 baud, 10 bits per byte
+    const uint32_t BYTE_US = 1'042;
+    const uint64_t SEC     = 1'000'000;
+
+    UartRxBurst burst;
+    burst.SetByteDurationUs(BYTE_US);
+
+    t.Check(burst.GetTimeAtBurstStartUs(5 * SEC) == 0, "nothing known before the first line");
+
+    // a burst of lines 80ms apart, the first 70 chars
+    burst.OnLine(10 * SEC, 70);
+    for (uint64_t i = 1; i <= 8; ++i)
+    {
+        burst.OnLine(10 * SEC + i * 80'000, 60);
+    }
+
+    const uint64_t TIME_AT_BURST1_START_US = 10 * SEC - 72 * BYTE_US;
+
+    t.Check(burst.GetBurstCount() == 1, "lines close together are one burst");
+    t.Check(burst.GetLineCount() == 9, "every line counted");
+    t.Check(burst.GetTimeAtBurstStartUs() == TIME_AT_BURST1_START_US, "burst start moved back by the first line and its ending");
+    t.Check(burst.GetTimeAtBurstStartUs(10 * SEC + 400'000) == TIME_AT_BURST1_START_US, "line inside the burst maps to its start");
+    t.Check(burst.GetTimeAtBurstStartUs(10 * SEC + 640'000 + 150'000) == TIME_AT_BURST1_START_US, "line not yet seen, within the gap, is the same burst");
+    t.Check(burst.GetTimeAtBurstStartUs(11 * SEC) == 11 * SEC, "line not yet seen, after the gap, opens a new burst");
+    t.Check(burst.GetTimeAtBurstStartUs(9 * SEC) == 0, "line older than the burst is not known");
+
+    // the next second
+    burst.OnLine(11 * SEC, 40);
+    burst.OnLine(11 * SEC + 50'000, 40);
+
+    t.Check(burst.GetBurstCount() == 2, "a gap starts a new burst");
+    t.Check(burst.GetTimeAtBurstStartUs() == 11 * SEC - 42 * BYTE_US, "new burst start taken from its own first line");
+
+    // just under and at the gap
+    burst.OnLine(11 * SEC + 50'000 + UartRxBurst::BURST_GAP_US - 1, 40);
+    t.Check(burst.GetBurstCount() == 2, "just under the gap stays in the burst");
+    burst.OnLine(11 * SEC + 50'000 + UartRxBurst::BURST_GAP_US * 2 - 1, 40);
+    t.Check(burst.GetBurstCount() == 3, "at the gap starts a new burst");
+
+    // baud not known yet, nothing to move back by
+    UartRxBurst burstNoBaud;
+    burstNoBaud.OnLine(3 * SEC, 70);
+    t.Check(burstNoBaud.GetTimeAtBurstStartUs() == 3 * SEC, "unknown byte time leaves the line time");
+
+    // interrupts, FIFO at 7/8 is one per 28 bytes, ~29ms at 9600
+    UartRxIrqStats irqStats;
+    t.Check(irqStats.GetIrqsPerBurstX10() == 0, "no interrupts, no bursts");
+
+    for (uint64_t i = 0; i < 20; ++i)
+    {
+        irqStats.OnIrq(20 * SEC + i * 29'000, 28);
+    }
+    irqStats.OnIrq(20 * SEC + 19 * 29'000 + 3'000, 0);  // receive timeout, tail of the burst
+
+    t.Check(irqStats.GetIrqCount() == 21, "every interrupt counted");
+    t.Check(irqStats.GetBurstCount() == 1, "interrupts close together are one burst");
+
+    for (uint64_t i = 0; i < 10; ++i)
+    {
+        irqStats.OnIrq(21 * SEC + i * 29'000, 28);
+    }
+
+    t.Check(irqStats.GetBurstCount() == 2, "a gap starts a new interrupt burst");
+    t.Check(irqStats.GetIrqsPerBurstX10() == 155, "interrupts per burst, to a tenth");
+
+    // burst start from the interrupt
+    UartRxIrqStats irqTime;
+    t.Check(irqTime.GetTimeAtBurstStartUs(30 * SEC) == 0, "irq, nothing known before the first interrupt");
+
+    irqTime.OnIrq(29 * SEC, 28);
+    t.Check(irqTime.GetTimeAtBurstStartUs(29 * SEC + 100'000) == 0, "irq, unknown byte time gives nothing");
+
+    irqTime.SetByteDurationUs(BYTE_US);
+    irqTime.OnIrq(30 * SEC, 28);
+    irqTime.OnIrq(30 * SEC + 29'000, 28);
+    irqTime.OnIrq(30 * SEC + 58'000, 0);
+
+    const uint64_t TIME_AT_IRQ_BURST_START_US = 30 * SEC - 28 * BYTE_US;
+
+    t.Check(irqTime.GetTimeAtBurstStartUs(30 * SEC + 80'000) == TIME_AT_IRQ_BURST_START_US, "irq, level interrupt moved back by the fifo level");
+    t.Check(irqTime.GetTimeAtBurstStartUs(30 * SEC + 20'000) == TIME_AT_IRQ_BURST_START_US, "irq, known before any line of the burst completes");
+    t.Check(irqTime.GetTimeAtBurstStartUs(TIME_AT_IRQ_BURST_START_US - 1) == 0, "irq, line from before the burst is not known");
+    t.Check(irqTime.GetTimeAtBurstStartUs(30 * SEC + 1'200'000) == 0, "irq, line too long after the burst is not known");
+
+    // next burst already begun when asked about the line before it
+    irqTime.OnIrq(31 * SEC, 28);
+    t.Check(irqTime.GetTimeAtBurstStartUs(30 * SEC + 900'000) == TIME_AT_IRQ_BURST_START_US, "irq, previous burst still known");
+    t.Check(irqTime.GetTimeAtBurstStartUs(31 * SEC + 10'000) == 31 * SEC - 28 * BYTE_US, "irq, latest burst");
+
+    // a burst shorter than the fifo level only raises the timeout
+    irqTime.OnIrq(31 * SEC + 400'000, 0);
+    t.Check(irqTime.GetTimeAtBurstStartUs(31 * SEC + 410'000) == 0, "irq, timeout only burst is not known, nor taken for the one before");
+    t.Check(irqTime.GetBurstCount() == 4, "irq, bursts counted");
+
+    return t.Done();
+}
\ No newline at end of file